@@ -0,0 +1,154 @@
+// GPU particle benchmark and validation (headless, EGL): the exhaust smoke of driving cars
+// simulated by GpuParticles with transform feedback and, step for step, by the CPU reference
+// StepFeedbackParticles. Prints the time per step of both and of drawing the GPU particles
+// once at the end, and how far the GPU states read back then are from the CPU ones.
+//
+// usage: bench_gpu_particles [cars] [particles per car] [frames]
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/shader_m.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "gl_ext.h"
+#include "headless.h"
+#include "particle_feedback.h"
+
+typedef std::chrono::steady_clock Clock;
+
+const GLsizei TARGET_SIZE = 512;
+const float STEP = 1.0f / 60.0f;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Exhaust of every car at frame: rows of cars driving right, wrapping around the target
+static void exhaustPoints(unsigned int cars, GLuint frame, std::vector<glm::vec2> &exhausts)
+{
+    unsigned int perRow = (unsigned int)std::ceil(std::sqrt((float)cars));
+    float spacing = (float)TARGET_SIZE / perRow;
+    exhausts.resize(cars);
+    for (unsigned int i = 0; i < cars; ++i)
+    {
+        float x = std::fmod((i % perRow) * spacing + frame * 0.5f, (float)TARGET_SIZE);
+        exhausts[i] = glm::vec2(x, (i / perRow + 0.75f) * spacing);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int cars = argc > 1 ? (unsigned int)atoi(argv[1]) : 1000;
+    unsigned int perCar = argc > 2 ? (unsigned int)atoi(argv[2]) : 1000;
+    int frames = argc > 3 ? atoi(argv[3]) : 120;
+    cars = cars < 1 ? 1 : cars;
+    perCar = perCar < 1 ? 1 : perCar;
+    frames = frames < 1 ? 1 : frames;
+
+    if (!CreateHeadlessContext())
+        return -1;
+    if (!gladLoadGLLoader((GLADloadproc)HeadlessProcAddress) || !LoadGLExtensions((GLADloadproc)HeadlessProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    OffscreenTarget target;
+    if (!target.Generate(TARGET_SIZE, TARGET_SIZE))
+        return -1;
+    target.Bind();
+    Shader shader("smoke.vs", "smoke.fs");
+    shader.use();
+    shader.setMat4("projection", glm::ortho(0.0f, (float)TARGET_SIZE, (float)TARGET_SIZE, 0.0f, -1.0f, 1.0f));
+    shader.setInt("sprite", 0);
+    // a round sprite instead of a texture file, the smoke shape doesn't matter here
+    const int spriteSize = 32;
+    std::vector<unsigned char> pixels(spriteSize * spriteSize * 4);
+    for (int y = 0; y < spriteSize; ++y)
+        for (int x = 0; x < spriteSize; ++x)
+        {
+            float dx = (x + 0.5f) / spriteSize - 0.5f, dy = (y + 0.5f) / spriteSize - 0.5f;
+            float alpha = std::max(0.0f, 1.0f - 2.0f * std::sqrt(dx * dx + dy * dy));
+            unsigned char *pixel = &pixels[(y * spriteSize + x) * 4];
+            pixel[0] = pixel[1] = pixel[2] = 255;
+            pixel[3] = (unsigned char)(alpha * 255.0f);
+        }
+    GLuint sprite;
+    glGenTextures(1, &sprite);
+    glBindTexture(GL_TEXTURE_2D, sprite);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, spriteSize, spriteSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+
+    GpuParticles gpu;
+    gpu.Forces.Acceleration = glm::vec2(0.0f, -5.0f);
+    gpu.Forces.Drag = 0.5f;
+    gpu.Forces.Growth = 3.0f;
+    gpu.Forces.Fade = 0.15f;
+    gpu.Emission.LifeMin = 0.5f;
+    gpu.Emission.LifeRange = 3.5f;
+    gpu.Emission.Speed = 20.0f;
+    gpu.Emission.Spread = 10.0f;
+    gpu.Emission.Size = 2.0f;
+    gpu.Emission.Color = glm::vec4(0.5f, 0.5f, 0.5f, 0.6f);
+    if (!gpu.Generate(shader.ID, cars, perCar))
+        return -1;
+    std::vector<FeedbackParticle> cpu;
+    InitialFeedbackParticles(cpu, cars, perCar, gpu.Emission.LifeMin);
+
+    std::cout << cars << " cars of " << perCar << " particles, " << frames << " steps of " << STEP << " s" << std::endl;
+    std::vector<glm::vec2> exhausts;
+    double gpuMs = 0.0, cpuMs = 0.0, drawMs = 0.0;
+    for (int f = 0; f < frames; ++f)
+    {
+        exhaustPoints(cars, (GLuint)f, exhausts);
+        glFinish();
+        Clock::time_point start = Clock::now();
+        gpu.SetExhausts(exhausts);
+        gpu.Update(STEP);
+        glFinish();
+        gpuMs += millisecondsSince(start);
+
+        start = Clock::now();
+        StepFeedbackParticles(cpu, exhausts, perCar, gpu.Forces, gpu.Emission, STEP, (GLuint)f);
+        cpuMs += millisecondsSince(start);
+    }
+    // the last step's particles, drawn straight from the buffer transform feedback wrote
+    glClear(GL_COLOR_BUFFER_BIT);
+    glFinish();
+    Clock::time_point start = Clock::now();
+    gpu.Draw();
+    glFinish();
+    drawMs = millisecondsSince(start);
+
+    std::vector<FeedbackParticle> read;
+    gpu.Read(read);
+    float maxDifference = 0.0f;
+    unsigned int differing = 0;
+    for (unsigned int i = 0; i < read.size(); ++i)
+    {
+        const float *a = &read[i].Particle[0], *b = &cpu[i].Particle[0];
+        float difference = 0.0f;
+        for (unsigned int c = 0; c < 12; ++c)
+            difference = std::max(difference, std::fabs(a[c] - b[c]));
+        maxDifference = std::max(maxDifference, difference);
+        differing += difference > 0.0f;
+    }
+    std::cout << "  GPU step " << gpuMs / frames << " ms, CPU reference step " << cpuMs / frames << " ms, GPU draw "
+        << drawMs << " ms" << std::endl;
+    std::cout << "  GPU and CPU states " << (differing == 0 ? "identical" : "differ") << ": " << differing << " of " << read.size()
+        << " particles differ, by at most " << maxDifference << std::endl;
+    std::cout << "  image checksum " << std::hex << target.Checksum() << std::dec << std::endl;
+    DestroyHeadlessContext();
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Level of detail benchmark: triangles submitted for the SUV as the camera backs away,
+// with the levels picked the way StaticModel::SelectLods does (car_with_lighting's
+// model scale 0.02, Camera::Zoom 45 degrees, 600 pixel viewport, 1 pixel error). Also prints,
+// per mesh, the levels built, their triangles and errors (world units) and how far the chain
+// got: the coarsest level relative to the original.
+//
+// usage: bench_lod [model.obj] [pixel error]
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "mesh_processing.h"
+
+typedef std::chrono::steady_clock Clock;
+
+int main(int argc, char **argv)
+{
+    std::string path = argc > 1 ? argv[1] : "resources/objects/SUV_BF3/suv.obj";
+    float pixelError = argc > 2 ? (float)atof(argv[2]) : 1.0f;
+    const float scale = 0.02f, zoom = 45.0f, viewportHeight = 600.0f;
+
+    MeshProcessingOptions options;
+    options.Lods = false;
+    ModelData model;
+    if (!LoadProcessedModel(path, model, options))
+        return 1;
+    Clock::time_point start = Clock::now();
+    unsigned int triangles = 0;
+    for (unsigned int i = 0; i < model.Meshes.size(); ++i)
+    {
+        triangles += (unsigned int)model.Meshes[i].Indices.size() / 3;
+        BuildLods(model.Meshes[i], options.LodLevels, options.LodReduction, options.LodMaxError);
+    }
+    double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::cout << "model:  " << path << " (" << triangles << " triangles)" << std::endl;
+    std::cout << "build:  " << buildMs << " ms for " << options.LodLevels << " levels per mesh" << std::endl;
+    unsigned int coarsest = 0;
+    int precision = (int)std::cout.precision();
+    for (unsigned int i = 0; i < model.Meshes.size(); ++i)
+    {
+        const MeshData &mesh = model.Meshes[i];
+        if (mesh.Lods.empty())
+            continue;
+        unsigned int last = mesh.Lods.back().IndexCount / 3;
+        coarsest += last;
+        std::cout << "  " << mesh.Name << ": " << mesh.Lods.size() << " levels, coarsest "
+            << std::fixed << std::setprecision(1) << 100.0 * last / (mesh.Lods[0].IndexCount / 3) << "%:" << std::defaultfloat << std::setprecision(precision);
+        for (size_t l = 0; l < mesh.Lods.size(); ++l)
+            std::cout << " " << mesh.Lods[l].IndexCount / 3 << " (" << mesh.Lods[l].Error * scale << ")";
+        std::cout << std::endl;
+    }
+    std::cout << "coarsest levels: " << coarsest << " triangles, " << std::fixed << std::setprecision(1)
+        << 100.0 * coarsest / triangles << "% of the model" << std::defaultfloat << std::setprecision(precision) << std::endl;
+    std::cout << std::endl << "distance  triangles  levels" << std::endl;
+    const float distances[] = { 2.0f, 5.0f, 10.0f, 15.0f, 20.0f, 30.0f, 50.0f, 75.0f, 100.0f, 150.0f, 200.0f };
+    for (unsigned int d = 0; d < sizeof(distances) / sizeof(distances[0]); ++d)
+    {
+        unsigned int submitted = 0;
+        std::cout << std::setw(8) << distances[d] << "  ";
+        std::string levels;
+        for (unsigned int i = 0; i < model.Meshes.size(); ++i)
+        {
+            const MeshData &mesh = model.Meshes[i];
+            // distance from the camera to the mesh's bounding sphere, as in SelectLods
+            float distance = distances[d] - mesh.Radius * scale;
+            unsigned int lod = SelectLod(&mesh.Lods[0], (unsigned int)mesh.Lods.size(), distance, scale, zoom, viewportHeight, pixelError);
+            submitted += mesh.Lods[lod].IndexCount / 3;
+            levels += (char)('0' + lod);
+        }
+        std::cout << std::setw(9) << submitted << "  " << levels << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Meshlet culling benchmark: flies the camera around the SUV along the headless path of car_with_lighting
+// (through Camera::GetViewMatrix) and reports how many meshlets and triangles the
+// CPU culling pass rejects per frame, and what the pass costs.
+//
+// usage: bench_meshlets [model.obj] [frames]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/camera.h>
+
+#include "camera_path.h"
+#include "mesh_processing.h"
+#include "meshlet.h"
+
+typedef std::chrono::steady_clock Clock;
+
+int main(int argc, char **argv)
+{
+    std::string path = argc > 1 ? argv[1] : "resources/objects/SUV_BF3/suv.obj";
+    int frames = argc > 2 ? atoi(argv[2]) : 720;
+    if (frames < 1)
+        frames = 1;
+
+    ModelData model;
+    if (!LoadProcessedModel(path, model, MeshProcessingOptions()))
+        return 1;
+    unsigned int meshletCount = 0;
+    for (unsigned int i = 0; i < model.Meshes.size(); ++i)
+        meshletCount += (unsigned int)model.Meshes[i].Meshlets.size();
+
+    // same model transformation and projection as car_with_lighting
+    glm::mat4 transform;
+    transform = glm::translate(transform, glm::vec3(0.0f, -4.0f, -4.0f));
+    transform = glm::scale(transform, glm::vec3(0.02f, 0.02f, 0.02f));
+    glm::vec3 target(0.0f, -4.0f, -4.0f);
+    Camera camera;
+
+    MeshletCullStats total;
+    float minDrawn = 1.0f, maxDrawn = 0.0f;
+    double cullSeconds = 0.0;
+    DrawRanges ranges;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        FollowOrbitPath(camera, target, (float)frame / frames);
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), 800.0f / 600.0f, 0.1f, 100.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+
+        Clock::time_point start = Clock::now();
+        Frustum frustum = ExtractFrustum(projection * view * transform);
+        glm::vec3 cameraPosition = glm::vec3(glm::inverse(view * transform) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        MeshletCullStats stats;
+        for (unsigned int i = 0; i < model.Meshes.size(); ++i)
+        {
+            ranges.Clear();
+            CullMeshlets(model.Meshes[i].Meshlets, frustum, cameraPosition, IndexSizeFor(model.Meshes[i].Vertices.size()), ranges, stats);
+        }
+        cullSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+        float drawn = (float)stats.TrianglesDrawn / stats.Triangles;
+        minDrawn = std::min(minDrawn, drawn);
+        maxDrawn = std::max(maxDrawn, drawn);
+        total.Meshlets += stats.Meshlets;
+        total.BackfaceCulled += stats.BackfaceCulled;
+        total.FrustumCulled += stats.FrustumCulled;
+        total.Triangles += stats.Triangles;
+        total.TrianglesDrawn += stats.TrianglesDrawn;
+        total.Ranges += stats.Ranges;
+    }
+
+    std::cout << "model:           " << path << " (" << meshletCount << " meshlets)" << std::endl;
+    std::cout << "frames:          " << frames << std::endl;
+    std::cout << "per frame:       " << (float)total.BackfaceCulled / frames << " back face culled, " << (float)total.FrustumCulled / frames
+        << " frustum culled of " << total.Meshlets / frames << " meshlets" << std::endl;
+    std::cout << "triangles drawn: " << 100.0f * total.TrianglesDrawn / total.Triangles << "% on average, "
+        << 100.0f * minDrawn << "% .. " << 100.0f * maxDrawn << "%" << std::endl;
+    std::cout << "draw ranges:     " << (float)total.Ranges / frames << " per frame (glMultiDrawElements entries)" << std::endl;
+    std::cout << "culling:         " << cullSeconds * 1e6 / frames << " us per frame" << std::endl;
+    return 0;
+}
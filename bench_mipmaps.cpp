@@ -0,0 +1,141 @@
+// Mip chain generation benchmark: single-threaded throughput of the scalar and SSE2 row
+// filters on the diffuse maps of a model (plus synthetic 2048x2048 images of 1, 3 and 4
+// channels), checking both produce the same chain, then decode + mip generation of all
+// maps on 1..N worker threads as model loading runs it.
+//
+// usage: bench_mipmaps [model.obj] [max threads] [iterations]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "mipmap.h"
+#include "obj_loader.h"
+#include "path_resolver.h"
+#include "texture_loader.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Distinct diffuse maps of model, as spelled on disk
+static std::vector<std::string> diffuseMaps(const ModelData &model, const std::string &directory)
+{
+    PathResolver resolver;
+    std::vector<std::string> paths;
+    for (unsigned int i = 0; i < model.Materials.size(); ++i)
+    {
+        std::string path = directory + '/' + resolver.Resolve(directory, model.Materials[i].DiffuseMap);
+        if (!model.Materials[i].DiffuseMap.empty() && std::find(paths.begin(), paths.end(), path) == paths.end())
+            paths.push_back(path);
+    }
+    return paths;
+}
+
+// Smooth gradients with noise, roughly what a texture looks like to the filter
+static DecodedImage syntheticImage(int size, int components)
+{
+    DecodedImage image = { "synthetic", size, size, components, 1, BLOCK_NONE, false, (unsigned char*)malloc((size_t)size * size * components) };
+    unsigned int seed = 12345;
+    for (size_t i = 0; i < (size_t)size * size * components; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        size_t pixel = i / components;
+        image.Data[i] = (unsigned char)((pixel % size + pixel / size) / 16 + (seed >> 28));
+    }
+    return image;
+}
+
+// Best time of iterations chain generations from a copy of image
+static double timeChain(const DecodedImage &image, bool simd, int iterations, std::vector<unsigned char> &chain)
+{
+    size_t bytes = (size_t)image.Width * image.Height * image.Components;
+    unsigned int levels = MipLevelCount(image.Width, image.Height);
+    double best = 1e30;
+    for (int i = 0; i < iterations; ++i)
+    {
+        unsigned char *data = (unsigned char*)malloc(bytes);
+        memcpy(data, image.Data, bytes);
+        Clock::time_point start = Clock::now();
+        GenerateMipChain(data, image.Width, image.Height, image.Components, levels, true, simd);
+        best = std::min(best, millisecondsSince(start));
+        chain.assign(data, data + MipChainBytes(image.Width, image.Height, image.Components, levels));
+        free(data);
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    std::string path = argc > 1 ? argv[1] : "resources/objects/SUV_BF3/suv.obj";
+    unsigned int maxThreads = argc > 2 ? (unsigned int)atoi(argv[2]) : std::thread::hardware_concurrency();
+    maxThreads = maxThreads ? maxThreads : 1;
+    int iterations = argc > 3 ? atoi(argv[3]) : 3;
+    iterations = iterations < 1 ? 1 : iterations;
+    std::string directory = path.substr(0, path.find_last_of('/'));
+
+    ModelData model;
+    std::vector<std::string> paths;
+    if (LoadObj(path, model))
+        paths = diffuseMaps(model, directory);
+    std::vector<DecodedImage> images;
+    {
+        ThreadPool pool;
+        DecodeImages(paths, images, pool);
+    }
+    std::cout << "model: " << path << " (" << paths.size() << " distinct diffuse maps)" << std::endl;
+    images.push_back(syntheticImage(2048, 1));
+    images.push_back(syntheticImage(2048, 3));
+    images.push_back(syntheticImage(2048, 4));
+
+    // one thread: scalar and SSE2 row filters (sRGB decode and encode included in both)
+    // ---------------------------------------------------------------------------------
+#ifndef __SSE2__
+    std::cout << "built without SSE2, both columns run the scalar filter" << std::endl;
+#endif
+    for (unsigned int i = 0; i < images.size(); ++i)
+    {
+        const DecodedImage &image = images[i];
+        if (!image.Data)
+            continue;
+        std::vector<unsigned char> scalarChain, simdChain;
+        double scalar = timeChain(image, false, iterations, scalarChain);
+        double simd = timeChain(image, true, iterations, simdChain);
+        double megapixels = (double)image.Width * image.Height / 1000000.0;
+        std::cout << "  " << image.Path << " " << image.Width << "x" << image.Height << "x" << image.Components << ": "
+            << MipLevelCount(image.Width, image.Height) << " levels, scalar " << scalar << " ms (" << megapixels / scalar * 1000.0
+            << " Mpixels/s), SSE2 " << simd << " ms (" << megapixels / simd * 1000.0 << " Mpixels/s, " << scalar / simd << "x)"
+            << (scalarChain == simdChain ? "" : ", CHAINS DIFFER") << std::endl;
+    }
+    FreeImages(images);
+
+    // worker pool: decode with and without the chain, as StaticModel loads its maps
+    // -------------------------------------------------------------------------------
+    for (unsigned int threads = 1; threads <= maxThreads && !paths.empty(); ++threads)
+    {
+        ThreadPool pool(threads);
+        double decodeBest = 1e30, mipBest = 1e30;
+        for (int i = 0; i < iterations; ++i)
+        {
+            std::vector<DecodedImage> decoded;
+            Clock::time_point start = Clock::now();
+            DecodeImages(paths, decoded, pool);
+            pool.Wait();
+            decodeBest = std::min(decodeBest, millisecondsSince(start));
+            FreeImages(decoded);
+
+            start = Clock::now();
+            DecodeImages(paths, decoded, pool, TEXTURE_MIPMAPS);
+            pool.Wait();
+            mipBest = std::min(mipBest, millisecondsSince(start));
+            FreeImages(decoded);
+        }
+        std::cout << "  " << threads << " thread(s): decode " << decodeBest << " ms, decode + mip chain " << mipBest << " ms" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+// OBJ parser throughput benchmark: MB/s on the given model and on a synthetic
+// model made of N copies of it, for 1..hardware_concurrency worker threads.
+//
+// usage: bench_obj_loader [model.obj] [copies] [iterations]
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "mapped_file.h"
+#include "obj_loader.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// Builds copies of an .obj back to back, face indices of copy k are shifted past the elements of copies 0..k-1
+static std::string replicate(const char *data, size_t size, int copies)
+{
+    long counts[3] = { 0, 0, 0 }; // v, vt, vn
+    const char *end = data + size;
+    for (const char *line = data; line < end; )
+    {
+        const char *eol = (const char*)memchr(line, '\n', end - line);
+        eol = eol ? eol : end;
+        if (line[0] == 'v')
+            counts[line[1] == 't' ? 1 : line[1] == 'n' ? 2 : 0]++;
+        line = eol + 1;
+    }
+    std::string out;
+    out.reserve(size * copies + copies * 1024);
+    for (int k = 0; k < copies; ++k)
+    {
+        for (const char *line = data; line < end; )
+        {
+            const char *eol = (const char*)memchr(line, '\n', end - line);
+            eol = eol ? eol + 1 : end;
+            if (k == 0 || line[0] != 'f' || line[1] != ' ')
+            {
+                out.append(line, eol);
+                line = eol;
+                continue;
+            }
+            // rewrite "f a/b/c ..." with every index offset by the copy
+            std::istringstream corners(std::string(line + 1, eol));
+            std::string corner;
+            out += "f";
+            while (corners >> corner)
+            {
+                out += ' ';
+                std::istringstream parts(corner);
+                std::string part;
+                for (int slot = 0; std::getline(parts, part, '/') && slot < 3; ++slot)
+                {
+                    if (slot > 0)
+                        out += '/';
+                    if (part.empty())
+                        continue;
+                    long index = atol(part.c_str());
+                    std::ostringstream number;
+                    number << (index > 0 ? index + counts[slot] * k : index);
+                    out += number.str();
+                }
+            }
+            out += '\n';
+            line = eol;
+        }
+    }
+    return out;
+}
+
+static void run(const char *name, const char *data, size_t size, const std::string &directory, int iterations)
+{
+    unsigned int maxThreads = std::thread::hardware_concurrency();
+    maxThreads = maxThreads ? maxThreads : 1;
+    double megabytes = size / (1024.0 * 1024.0);
+    std::cout << name << " (" << megabytes << " MB)" << std::endl;
+    double singleThreaded = 0.0;
+    for (unsigned int threads = 1; threads <= maxThreads; threads = threads < maxThreads && threads * 2 > maxThreads ? maxThreads : threads * 2)
+    {
+        ThreadPool pool(threads);
+        double best = 1e30;
+        size_t triangles = 0, vertices = 0;
+        for (int i = 0; i < iterations; ++i)
+        {
+            ModelData model;
+            Clock::time_point start = Clock::now();
+            ParseObj(data, size, directory, model, pool);
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            best = seconds < best ? seconds : best;
+            triangles = vertices = 0;
+            for (unsigned int m = 0; m < model.Meshes.size(); ++m)
+            {
+                triangles += model.Meshes[m].Indices.size() / 3;
+                vertices += model.Meshes[m].Vertices.size();
+            }
+        }
+        if (threads == 1)
+            singleThreaded = best;
+        std::cout << "  " << threads << " thread(s): " << best * 1000.0 << " ms, " << megabytes / best << " MB/s, "
+            << singleThreaded / best << "x (" << triangles << " triangles, " << vertices << " vertices)" << std::endl;
+        if (threads == maxThreads)
+            break;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string path = argc > 1 ? argv[1] : "resources/objects/SUV_BF3/suv.obj";
+    int copies = argc > 2 ? atoi(argv[2]) : 100;
+    int iterations = argc > 3 ? atoi(argv[3]) : 3;
+    iterations = iterations < 1 ? 1 : iterations;
+    std::string directory = path.substr(0, path.find_last_of('/'));
+
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        std::cout << "Failed to open " << path << std::endl;
+        return 1;
+    }
+    run(path.c_str(), file.Data(), file.Size(), directory, iterations);
+    if (copies > 1)
+    {
+        std::string synthetic = replicate(file.Data(), file.Size(), copies);
+        std::ostringstream name;
+        name << copies << "x replicated";
+        run(name.str().c_str(), synthetic.data(), synthetic.size(), directory, iterations);
+    }
+    return 0;
+}
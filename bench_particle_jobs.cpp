@@ -0,0 +1,166 @@
+// Particle job scaling benchmark (headless, EGL): the exhaust smoke of many cars, a
+// ParticleSystem each, integrated and packed into ParticleRenderer's instance buffer by
+// SubmitParticleUpdate on 1 to N threads, against the same work done serially (Update and
+// Fill system after system). Dead particles are re-emitted between frames (not timed). After
+// every run the systems are compared with the serial ones and the instance count checked.
+//
+// usage: bench_particle_jobs [cars] [particles per car] [frames] [max threads]
+#include <glad/glad.h>
+
+#include <learnopengl/shader_m.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "gl_ext.h"
+#include "headless.h"
+#include "job_system.h"
+#include "particle_jobs.h"
+#include "particle_renderer.h"
+#include "particle_system.h"
+
+typedef std::chrono::steady_clock Clock;
+
+const float STEP = 1.0f / 60.0f;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Emits the exhaust smoke of car until its system is full, 0.5 to 4.5 seconds to live
+static void refill(ParticleSystem &system, unsigned int car, unsigned int &seed)
+{
+    glm::vec2 exhaust((float)(car % 40) * 12.0f, (float)(car / 40) * 12.0f);
+    while (system.Count < system.Capacity)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        float a = (float)(seed >> 8 & 0xffff) / 65535.0f, b = (float)(seed >> 24) / 255.0f;
+        Particle particle;
+        particle.Position = exhaust;
+        particle.Velocity = glm::vec2((b - 0.5f) * 10.0f, -20.0f - a * 10.0f);
+        particle.Color = glm::vec4(0.5f, 0.5f, 0.5f, 0.6f);
+        particle.Size = 2.0f;
+        particle.Rotation = b * 6.28318f;
+        particle.Life = 0.5f + a * 4.0f;
+        system.Emit(particle);
+    }
+}
+
+static void setup(std::vector<ParticleSystem> &cars, unsigned int particles, std::vector<unsigned int> &seeds)
+{
+    seeds.assign(cars.size(), 0);
+    for (unsigned int i = 0; i < cars.size(); ++i)
+    {
+        cars[i].Generate(particles);
+        cars[i].Forces.Acceleration = glm::vec2(0.0f, -5.0f);
+        cars[i].Forces.Drag = 0.5f;
+        cars[i].Forces.Growth = 3.0f;
+        cars[i].Forces.Fade = 0.15f;
+        seeds[i] = 12345 + i;
+        refill(cars[i], i, seeds[i]);
+    }
+}
+
+// Whether the streams of a and b hold the same bits
+static bool sameParticles(const ParticleSystem &a, const ParticleSystem &b)
+{
+    if (a.Count != b.Count)
+        return false;
+    size_t bytes = a.Count * sizeof(GLfloat);
+    const GLfloat *streamsA[] = { a.PositionX, a.PositionY, a.VelocityX, a.VelocityY, a.Life, a.Size, a.ColorA };
+    const GLfloat *streamsB[] = { b.PositionX, b.PositionY, b.VelocityX, b.VelocityY, b.Life, b.Size, b.ColorA };
+    for (unsigned int s = 0; s < sizeof(streamsA) / sizeof(streamsA[0]); ++s)
+        if (memcmp(streamsA[s], streamsB[s], bytes) != 0)
+            return false;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int carCount = argc > 1 ? (unsigned int)atoi(argv[1]) : 1000;
+    unsigned int particles = argc > 2 ? (unsigned int)atoi(argv[2]) : 1000;
+    int frames = argc > 3 ? atoi(argv[3]) : 60;
+    unsigned int maxThreads = argc > 4 ? (unsigned int)atoi(argv[4]) : std::thread::hardware_concurrency();
+    frames = frames < 1 ? 1 : frames;
+    maxThreads = maxThreads < 1 ? 1 : maxThreads;
+
+    if (!CreateHeadlessContext())
+        return -1;
+    if (!gladLoadGLLoader((GLADloadproc)HeadlessProcAddress) || !LoadGLExtensions((GLADloadproc)HeadlessProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    Shader shader("smoke.vs", "smoke.fs");
+    ParticleRenderer renderer;
+    renderer.Generate(shader.ID, carCount * particles);
+
+    std::cout << carCount << " cars of " << particles << " particles, " << PARTICLE_JOB_CHUNK << " per job, kernel "
+        << ParticleKernelName(DetectParticleKernel()) << ", " << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+    // serial reference
+    std::vector<ParticleSystem> serial(carCount);
+    std::vector<unsigned int> serialSeeds;
+    setup(serial, particles, serialSeeds);
+    double serialMs = 0.0;
+    for (int f = 0; f < frames; ++f)
+    {
+        renderer.BeginFrame();
+        Clock::time_point start = Clock::now();
+        for (unsigned int i = 0; i < carCount; ++i)
+        {
+            serial[i].Update(STEP);
+            ParticleInstance *instances = serial[i].Count > 0 ? renderer.Allocate(serial[i].Count) : NULL;
+            if (instances)
+                serial[i].Fill(instances, 0, serial[i].Count);
+        }
+        serialMs += millisecondsSince(start);
+        renderer.EndFrame();
+        for (unsigned int i = 0; i < carCount; ++i)
+            refill(serial[i], i, serialSeeds[i]);
+    }
+    serialMs /= frames;
+    std::cout << "  serial: " << serialMs << " ms per frame" << std::endl;
+
+    for (unsigned int threads = 1; threads <= maxThreads; ++threads)
+    {
+        JobSystem jobs(threads);
+        std::vector<ParticleSystem> cars(carCount);
+        std::vector<ParticleSystem*> systems;
+        std::vector<unsigned int> seeds;
+        setup(cars, particles, seeds);
+        for (unsigned int i = 0; i < carCount; ++i)
+            systems.push_back(&cars[i]);
+        double ms = 0.0;
+        bool counted = true;
+        for (int f = 0; f < frames; ++f)
+        {
+            renderer.BeginFrame();
+            Clock::time_point start = Clock::now();
+            SubmitParticleUpdate(jobs, systems, STEP, renderer);
+            jobs.Wait();
+            ms += millisecondsSince(start);
+            // every live particle got an instance
+            unsigned int live = 0;
+            for (unsigned int i = 0; i < carCount; ++i)
+                live += cars[i].Count;
+            counted = counted && renderer.Size() == live;
+            renderer.EndFrame();
+            for (unsigned int i = 0; i < carCount; ++i)
+                refill(cars[i], i, seeds[i]);
+        }
+        ms /= frames;
+        bool same = counted;
+        for (unsigned int i = 0; i < carCount && same; ++i)
+            same = sameParticles(cars[i], serial[i]);
+        std::cout << "  " << threads << " thread" << (threads > 1 ? "s" : "") << ": " << ms << " ms per frame, "
+            << (double)carCount * particles / ms / 1000.0 << " M particles/s, " << serialMs / ms << "x serial, "
+            << (same ? "matches serial" : "DIFFERS from serial") << std::endl;
+    }
+    DestroyHeadlessContext();
+    return 0;
+}
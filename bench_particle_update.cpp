@@ -0,0 +1,111 @@
+// Particle update benchmark (CPU only, one thread): smoke particles integrated and compacted by
+// ParticleSystem::Update with every kernel this build and CPU can run, at 10k, 100k and 1M
+// particles (streams in L1/L2, in L2/L3, in memory). Dead particles are re-emitted after every
+// step so the count stays put; only Update is timed. Each kernel's particles are compared with
+// the scalar kernel's after the run.
+//
+// usage: bench_particle_update [max particles] [steps]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "particle_system.h"
+
+typedef std::chrono::steady_clock Clock;
+
+const float STEP = 1.0f / 60.0f;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Emits exhaust smoke until system is full: up and sideways from the origin, 0.5 to 4.5 seconds to live
+static void refill(ParticleSystem &system, unsigned int &seed)
+{
+    while (system.Count < system.Capacity)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        float a = (float)(seed >> 8 & 0xffff) / 65535.0f, b = (float)(seed >> 24) / 255.0f;
+        Particle particle;
+        particle.Position = glm::vec2(0.0f);
+        particle.Velocity = glm::vec2((b - 0.5f) * 10.0f, -20.0f - a * 10.0f);
+        particle.Color = glm::vec4(0.5f, 0.5f, 0.5f, 0.6f);
+        particle.Size = 2.0f;
+        particle.Rotation = b * 6.28318f;
+        particle.Life = 0.5f + a * 4.0f;
+        system.Emit(particle);
+    }
+}
+
+static void setup(ParticleSystem &system, unsigned int count, ParticleKernel kernel)
+{
+    system.Generate(count);
+    system.Kernel = kernel;
+    system.Forces.Acceleration = glm::vec2(0.0f, -5.0f);
+    system.Forces.Drag = 0.5f;
+    system.Forces.Growth = 3.0f;
+    system.Forces.Fade = 0.15f;
+}
+
+// Whether the streams of a and b hold the same bits
+static bool sameParticles(const ParticleSystem &a, const ParticleSystem &b)
+{
+    if (a.Count != b.Count)
+        return false;
+    size_t bytes = a.Count * sizeof(GLfloat);
+    const GLfloat *streamsA[] = { a.PositionX, a.PositionY, a.VelocityX, a.VelocityY, a.Life, a.Size, a.ColorA };
+    const GLfloat *streamsB[] = { b.PositionX, b.PositionY, b.VelocityX, b.VelocityY, b.Life, b.Size, b.ColorA };
+    for (unsigned int s = 0; s < sizeof(streamsA) / sizeof(streamsA[0]); ++s)
+        if (memcmp(streamsA[s], streamsB[s], bytes) != 0)
+            return false;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int maxParticles = argc > 1 ? (unsigned int)atoi(argv[1]) : 1000000;
+    int steps = argc > 2 ? atoi(argv[2]) : 200;
+    steps = steps < 1 ? 1 : steps;
+
+    ParticleKernel best = DetectParticleKernel();
+    std::cout << "widest kernel: " << ParticleKernelName(best) << ", " << steps << " steps of " << STEP << " s on one core" << std::endl;
+    for (unsigned int count = 10000; count <= maxParticles; count *= 10)
+    {
+        std::cout << "  " << count << " particles:";
+        ParticleSystem scalar;
+        double scalarRate = 0.0;
+        for (int kernel = PARTICLE_KERNEL_SCALAR; kernel <= best; ++kernel)
+        {
+            ParticleSystem current;
+            ParticleSystem &system = kernel == PARTICLE_KERNEL_SCALAR ? scalar : current;
+            setup(system, count, (ParticleKernel)kernel);
+            unsigned int seed = 12345;
+            refill(system, seed);
+            double fastest = 1e30, total = 0.0;
+            unsigned long long updated = 0;
+            for (int i = 0; i < steps; ++i)
+            {
+                updated += system.Count;
+                Clock::time_point start = Clock::now();
+                system.Update(STEP);
+                double ms = millisecondsSince(start);
+                total += ms;
+                fastest = std::min(fastest, ms);
+                refill(system, seed);
+            }
+            double rate = updated / total / 1000.0;
+            if (kernel == PARTICLE_KERNEL_SCALAR)
+                scalarRate = rate;
+            std::cout << " " << ParticleKernelName((ParticleKernel)kernel) << " " << rate << " M particles/s (best step " << fastest << " ms";
+            if (kernel != PARTICLE_KERNEL_SCALAR)
+                std::cout << ", " << rate / scalarRate << "x, " << (sameParticles(system, scalar) ? "matches scalar" : "DIFFERS from scalar");
+            std::cout << ")";
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+// Particle rendering benchmark (headless, EGL): smoke particles of many emitters drawn with
+// ParticleRenderer's single instanced draw against the per-particle path (a uniform update and
+// draw call each), at 10k, 100k and 1M particles. Both paths draw the same particles into an
+// offscreen target, the checksums of the two images are compared. Frames are timed to glFinish
+// with GL_RASTERIZER_DISCARD, the cost of submitting the particles, then once rasterized.
+//
+// usage: bench_particles [max particles] [frames]
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/shader_m.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "gl_ext.h"
+#include "headless.h"
+#include "particle_renderer.h"
+#include "stb_image.h"
+
+typedef std::chrono::steady_clock Clock;
+
+const GLsizei TARGET_SIZE = 512;
+const unsigned int PARTICLES_PER_EMITTER = 1000;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Emitters of PARTICLES_PER_EMITTER particles each, like the exhaust of a car: a plume drifting
+// up from a random point, fading and growing with age. Every tenth particle is dead.
+static void buildEmitters(unsigned int count, std::vector<std::vector<Particle> > &emitters)
+{
+    unsigned int seed = 12345;
+    emitters.assign((count + PARTICLES_PER_EMITTER - 1) / PARTICLES_PER_EMITTER, std::vector<Particle>());
+    for (unsigned int e = 0; e < emitters.size(); ++e)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        float x = (float)(seed >> 8 & 0xffff) / 65535.0f;
+        seed = seed * 1664525u + 1013904223u;
+        glm::vec2 exhaust(x * TARGET_SIZE, (float)(seed >> 8 & 0xffff) / 65535.0f * TARGET_SIZE);
+        unsigned int particles = std::min(PARTICLES_PER_EMITTER, count - e * PARTICLES_PER_EMITTER);
+        for (unsigned int i = 0; i < particles; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            float age = (float)(seed >> 8 & 0xffff) / 65535.0f;
+            float spread = ((float)(seed >> 24) / 255.0f - 0.5f) * 2.0f;
+            Particle particle;
+            particle.Velocity = glm::vec2(spread * 8.0f, -30.0f);
+            particle.Position = exhaust + particle.Velocity * age * 2.0f;
+            particle.Color = glm::vec4(0.5f, 0.5f, 0.5f, (1.0f - age) * 0.25f);
+            particle.Size = 2.0f + age * 6.0f;
+            particle.Rotation = spread * 3.14159f;
+            particle.Life = i % 10 == 9 ? 0.0f : 1.0f - age;
+            emitters[e].push_back(particle);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int maxParticles = argc > 1 ? (unsigned int)atoi(argv[1]) : 1000000;
+    int frames = argc > 2 ? atoi(argv[2]) : 3;
+    frames = frames < 1 ? 1 : frames;
+
+    if (!CreateHeadlessContext())
+        return -1;
+    if (!gladLoadGLLoader((GLADloadproc)HeadlessProcAddress) || !LoadGLExtensions((GLADloadproc)HeadlessProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    OffscreenTarget target;
+    if (!target.Generate(TARGET_SIZE, TARGET_SIZE))
+        return -1;
+    target.Bind();
+
+    Shader shader("smoke.vs", "smoke.fs");
+    shader.use();
+    shader.setMat4("projection", glm::ortho(0.0f, (float)TARGET_SIZE, (float)TARGET_SIZE, 0.0f, -1.0f, 1.0f));
+    shader.setInt("sprite", 0);
+
+    int width, height, components;
+    unsigned char *data = stbi_load("resources/textures/smoke.png", &width, &height, &components, 4);
+    if (!data)
+    {
+        std::cout << "ERROR::BENCH_PARTICLES: Failed to load resources/textures/smoke.png" << std::endl;
+        return -1;
+    }
+    GLuint sprite;
+    glGenTextures(1, &sprite);
+    glBindTexture(GL_TEXTURE_2D, sprite);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    stbi_image_free(data);
+    // additive smoke, as the Breakout particles blend
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+
+    ParticleRenderer renderer;
+    renderer.Generate(shader.ID, maxParticles);
+    std::cout << "instance buffer " << (renderer.Persistent ? "persistently mapped" : "orphaned") << ", "
+        << sizeof(ParticleInstance) << " bytes per particle, " << TARGET_SIZE << "x" << TARGET_SIZE << " target" << std::endl;
+    for (unsigned int count = 10000; count <= maxParticles; count *= 10)
+    {
+        std::vector<std::vector<Particle> > emitters;
+        buildEmitters(count, emitters);
+        double submit[2] = { 1e30, 1e30 }, frame[2] = { 0.0, 0.0 };
+        uint64_t checksum[2] = { 0, 0 };
+        for (int path = 0; path < 2; ++path)
+        {
+            // the last frame draws the image, the ones before discard the triangles before
+            // rasterization so their times are the cost of getting the particles to the GPU
+            for (int f = 0; f <= frames; ++f)
+            {
+                if (f < frames)
+                    glEnable(GL_RASTERIZER_DISCARD);
+                else
+                    glDisable(GL_RASTERIZER_DISCARD);
+                glClear(GL_COLOR_BUFFER_BIT);
+                glFinish();
+                Clock::time_point start = Clock::now();
+                renderer.BeginFrame();
+                for (unsigned int e = 0; e < emitters.size(); ++e)
+                {
+                    if (path == 0)
+                        renderer.Add(emitters[e]);
+                    else
+                        renderer.DrawPerParticle(emitters[e]);
+                }
+                renderer.Draw();
+                renderer.EndFrame();
+                glFinish();
+                if (f < frames)
+                    submit[path] = std::min(submit[path], millisecondsSince(start));
+                else
+                    frame[path] = millisecondsSince(start);
+            }
+            checksum[path] = target.Checksum();
+        }
+        std::cout << "  " << count << " particles, " << emitters.size() << " emitters: instanced (1 draw) " << submit[0] << " ms, "
+            << frame[0] << " ms rasterized; per particle (" << count - count / 10 << " draws) " << submit[1] << " ms ("
+            << submit[1] / submit[0] << "x), " << frame[1] << " ms rasterized; images " << (checksum[0] == checksum[1] ? "match" : "DIFFER")
+            << std::endl;
+    }
+    DestroyHeadlessContext();
+    return 0;
+}
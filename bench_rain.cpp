@@ -0,0 +1,147 @@
+// Rain benchmark (headless, EGL): a RainSystem around a camera flying straight ahead and turning,
+// at several densities. Prints, per density, the drops simulated and the CPU time per frame of
+// moving them and writing their instances (Update) and the GPU time of drawing them (a
+// GL_TIME_ELAPSED query around Draw, and the wall time from Draw until glFinish returns, which
+// is what counts on software renderers), and how far the camera flew: the cost follows the drops
+// in the cube around the camera, not the distance covered.
+//
+// usage: bench_rain [frames] [extent] [densities (drops per cubic unit)...] [image.ppm]
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/shader_m.h>
+#include <learnopengl/camera.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gl_ext.h"
+#include "headless.h"
+#include "rain.h"
+#include "uniform_buffer.h"
+
+typedef std::chrono::steady_clock Clock;
+
+const GLsizei TARGET_WIDTH = 800, TARGET_HEIGHT = 600;
+const float STEP = 1.0f / 60.0f;
+const float CAMERA_SPEED = 20.0f; // World units per second
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    int frames = 120;
+    float extent = 16.0f;
+    std::vector<float> densities;
+    std::string imagePath;
+    for (int i = 1, number = 0; i < argc; ++i)
+    {
+        size_t length = strlen(argv[i]);
+        if (length > 4 && strcmp(argv[i] + length - 4, ".ppm") == 0)
+            imagePath = argv[i];
+        else if (number++ == 0)
+            frames = atoi(argv[i]);
+        else if (number == 2)
+            extent = (float)atof(argv[i]);
+        else
+            densities.push_back((float)atof(argv[i]));
+    }
+    frames = frames < 1 ? 1 : frames;
+    extent = extent > 0.0f ? extent : 16.0f;
+    if (densities.empty())
+    {
+        // about 10k, 100k, 400k and 1M drops in the default cube
+        densities.push_back(2.5f);
+        densities.push_back(25.0f);
+        densities.push_back(100.0f);
+        densities.push_back(250.0f);
+    }
+    float maxDensity = 0.0f;
+    for (unsigned int i = 0; i < densities.size(); ++i)
+        maxDensity = std::max(maxDensity, densities[i]);
+
+    if (!CreateHeadlessContext())
+        return -1;
+    if (!gladLoadGLLoader((GLADloadproc)HeadlessProcAddress) || !LoadGLExtensions((GLADloadproc)HeadlessProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    OffscreenTarget target;
+    if (!target.Generate(TARGET_WIDTH, TARGET_HEIGHT))
+        return -1;
+    target.Bind();
+    glEnable(GL_DEPTH_TEST);
+    Shader shader("rain.vs", "rain.fs");
+    BindUniformBlocks(shader.ID);
+    UniformBuffer frameUniforms;
+    frameUniforms.Generate(FRAME_UNIFORM_BINDING, sizeof(FrameUniforms));
+
+    RainSystem rain;
+    GLuint capacity = (GLuint)std::ceil(maxDensity * extent * extent * extent);
+    if (!rain.Generate(shader.ID, capacity, extent, "resources/textures/Raindrops-Free-Download-PNG.png"))
+        return -1;
+    GLuint query;
+    glGenQueries(1, &query);
+    std::cout << frames << " frames, " << extent << " unit cube around the camera, instance buffer "
+        << (rain.Persistent ? "persistently mapped" : "orphaned") << ", " << sizeof(RainInstance) << " bytes per drop, "
+        << TARGET_WIDTH << "x" << TARGET_HEIGHT << " target" << std::endl;
+    for (unsigned int d = 0; d < densities.size(); ++d)
+    {
+        rain.SetDensity(densities[d]);
+        Camera camera(glm::vec3(0.0f, 1.5f, 0.0f));
+        glm::vec3 start = camera.Position;
+        double cpuMs = 0.0, gpuMs = 0.0, drawMs = 0.0;
+        for (int f = 0; f < frames; ++f)
+        {
+            // straight ahead, turning slowly
+            camera.ProcessMouseMovement(0.5f, 0.0f);
+            camera.Position += camera.Front * (CAMERA_SPEED * STEP);
+            FrameUniforms frame;
+            frame.Projection = glm::perspective(glm::radians(camera.Zoom), (float)TARGET_WIDTH / (float)TARGET_HEIGHT, 0.1f, 100.0f);
+            frame.View = camera.GetViewMatrix();
+            frame.ViewPosition = glm::vec4(camera.Position, 1.0f);
+            frame.LightPosition = glm::vec4(0.0f);
+            frame.LightColor = glm::vec4(1.0f);
+            frameUniforms.Update(&frame);
+            glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            rain.BeginFrame();
+            Clock::time_point cpuStart = Clock::now();
+            rain.Update(STEP, camera.Position);
+            cpuMs += millisecondsSince(cpuStart);
+            shader.use();
+            glFinish();
+            Clock::time_point drawStart = Clock::now();
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            rain.Draw();
+            glEndQuery(GL_TIME_ELAPSED);
+            rain.EndFrame();
+            glFinish();
+            drawMs += millisecondsSince(drawStart);
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+            gpuMs += nanoseconds / 1000000.0;
+        }
+        std::cout << "  density " << densities[d] << ": " << rain.Count << " drops, CPU " << cpuMs / frames << " ms, GPU "
+            << gpuMs / frames << " ms per frame (draw to finish " << drawMs / frames << " ms), camera flew " << glm::length(camera.Position - start) << " units" << std::endl;
+    }
+    std::cout << "  image checksum " << std::hex << target.Checksum() << std::dec << std::endl;
+    if (!imagePath.empty() && target.WritePPM(imagePath))
+        std::cout << "wrote " << imagePath << std::endl;
+    glDeleteQueries(1, &query);
+    DestroyHeadlessContext();
+    return 0;
+}
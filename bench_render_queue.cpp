@@ -0,0 +1,112 @@
+// Render queue benchmark (CPU only, no GL context): the draws of a scene of many models
+// sharing a few meshes and materials, keyed as RenderQueue keys them, sorted with RadixSort
+// and std::stable_sort (checking both give the same order), and the texture and vertex
+// array binds issuing them takes in the order added against the sorted order.
+//
+// usage: bench_render_queue [max draws] [iterations]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "radix_sort.h"
+#include "render_queue.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// A draw of the synthetic scene, what RenderQueue keeps of it to bind state
+struct Draw
+{
+    GLuint Texture, VertexArray;
+};
+
+// Model types of the scene, the meshes of each, and the materials they pick from
+const unsigned int MODEL_TYPES = 8;
+const unsigned int MESHES_PER_MODEL = 12;
+const unsigned int MATERIALS = 24;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// count draws, model after model as the application adds them: every copy of a model type
+// draws its meshes (one vertex array each) with their materials, at a random distance
+static void buildScene(unsigned int count, std::vector<Draw> &draws, std::vector<SortEntry> &entries)
+{
+    unsigned int seed = 12345;
+    draws.clear();
+    entries.clear();
+    while (draws.size() < count)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        unsigned int type = (seed >> 16) % MODEL_TYPES;
+        seed = seed * 1664525u + 1013904223u;
+        float depth = (float)(seed >> 8) / (float)(1 << 24);
+        for (unsigned int mesh = 0; mesh < MESHES_PER_MODEL && draws.size() < count; ++mesh)
+        {
+            Draw draw;
+            draw.Texture = 1 + (type * 7 + mesh * 5) % MATERIALS;
+            draw.VertexArray = 1 + type * MESHES_PER_MODEL + mesh;
+            SortEntry entry;
+            entry.Key = RenderKey(1, draw.Texture, draw.VertexArray, depth + mesh * 0.001f);
+            entry.Item = (uint32_t)draws.size();
+            draws.push_back(draw);
+            entries.push_back(entry);
+        }
+    }
+}
+
+// Texture and vertex array binds of the draws in the order of entries, as Submit counts them
+static unsigned int countBinds(const std::vector<Draw> &draws, const std::vector<SortEntry> &entries)
+{
+    unsigned int binds = 0;
+    GLuint texture = 0, vertexArray = 0;
+    for (unsigned int i = 0; i < entries.size(); ++i)
+    {
+        const Draw &draw = draws[entries[i].Item];
+        binds += (i == 0 || draw.Texture != texture) + (i == 0 || draw.VertexArray != vertexArray);
+        texture = draw.Texture;
+        vertexArray = draw.VertexArray;
+    }
+    return binds;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int maxDraws = argc > 1 ? (unsigned int)atoi(argv[1]) : 1000000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 5;
+    iterations = iterations < 1 ? 1 : iterations;
+
+    std::cout << MODEL_TYPES << " model types of " << MESHES_PER_MODEL << " meshes, " << MATERIALS << " materials" << std::endl;
+    for (unsigned int count = 100; count <= maxDraws; count *= 10)
+    {
+        std::vector<Draw> draws;
+        std::vector<SortEntry> entries;
+        buildScene(count, draws, entries);
+        std::vector<SortEntry> radix, stable, scratch(count);
+        double radixBest = 1e30, stableBest = 1e30;
+        for (int i = 0; i < iterations; ++i)
+        {
+            radix = entries;
+            Clock::time_point start = Clock::now();
+            RadixSort(&radix[0], &scratch[0], radix.size());
+            radixBest = std::min(radixBest, millisecondsSince(start));
+
+            stable = entries;
+            start = Clock::now();
+            std::stable_sort(stable.begin(), stable.end(), [](const SortEntry &a, const SortEntry &b) { return a.Key < b.Key; });
+            stableBest = std::min(stableBest, millisecondsSince(start));
+        }
+        bool same = true;
+        for (unsigned int i = 0; i < count && same; ++i)
+            same = radix[i].Item == stable[i].Item;
+
+        unsigned int unsortedBinds = countBinds(draws, entries), sortedBinds = countBinds(draws, radix);
+        std::cout << "  " << count << " draws: radix sort " << radixBest << " ms, std::stable_sort " << stableBest << " ms ("
+            << stableBest / radixBest << "x)" << (same ? "" : ", ORDERS DIFFER") << "; texture + vertex array binds "
+            << unsortedBinds << " added order, " << sortedBinds << " sorted (" << (count * 2 - sortedBinds) << " avoided)" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Startup benchmark: time to get the SUV's vertex data ready for glBufferData
+// through the text path (parsing and processing suv.obj) versus the memory-mapped mesh cache.
+//
+// usage: bench_startup [model.obj] [iterations]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "mesh_cache.h"
+#include "mesh_processing.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Reads every byte the GL driver would read on upload, so the mmap path pays for its page faults
+static uint64_t touch(const void *data, size_t size)
+{
+    const unsigned char *bytes = (const unsigned char*)data;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < size; i += 64)
+        sum += bytes[i];
+    return sum;
+}
+
+int main(int argc, char **argv)
+{
+    std::string path = argc > 1 ? argv[1] : "resources/objects/SUV_BF3/suv.obj";
+    int iterations = argc > 2 ? atoi(argv[2]) : 5;
+    if (iterations < 1)
+        iterations = 1;
+
+    // text path
+    // ---------
+    double textBest = 1e30, textTotal = 0.0;
+    size_t vertexBytes = 0;
+    // processed as car_with_lighting loads it, so the warm start is the app's
+    MeshProcessingOptions options;
+    options.Quantize = true;
+    ModelData model;
+    for (int i = 0; i < iterations; ++i)
+    {
+        Clock::time_point start = Clock::now();
+        ModelData loaded;
+        if (!LoadProcessedModel(path, loaded, options))
+            return 1;
+        double ms = millisecondsSince(start);
+        textBest = ms < textBest ? ms : textBest;
+        textTotal += ms;
+        if (i == 0)
+            model = loaded;
+    }
+    for (unsigned int i = 0; i < model.Meshes.size(); ++i)
+        vertexBytes += model.Meshes[i].Vertices.size() * sizeof(MeshVertex) + model.Meshes[i].Indices.size() * IndexSizeFor(model.Meshes[i].Vertices.size());
+
+    // cache build (once)
+    // ------------------
+    Clock::time_point start = Clock::now();
+    if (!MeshCache::Write(path, model, options))
+        return 1;
+    double writeMs = millisecondsSince(start);
+
+    // mmap path
+    // ---------
+    double cacheBest = 1e30, cacheTotal = 0.0;
+    uint64_t checksum = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+        start = Clock::now();
+        MeshCache cache;
+        if (!cache.Load(path, options))
+            return 1;
+        for (unsigned int m = 0; m < cache.Header().MeshCount; ++m)
+        {
+            const MeshCacheMesh &mesh = cache.Mesh(m);
+            checksum += touch(cache.Vertices(m), (size_t)mesh.VertexCount * mesh.VertexStride);
+            checksum += touch(cache.Indices(m), (size_t)mesh.IndexCount * mesh.IndexSize);
+        }
+        double ms = millisecondsSince(start);
+        cacheBest = ms < cacheBest ? ms : cacheBest;
+        cacheTotal += ms;
+    }
+
+    std::cout << "model:      " << path << " (" << model.Meshes.size() << " meshes, " << vertexBytes / 1024 << " KiB of vertex/index data)" << std::endl;
+    std::cout << "text path:  best " << textBest << " ms, avg " << textTotal / iterations << " ms" << std::endl;
+    std::cout << "cache write:     " << writeMs << " ms" << std::endl;
+    std::cout << "mmap path:  best " << cacheBest << " ms, avg " << cacheTotal / iterations << " ms (includes staleness check)" << std::endl;
+    std::cout << "speedup:    " << textBest / cacheBest << "x" << " [checksum " << checksum << "]" << std::endl;
+    return 0;
+}
@@ -0,0 +1,113 @@
+// Texture decoding benchmark: wall-clock time to decode the diffuse maps of a model,
+// serially per material with stbi_load (as model loading did) and concurrently on
+// 1..N worker threads, alone and together with parsing the .obj (a cold model load
+// without the GL upload).
+//
+// usage: bench_textures [model.obj] [max threads] [iterations]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include "obj_loader.h"
+#include "path_resolver.h"
+#include "stb_image.h"
+#include "texture_loader.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Distinct diffuse maps of model, as spelled on disk
+static std::vector<std::string> diffuseMaps(const ModelData &model, const std::string &directory)
+{
+    PathResolver resolver;
+    std::vector<std::string> paths;
+    for (unsigned int i = 0; i < model.Materials.size(); ++i)
+    {
+        std::string path = directory + '/' + resolver.Resolve(directory, model.Materials[i].DiffuseMap);
+        if (!model.Materials[i].DiffuseMap.empty() && std::find(paths.begin(), paths.end(), path) == paths.end())
+            paths.push_back(path);
+    }
+    return paths;
+}
+
+int main(int argc, char **argv)
+{
+    std::string path = argc > 1 ? argv[1] : "resources/objects/SUV_BF3/suv.obj";
+    unsigned int maxThreads = argc > 2 ? (unsigned int)atoi(argv[2]) : std::thread::hardware_concurrency();
+    maxThreads = maxThreads ? maxThreads : 1;
+    int iterations = argc > 3 ? atoi(argv[3]) : 3;
+    iterations = iterations < 1 ? 1 : iterations;
+    std::string directory = path.substr(0, path.find_last_of('/'));
+
+    ModelData model;
+    if (!LoadObj(path, model))
+        return 1;
+    std::vector<std::string> paths = diffuseMaps(model, directory);
+    std::cout << "model: " << path << " (" << model.Materials.size() << " materials, " << paths.size() << " distinct diffuse maps)" << std::endl;
+
+    // serial: stbi_load per material on the calling thread
+    // -----------------------------------------------------
+    double serialBest = 1e30;
+    size_t pixels = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+        Clock::time_point start = Clock::now();
+        pixels = 0;
+        PathResolver resolver;
+        for (unsigned int m = 0; m < model.Materials.size(); ++m)
+        {
+            if (model.Materials[m].DiffuseMap.empty())
+                continue;
+            int width, height, components;
+            unsigned char *data = stbi_load((directory + '/' + resolver.Resolve(directory, model.Materials[m].DiffuseMap)).c_str(), &width, &height, &components, 0);
+            if (data)
+            {
+                pixels += (size_t)width * height;
+                stbi_image_free(data);
+            }
+        }
+        serialBest = std::min(serialBest, millisecondsSince(start));
+    }
+    std::cout << "serial stbi_load per material: " << serialBest << " ms (" << pixels / 1000000.0 << " Mpixels)" << std::endl;
+
+    // worker pool: distinct maps decoded concurrently, alone and with the .obj parse
+    // -------------------------------------------------------------------------------
+    double singleThreaded = 0.0;
+    for (unsigned int threads = 1; threads <= maxThreads; ++threads)
+    {
+        ThreadPool pool(threads);
+        double decodeBest = 1e30, loadBest = 1e30;
+        unsigned int decoded = 0;
+        for (int i = 0; i < iterations; ++i)
+        {
+            std::vector<DecodedImage> images;
+            Clock::time_point start = Clock::now();
+            DecodeImages(paths, images, pool);
+            pool.Wait();
+            decodeBest = std::min(decodeBest, millisecondsSince(start));
+            decoded = 0;
+            for (unsigned int m = 0; m < images.size(); ++m)
+                decoded += images[m].Data != NULL;
+            FreeImages(images);
+
+            start = Clock::now();
+            ModelData loaded;
+            LoadObj(path, loaded, &pool);
+            DecodeImages(diffuseMaps(loaded, directory), images, pool);
+            pool.Wait();
+            loadBest = std::min(loadBest, millisecondsSince(start));
+            FreeImages(images);
+        }
+        if (threads == 1)
+            singleThreaded = decodeBest;
+        std::cout << "  " << threads << " thread(s): decode " << decodeBest << " ms (" << singleThreaded / decodeBest << "x, "
+            << decoded << "/" << paths.size() << " decoded), obj + decode " << loadBest << " ms" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,21 @@
+#include <cmath>
+
+#include "camera_path.h"
+
+
+void LookAt(Camera &camera, const glm::vec3 &position, const glm::vec3 &target)
+{
+    glm::vec3 direction = glm::normalize(target - position);
+    camera.Position = position;
+    camera.Yaw = glm::degrees(atan2f(direction.z, direction.x));
+    camera.Pitch = glm::degrees(asinf(direction.y));
+    camera.ProcessMouseMovement(0.0f, 0.0f);
+}
+
+void FollowOrbitPath(Camera &camera, const glm::vec3 &target, float t)
+{
+    float angle = t * 4.0f * 3.14159265f;
+    float distance = 9.0f + 6.0f * sinf(t * 6.0f * 3.14159265f);
+    glm::vec3 position = target + glm::vec3(cosf(angle) * distance, 3.0f * sinf(t * 2.0f * 3.14159265f) + 1.0f, sinf(angle) * distance);
+    LookAt(camera, position, target);
+}
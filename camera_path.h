@@ -0,0 +1,15 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/camera.h>
+
+// Points camera from position at target, the way mouse look would
+void LookAt(Camera &camera, const glm::vec3 &position, const glm::vec3 &target);
+// Scripted camera for benchmark runs, replacing mouse and keyboard: two orbits around target,
+// swinging between a close-up (partly off screen) and a full view, up and down. t runs from 0
+// to 1 over the path.
+void FollowOrbitPath(Camera &camera, const glm::vec3 &target, float t);
+
+#endif
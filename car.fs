@@ -5,21 +5,28 @@ in vec3 Normal;
 in vec3 FragPos; 
 in vec2 TexCoords;
   
-uniform vec3 lightPos; 
-uniform vec3 lightColor;
+// camera and light, shared by all shaders (uniform_buffer.h)
+layout (std140) uniform Frame
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
 uniform sampler2D texture_diffuse1;
 
 void main()
 {
     // ambient
     float ambientStrength = 0.1;
-    vec3 ambient = ambientStrength * lightColor;
+    vec3 ambient = ambientStrength * lightColor.rgb;
   	
     // diffuse 
     vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(lightPos - FragPos);
+    vec3 lightDir = normalize(lightPos.xyz - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor;
+    vec3 diffuse = diff * lightColor.rgb;
             
     vec3 result = (ambient + diffuse);
     FragColor = vec4(result, 1.0) * texture(texture_diffuse1, TexCoords);
@@ -2,20 +2,48 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+// per instance, only read when instanced is set
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in mat3 aNormalMatrix;
 
 out vec2 TexCoords;
 out vec3 FragPos;
 out vec3 Normal;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// camera and light, shared by all shaders (uniform_buffer.h)
+layout (std140) uniform Frame
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
+// per draw
+layout (std140) uniform Draw
+{
+    mat4 model;
+    mat3 normalMatrix; // inverse transpose of model
+    // compact vertices store positions relative to the mesh bounds (scale 1, offset 0 for float vertices)
+    vec4 positionScale;
+    vec4 positionOffset;
+    bool instanced;
+};
 
 void main()
 {
     TexCoords = aTexCoords;  
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = aNormal;  
+    vec4 position = vec4(aPos * positionScale.xyz + positionOffset.xyz, 1.0);
+    if (instanced)
+    {
+        FragPos = vec3(aModel * position);
+        Normal = aNormalMatrix * aNormal;
+    }
+    else
+    {
+        FragPos = vec3(model * position);
+        Normal = normalMatrix * aNormal;
+    }
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
\ No newline at end of file
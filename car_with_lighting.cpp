@@ -8,9 +8,29 @@
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
-#include <learnopengl/model.h>
 
+#include "camera_path.h"
+#include "gl_call_counter.h"
+#include "gl_ext.h"
+#include "headless.h"
+#include "instance_culler.h"
+#include "profiler.h"
+#include "rain.h"
+#include "render_queue.h"
+#include "static_model.h"
+#include "texture_stream.h"
+#include "texture_upload.h"
+#include "uniform_buffer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <vector>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -34,43 +54,139 @@ float lastFrame = 0.0f;
 // lighting
 glm::vec3 lightPos(2.0f, 2.0f, 2.0f);
 
-int main()
+// rain: edge of the cube of drops simulated around the camera
+const float RAIN_EXTENT = 16.0f;
+
+// headless runs: frames rendered before the measured ones (shader compilation, first uploads)
+const unsigned int WARMUP_FRAMES = 10;
+
+static bool endsWith(const char *text, const char *suffix)
 {
-    // glfw: initialize and configure
-    // ------------------------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    size_t length = strlen(text), suffixLength = strlen(suffix);
+    return length > suffixLength && strcmp(text + length - suffixLength, suffix) == 0;
+}
+
+// usage: car_with_lighting [cars] [individual] [sorted] [pooled] [cull=gpu|cpu] [texture-budget=MB] [rain=density] [trace.json | trace.csv] [headless [frames=N] [image.ppm]]
+// Draws cars on a grid, all at once with instancing, or one Draw call per car if "individual" is given.
+// "sorted" records the draws in a render queue that sorts them by state and skips redundant binds.
+// "pooled" draws the meshes from the model's geometry pools, one multi-draw per material.
+// "cull=gpu" frustum culls the instanced cars per mesh in a compute shader feeding indirect draws
+// ("cull=cpu" runs the same test on the CPU), headless runs check both agree on the last frame.
+// "rain=density" lets density drops per cubic unit fall in a cube around the camera, drawn in one instanced draw.
+// Textures stream in at the mip levels the view needs, within texture-budget MB of video memory.
+// With a trace file, every profiled scope and pass is written to it on exit (Chrome trace or CSV).
+// "headless" renders into a framebuffer object of an EGL context instead of a window (no display
+// needed, Mesa's llvmpipe works), flies the camera along a scripted path for a fixed number of
+// frames (600 by default) and prints timing statistics, the image checksum and optionally the image.
+int main(int argc, char **argv)
+{
+    unsigned int carCount = 1;
+    bool instancedCars = true;
+    bool sortedDraws = false;
+    bool pooledDraws = false;
+    bool cullInstances = false, gpuCulling = false;
+    bool headless = false;
+    unsigned int frameCount = 600;
+    size_t textureBudget = TEXTURE_STREAM_BUDGET;
+    float rainDensity = 0.0f;
+    std::string tracePath, imagePath;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "individual") == 0)
+            instancedCars = false;
+        else if (strcmp(argv[i], "sorted") == 0)
+            sortedDraws = true;
+        else if (strcmp(argv[i], "pooled") == 0)
+            pooledDraws = true;
+        else if (strncmp(argv[i], "cull=", 5) == 0)
+        {
+            cullInstances = true;
+            gpuCulling = strcmp(argv[i] + 5, "gpu") == 0;
+        }
+        else if (strcmp(argv[i], "headless") == 0)
+            headless = true;
+        else if (strncmp(argv[i], "frames=", 7) == 0)
+            frameCount = (unsigned int)atoi(argv[i] + 7);
+        else if (strncmp(argv[i], "texture-budget=", 15) == 0)
+            textureBudget = (size_t)atoi(argv[i] + 15) << 20;
+        else if (strncmp(argv[i], "rain=", 5) == 0)
+            rainDensity = (float)atof(argv[i] + 5);
+        else if (endsWith(argv[i], ".json") || endsWith(argv[i], ".csv"))
+            tracePath = argv[i];
+        else if (endsWith(argv[i], ".ppm"))
+            imagePath = argv[i];
+        else
+            carCount = (unsigned int)atoi(argv[i]);
+    }
+    if (carCount < 1)
+        carCount = 1;
+    if (frameCount < 1)
+        frameCount = 1;
+
+    GLFWwindow* window = NULL;
+    OffscreenTarget offscreen;
+    GLADloadproc loadProc = (GLADloadproc)glfwGetProcAddress;
+    if (headless)
+    {
+        // egl: context without a window
+        // -----------------------------
+        if (!CreateHeadlessContext())
+            return -1;
+        loadProc = (GLADloadproc)HeadlessProcAddress;
+    }
+    else
+    {
+        // glfw: initialize and configure
+        // ------------------------------
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 #ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
 #endif
 
-    // glfw window creation
-    // --------------------
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
-    if (window == NULL)
-    {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
+        // glfw window creation
+        // --------------------
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+        if (window == NULL)
+        {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetScrollCallback(window, scroll_callback);
+
+        // tell GLFW to capture our mouse
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-
-    // tell GLFW to capture our mouse
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
     // glad: load all OpenGL function pointers
     // ---------------------------------------
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    if (!gladLoadGLLoader(loadProc))
     {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    if (!LoadGLExtensions(loadProc))
+        return -1;
+    // count the GL calls of every frame, printed with the frame time
+    InstallGLCallCounter();
+    // the frame times printed while drawing many cars compare the draw paths, don't wait for vsync
+    if (carCount > 1 && !headless)
+        glfwSwapInterval(0);
+    // headless: draw into a framebuffer object of the window's size
+    if (headless)
+    {
+        if (!offscreen.Generate(SCR_WIDTH, SCR_HEIGHT))
+            return -1;
+        offscreen.Bind();
+        std::cout << "headless: " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << std::endl;
+    }
 
     // configure global opengl state
     // -----------------------------
@@ -80,10 +196,30 @@ int main()
     // ------------------------------------
     Shader lightingShader("car.vs", "car.fs");
     Shader lampShader("lamp.vs", "lamp.fs");
+    Shader rainShader("rain.vs", "rain.fs");
+    // the uniform blocks stay bound to their binding points, the sampler to texture unit 0
+    BindUniformBlocks(lightingShader.ID);
+    BindUniformBlocks(lampShader.ID);
+    BindUniformBlocks(rainShader.ID);
+    lightingShader.use();
+    lightingShader.setInt("texture_diffuse1", 0);
 
     // load models
     // -----------
-    Model ourModel(FileSystem::getPath("resources/objects/SUV_BF3/suv.obj"));
+    // car.vs decodes compact vertices, so meshes may use them
+    MeshProcessingOptions meshOptions;
+    meshOptions.Quantize = true;
+    std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
+    // textures stream in through the uploader's pixel buffers, starting from their mip tail,
+    // headless runs wait for them so the image doesn't depend on upload timing
+    TextureUploader textureUploader;
+    textureUploader.Generate();
+    TextureStreamer textureStreamer(&textureUploader, textureBudget);
+    StaticModel ourModel(FileSystem::getPath("resources/objects/SUV_BF3/suv.obj"), meshOptions, NULL, &textureUploader, &textureStreamer);
+    ourModel.Pooled = pooledDraws;
+    if (headless)
+        textureUploader.Finish();
+    std::cout << "model loaded in " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count() << " ms" << std::endl;
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
@@ -159,62 +295,299 @@ int main()
     glEnableVertexAttribArray(0);
 
 
+    // world transformation of every car: the first one centered in the scene, the rest on a grid behind it
+    std::vector<glm::mat4> carModels;
+    std::vector<ModelInstance> carInstances;
+    unsigned int columns = (unsigned int)ceil(sqrt((double)carCount));
+    for (unsigned int i = 0; i < carCount; ++i)
+    {
+        glm::mat4 model;
+        model = glm::translate(model, glm::vec3(0.0f, -4.0f, -4.0f)); // translate it down so it's at the center of the scene
+        model = glm::translate(model, glm::vec3(((int)(i % columns) - (int)(columns / 2)) * 12.0f, 0.0f, -(float)(i / columns) * 12.0f));
+        if ((i / columns) % 2)
+            model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f)); // every other row faces the other way
+        model = glm::scale(model, glm::vec3(0.02f, 0.02f, 0.02f));	// it's a bit too big for our scene, so scale it down
+        carModels.push_back(model);
+        carInstances.push_back(ModelInstance(model));
+    }
+    if (carCount > 1 && instancedCars)
+        ourModel.SetInstances(carInstances);
+
+    // uniform buffers: camera and light once per frame, a Draw block per mesh and car (and one for the lamp)
+    UniformBuffer frameUniforms;
+    frameUniforms.Generate(FRAME_UNIFORM_BINDING, sizeof(FrameUniforms));
+    UniformRing drawUniforms;
+    drawUniforms.Generate(DRAW_UNIFORM_BINDING, sizeof(DrawUniforms), (unsigned int)(carCount * ourModel.Meshes.size() + 1));
+
+    // draws sorted by program, texture, vertex array and depth before they are issued
+    RenderQueue renderQueue;
+    renderQueue.Program = lightingShader.ID;
+    RenderQueue *queue = sortedDraws ? &renderQueue : NULL;
+
+    // per mesh frustum culling of the instanced cars, on the GPU if the context can
+    InstanceCuller instanceCuller;
+    cullInstances = cullInstances && carCount > 1 && instancedCars && instanceCuller.Generate(gpuCulling);
+    if (cullInstances)
+        std::cout << "instance culling on the " << (instanceCuller.Gpu ? "GPU" : "CPU") << std::endl;
+    glm::mat4 lastView, lastProjection;
+
+    // rain in a cube around the camera, the drops the density asks for
+    RainSystem rain;
+    bool raining = rainDensity > 0.0f &&
+        rain.Generate(rainShader.ID, (GLuint)std::ceil(rainDensity * RAIN_EXTENT * RAIN_EXTENT * RAIN_EXTENT), RAIN_EXTENT,
+            FileSystem::getPath("resources/textures/Raindrops-Free-Download-PNG.png"));
+    if (raining)
+    {
+        rain.SetDensity(rainDensity);
+        std::cout << "rain: " << rain.Count << " drops in a " << RAIN_EXTENT << " unit cube around the camera" << std::endl;
+    }
+
+    // frame time and meshlet culling statistics, printed every second
+    MeshletCullStats cullStats;
+    unsigned int reportFrames = 0;
+    double submitMilliseconds = 0.0; // CPU time of the draw scope, what pooled and sorted draws save
+    double rainMilliseconds = 0.0;   // CPU time of the rain update
+    float lastReport = 0.0f;
+    ResetGLCallCount();
+    // CPU scopes and GPU passes of every frame, frame time percentiles are shown in the window title.
+    // Headless runs take the percentiles over all measured frames.
+    Profiler profiler(headless ? frameCount : PROFILER_WINDOW);
+    profiler.Recording = !tracePath.empty();
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    unsigned int totalFrames = headless ? WARMUP_FRAMES + frameCount : 0;
+    double gpuTotal = 0.0;
+    unsigned int gpuFrames = 0;
+
+    // the first time the uploader runs dry (later uploads are streamed levels)
+    bool texturesResident = false;
+
     // render loop
     // -----------
-    while (!glfwWindowShouldClose(window))
+    while (headless ? profiler.Frame < totalFrames : !glfwWindowShouldClose(window))
     {
         // per-frame time logic
         // --------------------
-        float currentFrame = glfwGetTime();
+        float currentFrame = headless ? std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count() : (float)glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        profiler.BeginFrame();
 
         // input
         // -----
-        processInput(window);
+        profiler.BeginScope("input");
+        if (headless)
+            FollowOrbitPath(camera, glm::vec3(0.0f, -4.0f, -4.0f), (float)profiler.Frame / totalFrames);
+        else
+            processInput(window);
+        profiler.EndScope();
+
+        // texture uploads
+        // ---------------
+        profiler.BeginScope("uploads");
+        bool uploading = textureUploader.Pending() > 0;
+        // the levels last frame's view asked for (all of them at once when headless)
+        if (headless)
+            textureStreamer.Finish();
+        else
+            textureStreamer.Update();
+        textureUploader.Update();
+        if (uploading && textureUploader.Pending() == 0 && !texturesResident)
+            std::cout << "textures resident after " << profiler.Frame + 1 << " frames" << std::endl;
+        texturesResident |= uploading && textureUploader.Pending() == 0;
+        profiler.EndScope();
 
         // render
         // ------
+        profiler.BeginPass("clear");
         glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        profiler.EndPass();
 
-        // be sure to activate shader when setting uniforms/drawing objects
-        lightingShader.use();
-        lightingShader.setVec3("lightColor", 1.0f, 1.0f, 1.0f);
-        lightingShader.setVec3("lightPos", lightPos);
-
-        // view/projection transformations
+        // view/projection transformations and the light, shared by all shaders through the Frame block
+        profiler.BeginScope("uniforms");
+        drawUniforms.BeginFrame();
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
         glm::mat4 view = camera.GetViewMatrix();
-        lightingShader.setMat4("projection", projection);
-        lightingShader.setMat4("view", view);
-
-        // world transformation
-        glm::mat4 model;
-        model = glm::translate(model, glm::vec3(0.0f, -4.0f, -4.0f)); // translate it down so it's at the center of the scene
-        model = glm::scale(model, glm::vec3(0.02f, 0.02f, 0.02f));	// it's a bit too big for our scene, so scale it down
-        lightingShader.setMat4("model", model);
-
-        // render the loaded model
-        ourModel.Draw(lightingShader);
+        lastView = view;
+        lastProjection = projection;
+        FrameUniforms frame;
+        frame.Projection = projection;
+        frame.View = view;
+        frame.ViewPosition = glm::vec4(camera.Position, 1.0f);
+        frame.LightPosition = glm::vec4(lightPos, 1.0f);
+        frame.LightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+        frameUniforms.Update(&frame);
+        profiler.EndScope();
+
+        // be sure to activate shader when drawing objects
+        profiler.BeginPass("cars");
+        profiler.BeginScope("draw");
+        std::chrono::steady_clock::time_point submitStart = std::chrono::steady_clock::now();
+        lightingShader.use();
+        renderQueue.Begin(camera.Position, 100.0f);
+
+        if (carCount == 1)
+        {
+            // world transformation
+            glm::mat4 model = carModels[0];
+
+            // render the loaded model at the level of detail its screen size needs, only its meshlets facing the camera and inside the frustum
+            ourModel.SelectLods(model, camera.Position, camera.Zoom, (float)SCR_HEIGHT);
+            ourModel.RequestTextureLevels(model, camera.Position, camera.Zoom, (float)SCR_HEIGHT);
+            ourModel.DrawCulled(drawUniforms, model, view, projection, cullStats, queue);
+        }
+        else
+        {
+            // all cars share the level of detail of the nearest one
+            unsigned int nearest = 0;
+            for (unsigned int i = 1; i < carCount; ++i)
+                if (glm::length(glm::vec3(carModels[i][3]) - camera.Position) < glm::length(glm::vec3(carModels[nearest][3]) - camera.Position))
+                    nearest = i;
+            ourModel.SelectLods(carModels[nearest], camera.Position, camera.Zoom, (float)SCR_HEIGHT);
+            ourModel.RequestTextureLevels(carModels[nearest], camera.Position, camera.Zoom, (float)SCR_HEIGHT);
+            if (cullInstances)
+                ourModel.DrawInstancesCulled(drawUniforms, view, projection, instanceCuller);
+            else if (instancedCars)
+                ourModel.DrawInstanced(drawUniforms, queue);
+            else
+            {
+                for (unsigned int i = 0; i < carCount; ++i)
+                    ourModel.Draw(drawUniforms, carModels[i], queue);
+            }
+        }
+        renderQueue.Submit(drawUniforms);
+        submitMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitStart).count();
+        profiler.EndScope();
+        profiler.EndPass();
+
+        // rain, over the cars
+        if (raining)
+        {
+            profiler.BeginScope("rain");
+            std::chrono::steady_clock::time_point rainStart = std::chrono::steady_clock::now();
+            rain.BeginFrame();
+            // headless runs step the rain a fixed 60th of a second, so their images repeat
+            rain.Update(headless ? 1.0f / 60.0f : deltaTime, camera.Position);
+            rainMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - rainStart).count();
+            profiler.EndScope();
+            profiler.BeginPass("rain");
+            rainShader.use();
+            rain.Draw();
+            rain.EndFrame();
+            profiler.EndPass();
+        }
+        reportFrames++;
+        if (currentFrame - lastReport >= 1.0f)
+        {
+            char title[128];
+            snprintf(title, sizeof(title), "LearnOpenGL - frame p50 %.2f / p95 %.2f / p99 %.2f ms, GPU %.2f ms",
+                profiler.FramePercentile(50.0f), profiler.FramePercentile(95.0f), profiler.FramePercentile(99.0f), profiler.GpuTime());
+            if (window)
+                glfwSetWindowTitle(window, title);
+            std::cout << carCount << (carCount == 1 ? " car" : instancedCars ? " cars, instanced" : " cars, individual draws") << ": "
+                << 1000.0f * (currentFrame - lastReport) / reportFrames << " ms per frame (p50 " << profiler.FramePercentile(50.0f)
+                << ", p95 " << profiler.FramePercentile(95.0f) << ", p99 " << profiler.FramePercentile(99.0f) << "), GPU "
+                << profiler.GpuTime() << " ms, " << GLCallCount() / reportFrames << " GL calls per frame, draw submission "
+                << submitMilliseconds / reportFrames << " ms" << (pooledDraws ? " (pooled)" : "");
+            if (carCount == 1)
+                std::cout << ", meshlets " << cullStats.Meshlets / reportFrames << ", back face culled " << cullStats.BackfaceCulled / reportFrames
+                    << ", frustum culled " << cullStats.FrustumCulled / reportFrames << ", triangles drawn " << cullStats.TrianglesDrawn / reportFrames
+                    << " / " << cullStats.Triangles / reportFrames << " in " << cullStats.Ranges / reportFrames << " ranges";
+            if (cullInstances)
+                std::cout << ", mesh instances visible " << instanceCuller.VisibleCount() << " / " << carCount * ourModel.Meshes.size();
+            if (raining)
+                std::cout << ", rain " << rain.Count << " drops, update " << rainMilliseconds / reportFrames << " ms";
+            if (sortedDraws)
+            {
+                const RenderQueueStats &queueStats = renderQueue.Stats;
+                std::cout << ", sorted draws " << queueStats.Draws / reportFrames << ", binds: program " << queueStats.ProgramBinds / reportFrames
+                    << ", texture " << queueStats.TextureBinds / reportFrames << ", vertex array " << queueStats.VertexArrayBinds / reportFrames
+                    << ", avoided " << queueStats.BindsAvoided / reportFrames;
+                renderQueue.ResetStats();
+            }
+            std::cout << ", textures " << textureStreamer.Stats.ResidentBytes / 1024 << " KB resident, " << textureStreamer.Stats.Pending
+                << " pending, " << textureStreamer.Stats.Promotions << " promotions, " << textureStreamer.Stats.Evictions << " evictions";
+            std::cout << std::endl;
+            cullStats = MeshletCullStats();
+            reportFrames = 0;
+            submitMilliseconds = 0.0;
+            rainMilliseconds = 0.0;
+            lastReport = currentFrame;
+            ResetGLCallCount();
+        }
 
         // also draw the lamp object
         // lampShader.use();
-        // lampShader.setMat4("projection", projection);
-        // lampShader.setMat4("view", view);
-        // model = glm::mat4();
-        // model = glm::translate(model, lightPos);
-        // model = glm::scale(model, glm::vec3(0.2f)); // a smaller cube
-        // lampShader.setMat4("model", model);
+        // DrawUniforms lamp;
+        // lamp.Model = glm::mat4();
+        // lamp.Model = glm::translate(lamp.Model, lightPos);
+        // lamp.Model = glm::scale(lamp.Model, glm::vec3(0.2f)); // a smaller cube
+        // drawUniforms.Push(&lamp);
 
         // glBindVertexArray(lightVAO);
         // glDrawArrays(GL_TRIANGLES, 0, 36);
 
 
+        drawUniforms.EndFrame();
+
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (!headless)
+        {
+            profiler.BeginScope("swap");
+            glfwSwapBuffers(window);
+            profiler.EndScope();
+            profiler.BeginScope("poll");
+            glfwPollEvents();
+            profiler.EndScope();
+        }
+        if (profiler.Frame >= WARMUP_FRAMES + PROFILER_LATENCY)
+        {
+            gpuTotal += profiler.GpuTime();
+            gpuFrames++;
+        }
+        profiler.EndFrame();
+    }
+    if (headless)
+    {
+        glFinish();
+        std::cout << "headless: " << frameCount << " frames (after " << WARMUP_FRAMES << " warm-up), frame average "
+            << profiler.FrameAverage() << " ms, p50 " << profiler.FramePercentile(50.0f) << ", p95 " << profiler.FramePercentile(95.0f)
+            << ", p99 " << profiler.FramePercentile(99.0f) << ", max " << profiler.FramePercentile(100.0f) << " ms, GPU average "
+            << (gpuFrames ? gpuTotal / gpuFrames : 0.0) << " ms, " << profiler.DroppedPasses << " GPU passes dropped" << std::endl;
+        std::cout << "headless: image checksum " << std::hex << offscreen.Checksum() << std::dec << std::endl;
+        if (!imagePath.empty() && offscreen.WritePPM(imagePath))
+            std::cout << "wrote " << imagePath << std::endl;
+        if (cullInstances && instanceCuller.Gpu)
+        {
+            // the CPU fallback has to pick the same mesh instances as the compute shader
+            InstanceCuller cpuCuller;
+            cpuCuller.Generate(false);
+            drawUniforms.BeginFrame();
+            ourModel.DrawInstancesCulled(drawUniforms, lastView, lastProjection, cpuCuller);
+            drawUniforms.EndFrame();
+            bool same = true;
+            for (unsigned int i = 0; i < ourModel.Meshes.size(); ++i)
+            {
+                std::vector<DrawElementsIndirectCommand> gpuCommands, cpuCommands;
+                instanceCuller.ReadCommands(i, gpuCommands);
+                cpuCuller.ReadCommands(i, cpuCommands);
+                // appended in no particular order on the GPU
+                std::sort(gpuCommands.begin(), gpuCommands.end(), [](const DrawElementsIndirectCommand &a, const DrawElementsIndirectCommand &b) {
+                    return a.BaseInstance < b.BaseInstance; });
+                same = same && gpuCommands.size() == cpuCommands.size() &&
+                    (gpuCommands.empty() || memcmp(&gpuCommands[0], &cpuCommands[0], gpuCommands.size() * sizeof(DrawElementsIndirectCommand)) == 0);
+            }
+            std::cout << "headless: GPU and CPU instance culling " << (same ? "agree" : "DIFFER") << " (" << cpuCuller.VisibleCount()
+                << " mesh instances visible)" << std::endl;
+        }
+    }
+    if (!tracePath.empty())
+    {
+        profiler.Flush();
+        bool csv = tracePath.compare(tracePath.size() - 4, 4, ".csv") == 0;
+        if (csv ? profiler.WriteCsv(tracePath) : profiler.WriteChromeTrace(tracePath))
+            std::cout << "wrote " << profiler.Frame << " frames to " << tracePath << std::endl;
     }
 
     // optional: de-allocate all resources once they've outlived their purpose:
@@ -225,7 +598,10 @@ int main()
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
-    glfwTerminate();
+    if (headless)
+        DestroyHeadlessContext();
+    else
+        glfwTerminate();
     return 0;
 }
 
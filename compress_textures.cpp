@@ -0,0 +1,82 @@
+// Offline texture compressor: builds (or refreshes) the BC1/BC3 texture cache of every diffuse
+// map of a model, as StaticModel would on its first load, so that the application starts
+// without decoding or encoding a single image. Prints the format and size of each map.
+//
+// usage: compress_textures [model.obj] [--force]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "mipmap.h"
+#include "obj_loader.h"
+#include "path_resolver.h"
+#include "texture_cache.h"
+#include "texture_loader.h"
+
+typedef std::chrono::steady_clock Clock;
+
+int main(int argc, char **argv)
+{
+    std::string path = "resources/objects/SUV_BF3/suv.obj";
+    bool force = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--force") == 0)
+            force = true;
+        else
+            path = argv[i];
+    }
+    std::string directory = path.substr(0, path.find_last_of('/'));
+
+    ModelData model;
+    if (!LoadObj(path, model))
+        return 1;
+    PathResolver resolver;
+    std::vector<std::string> paths;
+    for (unsigned int i = 0; i < model.Materials.size(); ++i)
+    {
+        std::string map = directory + '/' + resolver.Resolve(directory, model.Materials[i].DiffuseMap);
+        if (!model.Materials[i].DiffuseMap.empty() && std::find(paths.begin(), paths.end(), map) == paths.end())
+            paths.push_back(map);
+    }
+    // --force: drop the caches so every map is encoded again
+    if (force)
+        for (unsigned int i = 0; i < paths.size(); ++i)
+            remove(TextureCachePath(paths[i]).c_str());
+
+    // encode
+    // ------
+    std::vector<DecodedImage> images;
+    ThreadPool pool;
+    Clock::time_point start = Clock::now();
+    DecodeImages(paths, images, pool, TEXTURE_MIPMAPS | TEXTURE_COMPRESS);
+    pool.Wait();
+    double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    // report
+    // ------
+    size_t rawBytes = 0, blockBytes = 0;
+    for (unsigned int i = 0; i < images.size(); ++i)
+    {
+        const DecodedImage &image = images[i];
+        if (!image.Data || image.Format == BLOCK_NONE)
+        {
+            std::cout << "  " << image.Path << ": not compressed" << std::endl;
+            continue;
+        }
+        // what the chain takes as RGBA8 once uploaded, against its blocks
+        size_t raw = MipChainBytes(image.Width, image.Height, 4, image.Levels);
+        size_t blocks = CompressedChainBytes(image.Width, image.Height, image.Format, image.Levels);
+        rawBytes += raw;
+        blockBytes += blocks;
+        std::cout << "  " << image.Path << " " << image.Width << "x" << image.Height << "x" << image.Components << ", "
+            << image.Levels << " levels: " << (image.Format == BLOCK_BC1 ? "BC1" : "BC3") << " " << blocks / 1024 << " KB ("
+            << (double)raw / blocks << ":1 against RGBA8)" << (image.Cached ? ", cache up to date" : ", encoded") << std::endl;
+    }
+    FreeImages(images);
+    std::cout << paths.size() << " maps, " << rawBytes / 1024 << " KB -> " << blockBytes / 1024 << " KB in "
+        << milliseconds << " ms on " << pool.Size() << " threads" << std::endl;
+    return 0;
+}
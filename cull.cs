@@ -0,0 +1,76 @@
+#version 430 core
+// one invocation per instance (x) and mesh (y), instance_culler.h
+layout (local_size_x = 64) in;
+
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+struct CullMesh
+{
+    vec4 sphere;
+    uint count;
+    uint firstIndex;
+    int baseVertex;
+    uint padding;
+};
+
+// ModelInstance as uploaded for car.vs: model matrix, then normal matrix (25 floats)
+layout (std430, binding = 0) readonly buffer Instances
+{
+    float instances[];
+};
+layout (std430, binding = 1) readonly buffer Meshes
+{
+    CullMesh meshes[];
+};
+// instanceCount commands per mesh, the visible ones first
+layout (std430, binding = 2) writeonly buffer Commands
+{
+    DrawCommand commands[];
+};
+// draw count per mesh, zeroed before the dispatch
+layout (std430, binding = 3) buffer Counts
+{
+    uint counts[];
+};
+
+// world space frustum of projection * view, inward facing
+uniform vec4 planes[6];
+uniform uint instanceCount;
+uniform uint meshCount;
+
+void main()
+{
+    uint instance = gl_GlobalInvocationID.x;
+    uint mesh = gl_GlobalInvocationID.y;
+    if (instance >= instanceCount || mesh >= meshCount)
+        return;
+
+    uint base = instance * 25u;
+    mat4 model = mat4(instances[base + 0u], instances[base + 1u], instances[base + 2u], instances[base + 3u],
+                      instances[base + 4u], instances[base + 5u], instances[base + 6u], instances[base + 7u],
+                      instances[base + 8u], instances[base + 9u], instances[base + 10u], instances[base + 11u],
+                      instances[base + 12u], instances[base + 13u], instances[base + 14u], instances[base + 15u]);
+    CullMesh bounds = meshes[mesh];
+    vec3 center = vec3(model * vec4(bounds.sphere.xyz, 1.0));
+    float scale = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+    float radius = bounds.sphere.w * scale;
+    for (int i = 0; i < 6; ++i)
+        if (dot(planes[i].xyz, center) + planes[i].w <= -radius)
+            return;
+
+    uint slot = atomicAdd(counts[mesh], 1u);
+    DrawCommand command;
+    command.count = bounds.count;
+    command.instanceCount = 1u;
+    command.firstIndex = bounds.firstIndex;
+    command.baseVertex = bounds.baseVertex;
+    command.baseInstance = instance;
+    commands[mesh * instanceCount + slot] = command;
+}
@@ -0,0 +1,135 @@
+#include <cstddef>
+
+#include "gl_ext.h"
+#include "geometry_pool.h"
+#include "vertex_format.h"
+
+
+GeometryPool::GeometryPool()
+    : VAO(0), VBO(0), EBO(0), Format(VERTEX_FORMAT_FLOAT), IndexSize(4), IndexType(GL_UNSIGNED_INT), VertexBytes(0), IndexCount(0),
+      vertexEnd(0), indexEnd(0)
+{
+}
+
+void GeometryPool::Reserve(GLsizeiptr vertexBytes, GLsizei indexCount)
+{
+    this->VertexBytes += vertexBytes;
+    this->IndexCount += indexCount;
+}
+
+void GeometryPool::Generate(unsigned int format, GLsizei indexSize)
+{
+    this->Format = format;
+    this->IndexSize = indexSize;
+    this->IndexType = indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &this->VBO);
+    glGenBuffers(1, &this->EBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBufferData(GL_ARRAY_BUFFER, this->VertexBytes, NULL, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // the element buffer binding is vertex array state, SetupVertexArray binds it
+    this->SetupVertexArray(this->VAO, 0);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)this->IndexCount * indexSize, NULL, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+}
+
+void GeometryPool::Add(const void *vertices, GLsizeiptr vertexBytes, const void *indices, GLsizei indexCount, GLint &baseVertex, GLuint &firstIndex)
+{
+    baseVertex = (GLint)(this->vertexEnd / VertexStride(this->Format));
+    firstIndex = (GLuint)this->indexEnd;
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, this->vertexEnd, vertexBytes, vertices);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(this->VAO);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)this->indexEnd * this->IndexSize, (GLsizeiptr)indexCount * this->IndexSize, indices);
+    glBindVertexArray(0);
+    this->vertexEnd += vertexBytes;
+    this->indexEnd += indexCount;
+}
+
+void GeometryPool::SetupVertexArray(GLuint vertexArray, GLint baseVertex) const
+{
+    GLsizei stride = (GLsizei)VertexStride(this->Format);
+    size_t base = (size_t)baseVertex * stride;
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    if (this->Format == VERTEX_FORMAT_COMPACT)
+    {
+        // vertex positions (0..1 within the mesh bounds)
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)(base + offsetof(CompactVertex, Position)));
+        // vertex normals
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)(base + offsetof(CompactVertex, Normal)));
+        // vertex texture coords
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(CompactVertex, TexCoords)));
+    }
+    else
+    {
+        // vertex positions
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(MeshVertex, Position)));
+        // vertex normals
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(MeshVertex, Normal)));
+        // vertex texture coords
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(MeshVertex, TexCoords)));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+IndirectDrawBuffer::IndirectDrawBuffer() : ID(0), Indirect(false) { }
+
+void IndirectDrawBuffer::Generate()
+{
+    this->Indirect = glMultiDrawElementsIndirect != NULL;
+    if (this->Indirect)
+        glGenBuffers(1, &this->ID);
+}
+
+void IndirectDrawBuffer::Upload()
+{
+    if (!this->Indirect || this->Commands.empty())
+        return;
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, this->ID);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, this->Commands.size() * sizeof(DrawElementsIndirectCommand), &this->Commands[0], GL_STREAM_DRAW);
+}
+
+void IndirectDrawBuffer::Draw(const GeometryPool &pool, unsigned int first, unsigned int count)
+{
+    if (count == 0)
+        return;
+    if (this->Indirect)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, this->ID);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, pool.IndexType, (const void*)(first * sizeof(DrawElementsIndirectCommand)), (GLsizei)count, 0);
+        return;
+    }
+    this->counts.clear();
+    this->offsets.clear();
+    this->baseVertices.clear();
+    for (unsigned int i = first; i < first + count; ++i)
+    {
+        const DrawElementsIndirectCommand &command = this->Commands[i];
+        const void *offset = (const void*)((size_t)command.FirstIndex * pool.IndexSize);
+        if (command.BaseInstance != 0)
+        {
+            glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, (GLsizei)command.Count, pool.IndexType, offset,
+                (GLsizei)command.InstanceCount, command.BaseVertex, command.BaseInstance);
+            continue;
+        }
+        if (command.InstanceCount != 1)
+        {
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)command.Count, pool.IndexType, offset, (GLsizei)command.InstanceCount,
+                command.BaseVertex);
+            continue;
+        }
+        this->counts.push_back((GLsizei)command.Count);
+        this->offsets.push_back(offset);
+        this->baseVertices.push_back(command.BaseVertex);
+    }
+    if (!this->counts.empty())
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, &this->counts[0], pool.IndexType, &this->offsets[0], (GLsizei)this->counts.size(),
+            &this->baseVertices[0]);
+}
@@ -0,0 +1,73 @@
+#ifndef GEOMETRY_POOL_H
+#define GEOMETRY_POOL_H
+
+#include <glad/glad.h>
+
+#include <vector>
+
+// Layout of the commands glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand
+{
+    GLuint Count;
+    GLuint InstanceCount;
+    GLuint FirstIndex;   // In indices, not bytes
+    GLint BaseVertex;
+    GLuint BaseInstance; // First instance whose per-instance attributes are read (GL 4.2 / ARB_base_instance)
+};
+
+// Vertices and indices of many meshes sharing a vertex format and index size, packed into one
+// vertex buffer and one index buffer read through one vertex array. Meshes keep their indices
+// relative to their first vertex and draws add it as base vertex, so 16-bit indices stay 16-bit
+// however large the pool grows. Space for all meshes is reserved first, Generate allocates the
+// buffers and Add copies the meshes in.
+class GeometryPool
+{
+public:
+    GLuint VAO, VBO, EBO;
+    unsigned int Format;     // VERTEX_FORMAT_* of all vertices
+    GLsizei IndexSize;       // 2 or 4 bytes
+    GLenum IndexType;        // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    GLsizeiptr VertexBytes;  // Reserved so far
+    GLsizei IndexCount;
+    // Constructor (buffers created by Generate)
+    GeometryPool();
+    // Makes room for a mesh of vertexBytes and indexCount indices, before Generate
+    void Reserve(GLsizeiptr vertexBytes, GLsizei indexCount);
+    // Creates the buffers for everything reserved and the vertex array reading them
+    void Generate(unsigned int format, GLsizei indexSize);
+    // Copies a mesh after the previous ones, sets where its vertices and indices start
+    void Add(const void *vertices, GLsizeiptr vertexBytes, const void *indices, GLsizei indexCount, GLint &baseVertex, GLuint &firstIndex);
+    // Points the vertex attributes of vertexArray at the pool's vertices from baseVertex on
+    // (so draws need no base vertex) and binds the pool's index buffer to it, leaving it bound
+    void SetupVertexArray(GLuint vertexArray, GLint baseVertex) const;
+private:
+    GLsizeiptr vertexEnd;
+    GLsizei indexEnd;
+};
+
+// Indirect draw commands of a frame, uploaded with one buffer update and issued in batches
+// with glMultiDrawElementsIndirect (GL 4.3 / ARB_multi_draw_indirect). Without it, the same
+// batches go through glMultiDrawElementsBaseVertex, instanced commands one
+// glDrawElementsInstancedBaseVertex each (glDrawElementsInstancedBaseVertexBaseInstance if
+// their BaseInstance is set, which then has to be available).
+class IndirectDrawBuffer
+{
+public:
+    GLuint ID;
+    bool Indirect; // Whether the commands are read from the buffer by glMultiDrawElementsIndirect
+    std::vector<DrawElementsIndirectCommand> Commands;
+    // Constructor (buffer created by Generate)
+    IndirectDrawBuffer();
+    // Creates the buffer if the context can draw from it
+    void Generate();
+    // Uploads Commands, to fresh storage as the previous commands may still be read
+    void Upload();
+    // Draws count commands from first on out of pool, whose vertex array has to be bound
+    void Draw(const GeometryPool &pool, unsigned int first, unsigned int count);
+private:
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    std::vector<GLint> baseVertices;
+};
+
+#endif
@@ -0,0 +1,165 @@
+#include "gl_call_counter.h"
+#include "gl_ext.h"
+
+
+namespace {
+
+unsigned long callCount = 0;
+
+// Replaces the function pointer Slot with a thunk that counts and forwards the call
+template <typename Function, Function *Slot> struct CountedCall;
+template <typename R, typename... Args, R (APIENTRY **Slot)(Args...)>
+struct CountedCall<R (APIENTRY *)(Args...), Slot>
+{
+    static R (APIENTRY *original)(Args...);
+    static R APIENTRY Call(Args... args)
+    {
+        callCount++;
+        return original(args...);
+    }
+    static void Install()
+    {
+        if (*Slot && *Slot != &Call)
+        {
+            original = *Slot;
+            *Slot = &Call;
+        }
+    }
+};
+template <typename R, typename... Args, R (APIENTRY **Slot)(Args...)>
+R (APIENTRY *CountedCall<R (APIENTRY *)(Args...), Slot>::original)(Args...) = NULL;
+
+} // namespace
+
+#define COUNT_GL_CALLS(name) CountedCall<decltype(glad_##name), &glad_##name>::Install()
+
+void InstallGLCallCounter()
+{
+    // state
+    COUNT_GL_CALLS(glClear);
+    COUNT_GL_CALLS(glClearColor);
+    COUNT_GL_CALLS(glEnable);
+    COUNT_GL_CALLS(glDisable);
+    COUNT_GL_CALLS(glIsEnabled);
+    COUNT_GL_CALLS(glViewport);
+    COUNT_GL_CALLS(glBlendFunc);
+    COUNT_GL_CALLS(glDepthMask);
+    COUNT_GL_CALLS(glPolygonMode);
+    COUNT_GL_CALLS(glPixelStorei);
+    COUNT_GL_CALLS(glUseProgram);
+    COUNT_GL_CALLS(glBindVertexArray);
+    COUNT_GL_CALLS(glActiveTexture);
+    COUNT_GL_CALLS(glBindTexture);
+    COUNT_GL_CALLS(glGetBooleanv);
+    COUNT_GL_CALLS(glGetIntegerv);
+    COUNT_GL_CALLS(glGetFloatv);
+    COUNT_GL_CALLS(glGetString);
+    COUNT_GL_CALLS(glGetStringi);
+    COUNT_GL_CALLS(glFinish);
+    // uniforms
+    COUNT_GL_CALLS(glGetUniformLocation);
+    COUNT_GL_CALLS(glGetUniformBlockIndex);
+    COUNT_GL_CALLS(glUniformBlockBinding);
+    COUNT_GL_CALLS(glUniform1i);
+    COUNT_GL_CALLS(glUniform1ui);
+    COUNT_GL_CALLS(glUniform1f);
+    COUNT_GL_CALLS(glUniform2f);
+    COUNT_GL_CALLS(glUniform2fv);
+    COUNT_GL_CALLS(glUniform3f);
+    COUNT_GL_CALLS(glUniform3fv);
+    COUNT_GL_CALLS(glUniform4f);
+    COUNT_GL_CALLS(glUniform4fv);
+    COUNT_GL_CALLS(glUniformMatrix3fv);
+    COUNT_GL_CALLS(glUniformMatrix4fv);
+    // buffers
+    COUNT_GL_CALLS(glGenBuffers);
+    COUNT_GL_CALLS(glDeleteBuffers);
+    COUNT_GL_CALLS(glBindBuffer);
+    COUNT_GL_CALLS(glBindBufferBase);
+    COUNT_GL_CALLS(glBindBufferRange);
+    COUNT_GL_CALLS(glBufferData);
+    COUNT_GL_CALLS(glBufferStorage);
+    COUNT_GL_CALLS(glBufferSubData);
+    COUNT_GL_CALLS(glGetBufferSubData);
+    COUNT_GL_CALLS(glMapBufferRange);
+    COUNT_GL_CALLS(glUnmapBuffer);
+    COUNT_GL_CALLS(glFenceSync);
+    COUNT_GL_CALLS(glClientWaitSync);
+    COUNT_GL_CALLS(glDeleteSync);
+    // vertex arrays
+    COUNT_GL_CALLS(glGenVertexArrays);
+    COUNT_GL_CALLS(glDeleteVertexArrays);
+    COUNT_GL_CALLS(glEnableVertexAttribArray);
+    COUNT_GL_CALLS(glVertexAttribPointer);
+    COUNT_GL_CALLS(glVertexAttribDivisor);
+    // textures
+    COUNT_GL_CALLS(glGenTextures);
+    COUNT_GL_CALLS(glDeleteTextures);
+    COUNT_GL_CALLS(glTexImage2D);
+    COUNT_GL_CALLS(glTexStorage2D);
+    COUNT_GL_CALLS(glTexSubImage2D);
+    COUNT_GL_CALLS(glCompressedTexImage2D);
+    COUNT_GL_CALLS(glCompressedTexSubImage2D);
+    COUNT_GL_CALLS(glTexParameteri);
+    COUNT_GL_CALLS(glTexParameteriv);
+    COUNT_GL_CALLS(glTexParameterf);
+    COUNT_GL_CALLS(glTexBuffer);
+    COUNT_GL_CALLS(glGenerateMipmap);
+    // framebuffers
+    COUNT_GL_CALLS(glGenFramebuffers);
+    COUNT_GL_CALLS(glBindFramebuffer);
+    COUNT_GL_CALLS(glCheckFramebufferStatus);
+    COUNT_GL_CALLS(glGenRenderbuffers);
+    COUNT_GL_CALLS(glBindRenderbuffer);
+    COUNT_GL_CALLS(glRenderbufferStorage);
+    COUNT_GL_CALLS(glFramebufferRenderbuffer);
+    COUNT_GL_CALLS(glReadPixels);
+    // shaders
+    COUNT_GL_CALLS(glCreateShader);
+    COUNT_GL_CALLS(glShaderSource);
+    COUNT_GL_CALLS(glCompileShader);
+    COUNT_GL_CALLS(glGetShaderiv);
+    COUNT_GL_CALLS(glGetShaderInfoLog);
+    COUNT_GL_CALLS(glDeleteShader);
+    COUNT_GL_CALLS(glCreateProgram);
+    COUNT_GL_CALLS(glAttachShader);
+    COUNT_GL_CALLS(glTransformFeedbackVaryings);
+    COUNT_GL_CALLS(glLinkProgram);
+    COUNT_GL_CALLS(glGetProgramiv);
+    COUNT_GL_CALLS(glGetProgramInfoLog);
+    COUNT_GL_CALLS(glDeleteProgram);
+    // queries
+    COUNT_GL_CALLS(glGenQueries);
+    COUNT_GL_CALLS(glDeleteQueries);
+    COUNT_GL_CALLS(glBeginQuery);
+    COUNT_GL_CALLS(glEndQuery);
+    COUNT_GL_CALLS(glGetQueryObjectuiv);
+    COUNT_GL_CALLS(glGetQueryObjectui64v);
+    // draws
+    COUNT_GL_CALLS(glDrawArrays);
+    COUNT_GL_CALLS(glDrawArraysInstanced);
+    COUNT_GL_CALLS(glDrawElements);
+    COUNT_GL_CALLS(glDrawElementsInstanced);
+    COUNT_GL_CALLS(glMultiDrawElements);
+    COUNT_GL_CALLS(glDrawElementsBaseVertex);
+    COUNT_GL_CALLS(glDrawElementsInstancedBaseVertex);
+    COUNT_GL_CALLS(glMultiDrawElementsBaseVertex);
+    COUNT_GL_CALLS(glMultiDrawElementsIndirect);
+    COUNT_GL_CALLS(glDrawElementsInstancedBaseVertexBaseInstance);
+    COUNT_GL_CALLS(glMultiDrawElementsIndirectCount);
+    COUNT_GL_CALLS(glBeginTransformFeedback);
+    COUNT_GL_CALLS(glEndTransformFeedback);
+    // compute
+    COUNT_GL_CALLS(glDispatchCompute);
+    COUNT_GL_CALLS(glMemoryBarrier);
+}
+
+unsigned long GLCallCount()
+{
+    return callCount;
+}
+
+void ResetGLCallCount()
+{
+    callCount = 0;
+}
@@ -0,0 +1,12 @@
+#ifndef GL_CALL_COUNTER_H
+#define GL_CALL_COUNTER_H
+
+// Counts the GL calls the renderer makes, for per frame statistics. Installing wraps the
+// glad function pointer of every GL entry point the program calls, so the figure covers
+// the whole render loop; it has to happen after gladLoadGLLoader and LoadGLExtensions.
+void InstallGLCallCounter();
+// Calls made through the wrapped functions since installation or the last reset
+unsigned long GLCallCount();
+void ResetGLCallCount();
+
+#endif
@@ -0,0 +1,69 @@
+#include <cstring>
+#include <iostream>
+
+#include "gl_ext.h"
+
+
+PFNGLVERTEXATTRIBDIVISORPROC glad_glVertexAttribDivisor = NULL;
+PFNGLGETQUERYOBJECTUI64VPROC glad_glGetQueryObjectui64v = NULL;
+PFNGLBUFFERSTORAGEPROC glad_glBufferStorage = NULL;
+PFNGLTEXSTORAGE2DPROC glad_glTexStorage2D = NULL;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect = NULL;
+PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC glad_glDrawElementsInstancedBaseVertexBaseInstance = NULL;
+PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute = NULL;
+PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier = NULL;
+PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC glad_glMultiDrawElementsIndirectCount = NULL;
+
+bool LoadGLExtensions(GLADloadproc load)
+{
+    glad_glVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORPROC)load("glVertexAttribDivisor");
+    glad_glGetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VPROC)load("glGetQueryObjectui64v");
+    if (!glad_glVertexAttribDivisor || !glad_glGetQueryObjectui64v)
+    {
+        std::cout << "ERROR::GL_EXT: " << (glad_glVertexAttribDivisor ? "glGetQueryObjectui64v" : "glVertexAttribDivisor")
+            << " not available (OpenGL 3.3 required)" << std::endl;
+        return false;
+    }
+    if (HasGLSupport(4, 4, "GL_ARB_buffer_storage"))
+        glad_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)load("glBufferStorage");
+    if (HasGLSupport(4, 2, "GL_ARB_texture_storage"))
+        glad_glTexStorage2D = (PFNGLTEXSTORAGE2DPROC)load("glTexStorage2D");
+    if (HasGLSupport(4, 3, "GL_ARB_multi_draw_indirect"))
+        glad_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)load("glMultiDrawElementsIndirect");
+    if (HasGLSupport(4, 2, "GL_ARB_base_instance"))
+        glad_glDrawElementsInstancedBaseVertexBaseInstance =
+            (PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC)load("glDrawElementsInstancedBaseVertexBaseInstance");
+    if (HasGLSupport(4, 3, "GL_ARB_compute_shader") && HasGLSupport(4, 3, "GL_ARB_shader_storage_buffer_object"))
+    {
+        glad_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)load("glDispatchCompute");
+        glad_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)load("glMemoryBarrier");
+    }
+    // the extension's entry point has the ARB suffix
+    if (HasGLSupport(4, 6, NULL))
+        glad_glMultiDrawElementsIndirectCount = (PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC)load("glMultiDrawElementsIndirectCount");
+    else if (HasGLSupport(0, 0, "GL_ARB_indirect_parameters"))
+        glad_glMultiDrawElementsIndirectCount = (PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC)load("glMultiDrawElementsIndirectCountARB");
+    return true;
+}
+
+bool HasGLSupport(int major, int minor, const char *extension)
+{
+    if (major > 0 && (GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor)))
+        return true;
+    if (!extension)
+        return false;
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+        if (strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), extension) == 0)
+            return true;
+    return false;
+}
+
+GLfloat MaxTextureAnisotropy()
+{
+    GLfloat anisotropy = 1.0f;
+    if (HasGLSupport(4, 6, "GL_EXT_texture_filter_anisotropic") || HasGLSupport(4, 6, "GL_ARB_texture_filter_anisotropic"))
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &anisotropy);
+    return anisotropy;
+}
@@ -0,0 +1,179 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "headless.h"
+#include "mapped_file.h"
+
+#ifdef USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+
+#ifdef USE_EGL
+namespace {
+
+EGLDisplay display = EGL_NO_DISPLAY;
+EGLContext context = EGL_NO_CONTEXT;
+EGLSurface surface = EGL_NO_SURFACE;
+
+bool hasExtension(const char *extensions, const char *name)
+{
+    size_t length = strlen(name);
+    for (const char *found = extensions ? strstr(extensions, name) : NULL; found; found = strstr(found + length, name))
+        if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+            return true;
+    return false;
+}
+
+} // namespace
+#endif
+
+bool CreateHeadlessContext()
+{
+#ifdef USE_EGL
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLint major, minor;
+    // surfaceless: no window system at all
+    const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay && hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+    {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, &major, &minor) && eglBindAPI(EGL_OPENGL_API)
+            && hasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context"))
+        {
+            context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+            if (context != EGL_NO_CONTEXT && eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+                return true;
+        }
+        DestroyHeadlessContext();
+    }
+    // pbuffer on the default display
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cout << "ERROR::HEADLESS: no EGL display" << std::endl;
+        DestroyHeadlessContext();
+        return false;
+    }
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    const EGLint surfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    EGLConfig config;
+    EGLint configs = 0;
+    if (eglChooseConfig(display, configAttributes, &config, 1, &configs) && configs == 1)
+    {
+        surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+        if (surface != EGL_NO_SURFACE && context != EGL_NO_CONTEXT && eglMakeCurrent(display, surface, surface, context))
+            return true;
+    }
+    std::cout << "ERROR::HEADLESS: could not create an OpenGL 3.3 core context (EGL error 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+    DestroyHeadlessContext();
+    return false;
+#else
+    std::cout << "ERROR::HEADLESS: built without EGL (make headless)" << std::endl;
+    return false;
+#endif
+}
+
+void DestroyHeadlessContext()
+{
+#ifdef USE_EGL
+    if (display == EGL_NO_DISPLAY)
+        return;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context != EGL_NO_CONTEXT)
+        eglDestroyContext(display, context);
+    if (surface != EGL_NO_SURFACE)
+        eglDestroySurface(display, surface);
+    eglTerminate(display);
+    display = EGL_NO_DISPLAY;
+    context = EGL_NO_CONTEXT;
+    surface = EGL_NO_SURFACE;
+#endif
+}
+
+void *HeadlessProcAddress(const char *name)
+{
+#ifdef USE_EGL
+    return (void*)eglGetProcAddress(name);
+#else
+    return NULL;
+#endif
+}
+
+OffscreenTarget::OffscreenTarget() : FBO(0), Color(0), Depth(0), Width(0), Height(0) { }
+
+bool OffscreenTarget::Generate(GLsizei width, GLsizei height)
+{
+    this->Width = width;
+    this->Height = height;
+    glGenFramebuffers(1, &this->FBO);
+    glGenRenderbuffers(1, &this->Color);
+    glGenRenderbuffers(1, &this->Depth);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->Color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->Color);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->Depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, this->Depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR::HEADLESS: framebuffer is not complete" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void OffscreenTarget::Bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+    glViewport(0, 0, this->Width, this->Height);
+}
+
+void OffscreenTarget::ReadPixels(std::vector<unsigned char> &pixels) const
+{
+    pixels.resize((size_t)this->Width * this->Height * 3);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, this->FBO);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, this->Width, this->Height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+}
+
+uint64_t OffscreenTarget::Checksum() const
+{
+    std::vector<unsigned char> pixels;
+    this->ReadPixels(pixels);
+    return HashBytes(&pixels[0], pixels.size());
+}
+
+bool OffscreenTarget::WritePPM(const std::string &path) const
+{
+    std::vector<unsigned char> pixels;
+    this->ReadPixels(pixels);
+    std::ofstream file(path.c_str(), std::ios::binary);
+    if (!file)
+    {
+        std::cout << "ERROR::HEADLESS: could not write " << path << std::endl;
+        return false;
+    }
+    file << "P6\n" << this->Width << ' ' << this->Height << "\n255\n";
+    // PPM rows go top down
+    for (GLsizei y = this->Height - 1; y >= 0; --y)
+        file.write((const char*)&pixels[(size_t)y * this->Width * 3], this->Width * 3);
+    return file.good();
+}
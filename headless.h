@@ -0,0 +1,41 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <glad/glad.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Headless rendering for benchmark runs on machines without a display (or a GPU):
+// an EGL context without a window and a framebuffer object to draw into. EGL is only
+// compiled in with USE_EGL (make headless), otherwise CreateHeadlessContext fails.
+
+// Creates a GL 3.3 core context and makes it current: surfaceless on Mesa
+// (EGL_MESA_platform_surfaceless, works with llvmpipe), a 1x1 pbuffer otherwise
+bool CreateHeadlessContext();
+void DestroyHeadlessContext();
+// Entry point loader for gladLoadGLLoader and LoadGLExtensions
+void *HeadlessProcAddress(const char *name);
+
+// Color and depth renderbuffers the headless programs draw into instead of a window
+class OffscreenTarget
+{
+public:
+    GLuint FBO, Color, Depth;
+    GLsizei Width, Height;
+    // Constructor (objects created by Generate)
+    OffscreenTarget();
+    // Creates the framebuffer, returns false if it is incomplete
+    bool Generate(GLsizei width, GLsizei height);
+    // Binds the framebuffer and sets the viewport to it
+    void Bind() const;
+    // Reads back the color buffer, RGB rows bottom up
+    void ReadPixels(std::vector<unsigned char> &pixels) const;
+    // Hash of the color buffer, equal across runs that rendered the same image
+    uint64_t Checksum() const;
+    // Writes the color buffer as a binary PPM
+    bool WritePPM(const std::string &path) const;
+};
+
+#endif
@@ -0,0 +1,231 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "gl_ext.h"
+#include "instance_culler.h"
+
+
+// cull.cs reads the instance buffer as 25 floats per instance
+static_assert(sizeof(ModelInstance) == 25 * sizeof(float), "ModelInstance is not tightly packed");
+
+// Compiles and links the compute shader at path, 0 (and the log printed) on failure
+static GLuint loadComputeProgram(const char *path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::INSTANCE_CULLER: Failed to read " << path << std::endl;
+        return 0;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    std::string code = stream.str();
+    const char *source = code.c_str();
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    GLint success;
+    char infoLog[1024];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+        std::cout << "ERROR::INSTANCE_CULLER: Failed to compile " << path << "\n" << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, shader);
+    glLinkProgram(program);
+    glDeleteShader(shader);
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+        std::cout << "ERROR::INSTANCE_CULLER: Failed to link " << path << "\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// The test of cull.cs: whether the bounding sphere of mesh, placed by model, is inside frustum
+static bool sphereVisible(const CullMesh &mesh, const glm::mat4 &model, const Frustum &frustum)
+{
+    glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(mesh.Sphere), 1.0f));
+    float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    float radius = mesh.Sphere.w * scale;
+    for (int i = 0; i < 6; ++i)
+        if (glm::dot(glm::vec3(frustum.Planes[i]), center) + frustum.Planes[i].w <= -radius)
+            return false;
+    return true;
+}
+
+InstanceCuller::InstanceCuller()
+    : Program(0), MeshBuffer(0), CommandBuffer(0), CountBuffer(0), Gpu(false), meshCount(0), instanceCount(0), meshCapacity(0),
+      commandCapacity(0), planesLocation(-1), instanceCountLocation(-1), meshCountLocation(-1)
+{
+}
+
+bool InstanceCuller::Generate(bool gpu, const char *computePath)
+{
+    this->Gpu = false;
+    if (gpu && glDispatchCompute && glMultiDrawElementsIndirectCount && glMultiDrawElementsIndirect)
+    {
+        this->Program = loadComputeProgram(computePath);
+        this->Gpu = this->Program != 0;
+    }
+    if (this->Gpu)
+    {
+        this->planesLocation = glGetUniformLocation(this->Program, "planes");
+        this->instanceCountLocation = glGetUniformLocation(this->Program, "instanceCount");
+        this->meshCountLocation = glGetUniformLocation(this->Program, "meshCount");
+        glGenBuffers(1, &this->MeshBuffer);
+        glGenBuffers(1, &this->CommandBuffer);
+        glGenBuffers(1, &this->CountBuffer);
+        return true;
+    }
+    // the CPU path draws its commands through an IndirectDrawBuffer, which needs base instances
+    this->indirect.Generate();
+    if (!this->indirect.Indirect && !glDrawElementsInstancedBaseVertexBaseInstance)
+    {
+        std::cout << "ERROR::INSTANCE_CULLER: Base instances not available (OpenGL 4.2 or ARB_base_instance required)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void InstanceCuller::Cull(const std::vector<CullMesh> &meshes, const std::vector<ModelInstance> &instances, GLuint instanceBuffer,
+    const glm::mat4 &viewProjection)
+{
+    this->meshCount = (unsigned int)meshes.size();
+    this->instanceCount = (unsigned int)instances.size();
+    Frustum frustum = ExtractFrustum(viewProjection);
+    if (this->Gpu)
+        this->cullGpu(meshes, instanceBuffer, frustum);
+    else
+        this->cullCpu(meshes, instances, frustum);
+}
+
+void InstanceCuller::Draw(unsigned int mesh, const GeometryPool &pool)
+{
+    if (this->instanceCount == 0)
+        return;
+    if (!this->Gpu)
+    {
+        this->indirect.Draw(pool, mesh * this->instanceCount, this->counts[mesh]);
+        return;
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, this->CommandBuffer);
+    glBindBuffer(GL_PARAMETER_BUFFER, this->CountBuffer);
+    glMultiDrawElementsIndirectCount(GL_TRIANGLES, pool.IndexType,
+        (const void*)((size_t)mesh * this->instanceCount * sizeof(DrawElementsIndirectCommand)), (GLintptr)(mesh * sizeof(GLuint)),
+        (GLsizei)this->instanceCount, 0);
+    glBindBuffer(GL_PARAMETER_BUFFER, 0);
+}
+
+void InstanceCuller::ReadCommands(unsigned int mesh, std::vector<DrawElementsIndirectCommand> &commands) const
+{
+    commands.clear();
+    if (mesh >= this->meshCount || this->instanceCount == 0)
+        return;
+    size_t first = (size_t)mesh * this->instanceCount;
+    if (!this->Gpu)
+    {
+        commands.assign(this->indirect.Commands.begin() + first, this->indirect.Commands.begin() + first + this->counts[mesh]);
+        return;
+    }
+    GLuint count = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->CountBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, (GLintptr)(mesh * sizeof(GLuint)), sizeof(GLuint), &count);
+    commands.resize(count);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->CommandBuffer);
+    if (count > 0)
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, (GLintptr)(first * sizeof(DrawElementsIndirectCommand)),
+            count * sizeof(DrawElementsIndirectCommand), &commands[0]);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+unsigned int InstanceCuller::VisibleCount() const
+{
+    std::vector<GLuint> counts(this->meshCount, 0);
+    if (!this->Gpu)
+        counts.assign(this->counts.begin(), this->counts.end());
+    else if (this->meshCount > 0)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->CountBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, this->meshCount * sizeof(GLuint), &counts[0]);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+    unsigned int visible = 0;
+    for (unsigned int i = 0; i < counts.size(); ++i)
+        visible += counts[i];
+    return visible;
+}
+
+void InstanceCuller::cullGpu(const std::vector<CullMesh> &meshes, GLuint instanceBuffer, const Frustum &frustum)
+{
+    if (this->meshCount == 0 || this->instanceCount == 0)
+        return;
+    // grow the buffers to this frame's meshes and instances, the counts start at 0 every frame
+    GLsizeiptr meshBytes = this->meshCount * sizeof(CullMesh);
+    GLsizeiptr commandBytes = (GLsizeiptr)this->meshCount * this->instanceCount * sizeof(DrawElementsIndirectCommand);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->MeshBuffer);
+    if (meshBytes > this->meshCapacity)
+    {
+        glBufferData(GL_SHADER_STORAGE_BUFFER, meshBytes, &meshes[0], GL_DYNAMIC_DRAW);
+        this->meshCapacity = meshBytes;
+    }
+    else
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, meshBytes, &meshes[0]);
+    if (commandBytes > this->commandCapacity)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->CommandBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, commandBytes, NULL, GL_DYNAMIC_DRAW);
+        this->commandCapacity = commandBytes;
+    }
+    std::vector<GLuint> zeros(this->meshCount, 0);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->CountBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, this->meshCount * sizeof(GLuint), &zeros[0], GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // the draws that follow use the caller's program
+    GLint program = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glUseProgram(this->Program);
+    glUniform4fv(this->planesLocation, 6, &frustum.Planes[0][0]);
+    glUniform1ui(this->instanceCountLocation, this->instanceCount);
+    glUniform1ui(this->meshCountLocation, this->meshCount);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, this->MeshBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, this->CommandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, this->CountBuffer);
+    glDispatchCompute((this->instanceCount + INSTANCE_CULL_GROUP_SIZE - 1) / INSTANCE_CULL_GROUP_SIZE, this->meshCount, 1);
+    glUseProgram((GLuint)program);
+    // the draws read the commands and counts as indirect parameters, ReadCommands reads them back
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+void InstanceCuller::cullCpu(const std::vector<CullMesh> &meshes, const std::vector<ModelInstance> &instances, const Frustum &frustum)
+{
+    DrawElementsIndirectCommand unused = { 0, 0, 0, 0, 0 };
+    this->indirect.Commands.assign((size_t)this->meshCount * this->instanceCount, unused);
+    this->counts.assign(this->meshCount, 0);
+    for (unsigned int mesh = 0; mesh < this->meshCount; ++mesh)
+    {
+        DrawElementsIndirectCommand *commands = this->indirect.Commands.empty() ? NULL : &this->indirect.Commands[(size_t)mesh * this->instanceCount];
+        for (unsigned int instance = 0; instance < this->instanceCount; ++instance)
+        {
+            if (!sphereVisible(meshes[mesh], instances[instance].Model, frustum))
+                continue;
+            DrawElementsIndirectCommand &command = commands[this->counts[mesh]++];
+            command.Count = meshes[mesh].Count;
+            command.InstanceCount = 1;
+            command.FirstIndex = meshes[mesh].FirstIndex;
+            command.BaseVertex = meshes[mesh].BaseVertex;
+            command.BaseInstance = instance;
+        }
+    }
+    this->indirect.Upload();
+}
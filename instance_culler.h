@@ -0,0 +1,66 @@
+#ifndef INSTANCE_CULLER_H
+#define INSTANCE_CULLER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "geometry_pool.h"
+#include "static_model.h"
+
+// Instances per work group of cull.cs (its local_size_x)
+const GLuint INSTANCE_CULL_GROUP_SIZE = 64;
+
+// std430 layout of a mesh read by cull.cs: bounding sphere in model space and the command
+// drawing its current level of detail out of its geometry pool
+struct CullMesh
+{
+    glm::vec4 Sphere; // Center, radius
+    GLuint Count, FirstIndex;
+    GLint BaseVertex;
+    GLuint Padding;
+};
+
+// Culls the instances of a model per mesh against the view frustum and builds the indirect
+// commands drawing the visible ones. Every mesh owns a range of as many commands as there are
+// instances, filled from its start with one command per visible instance (BaseInstance picks
+// its per-instance attributes), and a draw count. On the GPU (GL 4.3 compute shaders, GL 4.6 /
+// ARB_indirect_parameters) cull.cs tests every instance and mesh pair and appends with atomicAdd
+// on the draw counts, which glMultiDrawElementsIndirectCount reads without a round trip through
+// the CPU. Otherwise the same test runs on the CPU and the commands are uploaded, drawn through
+// an IndirectDrawBuffer. Both give the same commands per mesh, the GPU in no particular order.
+class InstanceCuller
+{
+public:
+    GLuint Program;   // cull.cs, 0 when culling on the CPU
+    GLuint MeshBuffer, CommandBuffer, CountBuffer;
+    bool Gpu;         // Whether Cull runs the compute shader
+    // Constructor (buffers and program created by Generate)
+    InstanceCuller();
+    // Compiles computePath and creates the buffers if gpu is asked for and the context can run
+    // it, culls on the CPU otherwise. False if neither works (no base instance before GL 4.2).
+    bool Generate(bool gpu = true, const char *computePath = "cull.cs");
+    // Culls instances (also in instanceBuffer, as StaticModel::SetInstances uploads them)
+    // against the frustum of viewProjection for every mesh
+    void Cull(const std::vector<CullMesh> &meshes, const std::vector<ModelInstance> &instances, GLuint instanceBuffer,
+        const glm::mat4 &viewProjection);
+    // Draws the visible instances of mesh out of pool (its vertex array bound)
+    void Draw(unsigned int mesh, const GeometryPool &pool);
+    // Commands of mesh written by the last Cull, read back from the GPU if culled there (stalls)
+    void ReadCommands(unsigned int mesh, std::vector<DrawElementsIndirectCommand> &commands) const;
+    // Visible instance and mesh pairs of the last Cull, read back from the GPU if culled there (stalls)
+    unsigned int VisibleCount() const;
+private:
+    unsigned int meshCount, instanceCount;
+    GLsizeiptr meshCapacity, commandCapacity; // Bytes of the buffers, grown by Cull
+    IndirectDrawBuffer indirect;              // Commands of the CPU path
+    std::vector<unsigned int> counts;         // Visible instances per mesh (CPU path)
+    GLint planesLocation, instanceCountLocation, meshCountLocation;
+    // Runs cull.cs over all pairs
+    void cullGpu(const std::vector<CullMesh> &meshes, GLuint instanceBuffer, const Frustum &frustum);
+    // The same test on the CPU
+    void cullCpu(const std::vector<CullMesh> &meshes, const std::vector<ModelInstance> &instances, const Frustum &frustum);
+};
+
+#endif
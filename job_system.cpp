@@ -0,0 +1,150 @@
+#include "job_system.h"
+
+
+// The job system and queue of the calling thread if it is a worker
+static thread_local const JobSystem *currentSystem = NULL;
+static thread_local unsigned int currentQueue = 0;
+
+JobSystem::JobSystem(unsigned int threads)
+    : queued(0), unfinished(0), stopping(false)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+    unsigned int workers = threads - 1;
+    // a queue per worker and one shared by all other threads
+    for (unsigned int i = 0; i <= workers; ++i)
+        this->queues.push_back(new Queue());
+    for (unsigned int i = 0; i < workers; ++i)
+        this->workers.push_back(std::thread(&JobSystem::run, this, i));
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    for (unsigned int i = 0; i < this->workers.size(); ++i)
+        this->workers[i].join();
+    for (unsigned int i = 0; i < this->queues.size(); ++i)
+        delete this->queues[i];
+}
+
+Job *JobSystem::Create(const std::function<void()> &task)
+{
+    Job *job = new Job();
+    job->Task = task;
+    job->Waiting = 1;
+    return job;
+}
+
+void JobSystem::DependsOn(Job *job, Job *dependency)
+{
+    job->Waiting++;
+    dependency->Dependents.push_back(job);
+}
+
+void JobSystem::Submit(Job *job)
+{
+    this->unfinished++;
+    if (--job->Waiting == 0)
+        this->push(job);
+}
+
+void JobSystem::Wait()
+{
+    unsigned int index = this->queueIndex();
+    while (this->unfinished > 0)
+    {
+        Job *job = this->find(index);
+        if (job)
+        {
+            this->execute(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(this->sleepMutex);
+        this->wake.wait(lock, [this]() { return this->queued > 0 || this->unfinished == 0; });
+    }
+}
+
+void JobSystem::run(unsigned int index)
+{
+    currentSystem = this;
+    currentQueue = index;
+    for (;;)
+    {
+        Job *job = this->find(index);
+        if (job)
+        {
+            this->execute(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(this->sleepMutex);
+        this->wake.wait(lock, [this]() { return this->stopping || this->queued > 0; });
+        if (this->stopping)
+            return;
+    }
+}
+
+unsigned int JobSystem::queueIndex() const
+{
+    return currentSystem == this ? currentQueue : (unsigned int)this->workers.size();
+}
+
+void JobSystem::push(Job *job)
+{
+    Queue *queue = this->queues[this->queueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue->Mutex);
+        queue->Jobs.push_back(job);
+    }
+    this->queued++;
+    // taking the lock orders the count with a sleeper testing it
+    {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+    }
+    this->wake.notify_one();
+}
+
+Job *JobSystem::find(unsigned int index)
+{
+    unsigned int count = (unsigned int)this->queues.size();
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        Queue *queue = this->queues[(index + i) % count];
+        std::lock_guard<std::mutex> lock(queue->Mutex);
+        if (queue->Jobs.empty())
+            continue;
+        Job *job;
+        if (i == 0)
+        {
+            job = queue->Jobs.back();
+            queue->Jobs.pop_back();
+        }
+        else
+        {
+            job = queue->Jobs.front();
+            queue->Jobs.pop_front();
+        }
+        this->queued--;
+        return job;
+    }
+    return NULL;
+}
+
+void JobSystem::execute(Job *job)
+{
+    job->Task();
+    for (unsigned int i = 0; i < job->Dependents.size(); ++i)
+        if (--job->Dependents[i]->Waiting == 0)
+            this->push(job->Dependents[i]);
+    delete job;
+    if (--this->unfinished == 0)
+    {
+        std::lock_guard<std::mutex> lock(this->sleepMutex);
+        this->wake.notify_all();
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A task run by JobSystem once the jobs it depends on have finished
+struct Job
+{
+    std::function<void()> Task;
+    std::atomic<int> Waiting;      // Unfinished dependencies, plus 1 until submitted
+    std::vector<Job*> Dependents;  // Jobs waiting for this one
+};
+
+// JobSystem runs jobs on worker threads, each with its own deque: a worker pushes the jobs it
+// submits (and the ones its jobs release) to the back of its deque and pops from the back, so
+// related work stays on one core, and steals from the front of the others' deques when its own
+// is empty. The thread calling Wait helps the same way. Jobs declare their dependencies before
+// either is submitted and start when all of them finished; they may submit more jobs.
+class JobSystem
+{
+public:
+    // Constructor, threads running jobs counting the one calling Wait (threads - 1 workers),
+    // 0 means one per hardware thread
+    JobSystem(unsigned int threads = 0);
+    ~JobSystem();
+    // Creates a job running task, which starts once submitted and its dependencies finished
+    Job *Create(const std::function<void()> &task);
+    // Makes job wait for dependency, both created and not submitted yet
+    void DependsOn(Job *job, Job *dependency);
+    // Lets job run once its dependencies finished, the job is deleted after it ran
+    void Submit(Job *job);
+    // Runs jobs on the calling thread until every submitted job has finished
+    void Wait();
+    // Number of worker threads (the thread calling Wait runs jobs too)
+    unsigned int Size() const { return (unsigned int)this->workers.size(); }
+private:
+    // Jobs ready to run of a thread, the last one for threads that are not workers
+    struct Queue
+    {
+        std::deque<Job*> Jobs;
+        std::mutex Mutex;
+    };
+    std::vector<std::thread> workers;
+    std::vector<Queue*> queues;
+    std::atomic<unsigned int> queued;   // Jobs in all queues
+    std::atomic<unsigned int> unfinished;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping;
+    void run(unsigned int index);
+    // Index of the calling thread's queue
+    unsigned int queueIndex() const;
+    void push(Job *job);
+    // Pops a job from the back of the own queue or steals one from the front of another, NULL if all are empty
+    Job *find(unsigned int index);
+    void execute(Job *job);
+    JobSystem(const JobSystem &);
+    JobSystem &operator=(const JobSystem &);
+};
+
+#endif
@@ -1,9 +1,24 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// camera and light, shared by all shaders (uniform_buffer.h)
+layout (std140) uniform Frame
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
+// per draw
+layout (std140) uniform Draw
+{
+    mat4 model;
+    mat3 normalMatrix; // inverse transpose of model
+    vec4 positionScale;
+    vec4 positionOffset;
+    bool instanced;
+};
 
 void main()
 {
@@ -0,0 +1,126 @@
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.h"
+
+
+#ifdef _WIN32
+MappedFile::MappedFile()
+    : data(NULL), size(0), file(INVALID_HANDLE_VALUE), mapping(NULL)
+{
+}
+#else
+MappedFile::MappedFile()
+    : data(NULL), size(0), fd(-1)
+{
+}
+#endif
+
+MappedFile::~MappedFile()
+{
+    this->Close();
+}
+
+bool MappedFile::Open(const std::string &path)
+{
+    this->Close();
+#ifdef _WIN32
+    this->file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (this->file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(this->file, &fileSize))
+    {
+        this->Close();
+        return false;
+    }
+    this->size = (size_t)fileSize.QuadPart;
+    // an empty file can't be mapped, but it is still a valid (empty) file
+    if (this->size == 0)
+        return true;
+    this->mapping = CreateFileMappingA(this->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (this->mapping == NULL)
+    {
+        this->Close();
+        return false;
+    }
+    this->data = (const char*)MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (this->data == NULL)
+    {
+        this->Close();
+        return false;
+    }
+#else
+    this->fd = open(path.c_str(), O_RDONLY);
+    if (this->fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(this->fd, &st) != 0)
+    {
+        this->Close();
+        return false;
+    }
+    this->size = (size_t)st.st_size;
+    if (this->size == 0)
+        return true;
+    void *ptr = mmap(NULL, this->size, PROT_READ, MAP_PRIVATE, this->fd, 0);
+    if (ptr == MAP_FAILED)
+    {
+        this->Close();
+        return false;
+    }
+    // we read everything front to back (parsing or glBufferData), let the kernel read ahead
+    madvise(ptr, this->size, MADV_SEQUENTIAL);
+    madvise(ptr, this->size, MADV_WILLNEED);
+    this->data = (const char*)ptr;
+#endif
+    return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+    if (this->data)
+        UnmapViewOfFile(this->data);
+    if (this->mapping)
+        CloseHandle(this->mapping);
+    if (this->file != INVALID_HANDLE_VALUE)
+        CloseHandle(this->file);
+    this->mapping = NULL;
+    this->file = INVALID_HANDLE_VALUE;
+#else
+    if (this->data)
+        munmap((void*)this->data, this->size);
+    if (this->fd >= 0)
+        close(this->fd);
+    this->fd = -1;
+#endif
+    this->data = NULL;
+    this->size = 0;
+}
+
+bool StatFile(const std::string &path, int64_t &mtime, uint64_t &size)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return false;
+    mtime = (int64_t)st.st_mtime;
+    size = (uint64_t)st.st_size;
+    return true;
+}
+
+uint64_t HashBytes(const void *data, size_t size, uint64_t seed)
+{
+    const unsigned char *bytes = (const unsigned char*)data;
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
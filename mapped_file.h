@@ -0,0 +1,50 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#endif
+
+// MappedFile maps a whole file read-only into the address space so its
+// contents can be handed to GL (or parsed) straight from the page cache.
+class MappedFile
+{
+public:
+    // Constructor (nothing mapped)
+    MappedFile();
+    ~MappedFile();
+    // Maps the file at path, closing any previous mapping first
+    bool Open(const std::string &path);
+    // Unmaps the file
+    void Close();
+    // Start of the mapped bytes (NULL if nothing is mapped or the file is empty)
+    const char *Data() const { return this->data; }
+    // Size of the mapped file in bytes
+    size_t Size() const { return this->size; }
+private:
+    const char *data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+    // Mappings own OS handles and can't be copied
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+};
+
+// Retrieves modification time (seconds since epoch) and size of a file
+bool StatFile(const std::string &path, int64_t &mtime, uint64_t &size);
+// 64-bit FNV-1a hash of a block of memory
+uint64_t HashBytes(const void *data, size_t size, uint64_t seed = 14695981039346656037ULL);
+
+#endif
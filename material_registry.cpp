@@ -0,0 +1,52 @@
+#include <cctype>
+
+#include "mapped_file.h"
+#include "material_registry.h"
+
+
+// Diffuse map path as compared: lower case with '/' separators
+static std::string mapKey(const std::string &path)
+{
+    std::string key = path;
+    for (size_t i = 0; i < key.size(); ++i)
+        key[i] = key[i] == '\\' ? '/' : (char)tolower((unsigned char)key[i]);
+    return key;
+}
+
+static bool sameMaterial(const MeshMaterial &a, const MeshMaterial &b)
+{
+    return a.Ambient == b.Ambient && a.Diffuse == b.Diffuse && a.Specular == b.Specular && a.Illum == b.Illum &&
+        mapKey(a.DiffuseMap) == mapKey(b.DiffuseMap);
+}
+
+static uint64_t hashMaterial(const MeshMaterial &material)
+{
+    float colors[9] = { material.Ambient.x, material.Ambient.y, material.Ambient.z, material.Diffuse.x, material.Diffuse.y,
+        material.Diffuse.z, material.Specular.x, material.Specular.y, material.Specular.z };
+    std::string map = mapKey(material.DiffuseMap);
+    uint64_t hash = HashBytes(colors, sizeof(colors));
+    hash = HashBytes(&material.Illum, sizeof(material.Illum), hash);
+    return HashBytes(map.data(), map.size(), hash);
+}
+
+MaterialRegistry::MaterialRegistry()
+    : Duplicates(0)
+{
+}
+
+unsigned int MaterialRegistry::Add(const MeshMaterial &material)
+{
+    uint64_t hash = hashMaterial(material);
+    std::pair<std::multimap<uint64_t, unsigned int>::iterator, std::multimap<uint64_t, unsigned int>::iterator> range = this->byHash.equal_range(hash);
+    for (std::multimap<uint64_t, unsigned int>::iterator it = range.first; it != range.second; ++it)
+    {
+        if (sameMaterial(this->Materials[it->second], material))
+        {
+            this->Duplicates++;
+            return it->second;
+        }
+    }
+    this->Materials.push_back(material);
+    this->byHash.insert(std::make_pair(hash, (unsigned int)this->Materials.size() - 1));
+    return (unsigned int)this->Materials.size() - 1;
+}
@@ -0,0 +1,29 @@
+#ifndef MATERIAL_REGISTRY_H
+#define MATERIAL_REGISTRY_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "model_data.h"
+
+// Collapses materials with the same parameters and diffuse map (compared ignoring case and
+// separator style, as PathResolver matches them) into one, whatever their names: exporters
+// like ZModeler write a material per object, so a model's meshes end up sharing a handful
+// of distinct ones. Each distinct material is kept once, under the name it was first added
+// with, and is looked up through a hash of its parameters.
+class MaterialRegistry
+{
+public:
+    std::vector<MeshMaterial> Materials; // Distinct materials in order of first addition
+    unsigned int Duplicates;             // Materials Add folded into an existing one
+    // Constructor (empty registry)
+    MaterialRegistry();
+    // Index in Materials of material, added if no equal one is registered yet
+    unsigned int Add(const MeshMaterial &material);
+private:
+    std::multimap<uint64_t, unsigned int> byHash;
+};
+
+#endif
@@ -0,0 +1,370 @@
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "mesh_cache.h"
+#include "path_resolver.h"
+
+
+static std::string directoryOf(const std::string &path)
+{
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+}
+
+static std::string fileNameOf(const std::string &path)
+{
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+static void copyString(char *dst, size_t capacity, const std::string &src)
+{
+    size_t length = src.size() < capacity - 1 ? src.size() : capacity - 1;
+    memcpy(dst, src.c_str(), length);
+    dst[length] = '\0';
+}
+
+static uint64_t alignUp(uint64_t offset)
+{
+    return (offset + 15) & ~(uint64_t)15;
+}
+
+// Collects the file names of all 'mtllib' statements of an .obj file
+static void findMaterialLibraries(const char *data, size_t size, std::vector<std::string> &libraries)
+{
+    const char *end = data + size;
+    for (const char *line = data; line < end; )
+    {
+        const char *eol = (const char*)memchr(line, '\n', end - line);
+        if (!eol)
+            eol = end;
+        if (eol - line > 7 && strncmp(line, "mtllib", 6) == 0 && (line[6] == ' ' || line[6] == '\t'))
+        {
+            const char *p = line + 7;
+            while (p < eol)
+            {
+                while (p < eol && (*p == ' ' || *p == '\t' || *p == '\r'))
+                    ++p;
+                const char *start = p;
+                while (p < eol && *p != ' ' && *p != '\t' && *p != '\r')
+                    ++p;
+                if (p > start)
+                    libraries.push_back(std::string(start, p));
+            }
+        }
+        line = eol + 1;
+    }
+}
+
+// Fills in stat and content hash of directory/name
+static bool describeSource(const std::string &directory, const std::string &name, MeshCacheSource &source)
+{
+    std::string path = directory + "/" + name;
+    memset(&source, 0, sizeof(source));
+    copyString(source.Path, sizeof(source.Path), name);
+    if (!StatFile(path, source.MTime, source.Size))
+        return false;
+    MappedFile file;
+    if (!file.Open(path))
+        return false;
+    source.Hash = HashBytes(file.Data(), file.Size());
+    return true;
+}
+
+// Records mtime as the timestamp of source index of the cache at cachePath, best effort
+static void recordMTime(const std::string &cachePath, unsigned int index, int64_t mtime)
+{
+    FILE *file = fopen(cachePath.c_str(), "r+b");
+    if (!file)
+        return;
+    long offset = (long)(offsetof(MeshCacheHeader, Sources) + index * sizeof(MeshCacheSource) + offsetof(MeshCacheSource, MTime));
+    if (fseek(file, offset, SEEK_SET) == 0)
+        fwrite(&mtime, sizeof(mtime), 1, file);
+    fclose(file);
+}
+
+std::string MeshCache::CachePath(const std::string &sourcePath, const MeshProcessingOptions &options)
+{
+    // one file per set of options, so programs processing the model differently don't rebuild each other's cache
+    char hash[17];
+    snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)HashOptions(options));
+    return sourcePath + "." + hash + ".meshcache";
+}
+
+bool MeshCache::Load(const std::string &sourcePath, const MeshProcessingOptions &options)
+{
+    // a fresh cache that fails validation (truncated, written by a broken build) is rebuilt too
+    if (IsFresh(sourcePath, options) && this->Map(CachePath(sourcePath, options)))
+        return true;
+    ModelData model;
+    if (!LoadProcessedModel(sourcePath, model, options))
+        return false;
+    if (!Write(sourcePath, model, options))
+        return false;
+    return this->Map(CachePath(sourcePath, options));
+}
+
+bool MeshCache::Map(const std::string &cachePath)
+{
+    if (!this->file.Open(cachePath))
+        return false;
+    const char *data = this->file.Data();
+    uint64_t size = this->file.Size();
+    bool valid = size >= sizeof(MeshCacheHeader);
+    if (valid)
+    {
+        const MeshCacheHeader &header = *(const MeshCacheHeader*)data;
+        valid = header.Magic == MESH_CACHE_MAGIC && header.Version == MESH_CACHE_VERSION &&
+            header.MaterialOffset + (uint64_t)header.MaterialCount * sizeof(MeshCacheMaterial) <= size &&
+            header.MeshOffset + (uint64_t)header.MeshCount * sizeof(MeshCacheMesh) <= size;
+        for (unsigned int i = 0; valid && i < header.MeshCount; ++i)
+        {
+            const MeshCacheMesh &mesh = this->Mesh(i);
+            // index type and vertex layout go straight to GL, a foreign cache of the right size must not pass
+            valid = mesh.Material < header.MaterialCount && (mesh.IndexSize == 2 || mesh.IndexSize == 4) &&
+                (mesh.VertexFormat == VERTEX_FORMAT_FLOAT || mesh.VertexFormat == VERTEX_FORMAT_COMPACT) &&
+                mesh.VertexStride == VertexStride(mesh.VertexFormat) &&
+                mesh.VertexOffset + (uint64_t)mesh.VertexCount * mesh.VertexStride <= size &&
+                mesh.IndexOffset + (uint64_t)mesh.IndexCount * mesh.IndexSize <= size &&
+                mesh.MeshletOffset + (uint64_t)mesh.MeshletCount * sizeof(Meshlet) <= size &&
+                mesh.LodOffset + (uint64_t)mesh.LodCount * sizeof(MeshLod) <= size;
+            // meshlets and levels of detail are drawn straight from the index buffer, they must stay inside it
+            const Meshlet *meshlets = this->Meshlets(i);
+            for (unsigned int m = 0; valid && m < mesh.MeshletCount; ++m)
+                valid = meshlets[m].IndexOffset + 3 * (uint64_t)meshlets[m].TriangleCount <= mesh.IndexCount;
+            const MeshLod *lods = this->Lods(i);
+            for (unsigned int l = 0; valid && l < mesh.LodCount; ++l)
+                valid = (uint64_t)lods[l].IndexOffset + lods[l].IndexCount <= mesh.IndexCount;
+        }
+    }
+    if (!valid)
+    {
+        std::cout << "ERROR::MESH_CACHE: Invalid or outdated cache file " << cachePath << std::endl;
+        this->file.Close();
+    }
+    return valid;
+}
+
+void MeshCache::Close()
+{
+    this->file.Close();
+}
+
+const MeshCacheHeader &MeshCache::Header() const
+{
+    return *(const MeshCacheHeader*)this->file.Data();
+}
+
+const MeshCacheMaterial &MeshCache::Material(unsigned int index) const
+{
+    return ((const MeshCacheMaterial*)(this->file.Data() + this->Header().MaterialOffset))[index];
+}
+
+const MeshCacheMesh &MeshCache::Mesh(unsigned int index) const
+{
+    return ((const MeshCacheMesh*)(this->file.Data() + this->Header().MeshOffset))[index];
+}
+
+const void *MeshCache::Vertices(unsigned int mesh) const
+{
+    return this->file.Data() + this->Mesh(mesh).VertexOffset;
+}
+
+const void *MeshCache::Indices(unsigned int mesh) const
+{
+    return this->file.Data() + this->Mesh(mesh).IndexOffset;
+}
+
+const Meshlet *MeshCache::Meshlets(unsigned int mesh) const
+{
+    return (const Meshlet*)(this->file.Data() + this->Mesh(mesh).MeshletOffset);
+}
+
+const MeshLod *MeshCache::Lods(unsigned int mesh) const
+{
+    return (const MeshLod*)(this->file.Data() + this->Mesh(mesh).LodOffset);
+}
+
+bool MeshCache::Write(const std::string &sourcePath, const ModelData &model, const MeshProcessingOptions &options)
+{
+    std::string directory = directoryOf(sourcePath);
+    // 1. record the files the cache depends on: the model and its material libraries
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.Magic = MESH_CACHE_MAGIC;
+    header.Version = MESH_CACHE_VERSION;
+    header.OptionsHash = HashOptions(options);
+    if (!describeSource(directory, fileNameOf(sourcePath), header.Sources[0]))
+    {
+        std::cout << "ERROR::MESH_CACHE: Failed to read source file " << sourcePath << std::endl;
+        return false;
+    }
+    header.SourceCount = 1;
+    {
+        MappedFile source;
+        std::vector<std::string> libraries;
+        if (source.Open(sourcePath))
+            findMaterialLibraries(source.Data(), source.Size(), libraries);
+        // recorded as spelled on disk, as the loader opened them
+        PathResolver resolver;
+        for (unsigned int i = 0; i < libraries.size() && header.SourceCount < MESH_CACHE_MAX_SOURCES; ++i)
+            if (describeSource(directory, resolver.Resolve(directory, libraries[i]), header.Sources[header.SourceCount]))
+                header.SourceCount++;
+    }
+    // 2. lay out tables and blobs
+    header.MaterialCount = (uint32_t)model.Materials.size();
+    header.MeshCount = (uint32_t)model.Meshes.size();
+    header.MaterialOffset = alignUp(sizeof(MeshCacheHeader));
+    header.MeshOffset = alignUp(header.MaterialOffset + header.MaterialCount * sizeof(MeshCacheMaterial));
+    uint64_t offset = alignUp(header.MeshOffset + header.MeshCount * sizeof(MeshCacheMesh));
+
+    std::vector<MeshCacheMaterial> materials(header.MaterialCount);
+    for (unsigned int i = 0; i < header.MaterialCount; ++i)
+    {
+        const MeshMaterial &src = model.Materials[i];
+        MeshCacheMaterial &dst = materials[i];
+        memset(&dst, 0, sizeof(dst));
+        copyString(dst.Name, sizeof(dst.Name), src.Name);
+        copyString(dst.DiffuseMap, sizeof(dst.DiffuseMap), src.DiffuseMap);
+        for (int c = 0; c < 3; ++c)
+        {
+            dst.Ambient[c] = src.Ambient[c];
+            dst.Diffuse[c] = src.Diffuse[c];
+            dst.Specular[c] = src.Specular[c];
+        }
+        dst.Illum = src.Illum;
+    }
+    std::vector<MeshCacheMesh> meshes(header.MeshCount);
+    for (unsigned int i = 0; i < header.MeshCount; ++i)
+    {
+        const MeshData &src = model.Meshes[i];
+        MeshCacheMesh &dst = meshes[i];
+        memset(&dst, 0, sizeof(dst));
+        copyString(dst.Name, sizeof(dst.Name), src.Name);
+        dst.Material = src.Material;
+        dst.VertexCount = (uint32_t)src.Vertices.size();
+        dst.VertexFormat = src.Format;
+        dst.VertexStride = VertexStride(src.Format);
+        for (int c = 0; c < 3; ++c)
+        {
+            dst.PositionScale[c] = src.PositionScale[c];
+            dst.PositionOffset[c] = src.PositionOffset[c];
+        }
+        dst.IndexCount = (uint32_t)src.Indices.size();
+        dst.IndexSize = IndexSizeFor(src.Vertices.size());
+        dst.MeshletCount = (uint32_t)src.Meshlets.size();
+        dst.LodCount = (uint32_t)src.Lods.size();
+        for (int c = 0; c < 3; ++c)
+            dst.Center[c] = src.Center[c];
+        dst.Radius = src.Radius;
+        dst.VertexOffset = offset;
+        offset = alignUp(offset + (uint64_t)dst.VertexCount * dst.VertexStride);
+        dst.IndexOffset = offset;
+        offset = alignUp(offset + (uint64_t)dst.IndexCount * dst.IndexSize);
+        dst.MeshletOffset = offset;
+        offset = alignUp(offset + (uint64_t)dst.MeshletCount * sizeof(Meshlet));
+        dst.LodOffset = offset;
+        offset = alignUp(offset + (uint64_t)dst.LodCount * sizeof(MeshLod));
+    }
+    // 3. write to a temporary file and move it in place so readers never see a partial cache
+    std::string cachePath = CachePath(sourcePath, options);
+    std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "ERROR::MESH_CACHE: Failed to create " << tempPath << std::endl;
+            return false;
+        }
+        static const char padding[16] = { 0 };
+        std::vector<unsigned char> vertices, indices;
+        uint64_t written = 0;
+        out.write((const char*)&header, sizeof(header));
+        written += sizeof(header);
+        out.write(padding, header.MaterialOffset - written);
+        if (header.MaterialCount)
+            out.write((const char*)&materials[0], header.MaterialCount * sizeof(MeshCacheMaterial));
+        written = header.MaterialOffset + header.MaterialCount * sizeof(MeshCacheMaterial);
+        out.write(padding, header.MeshOffset - written);
+        if (header.MeshCount)
+            out.write((const char*)&meshes[0], header.MeshCount * sizeof(MeshCacheMesh));
+        written = header.MeshOffset + header.MeshCount * sizeof(MeshCacheMesh);
+        for (unsigned int i = 0; i < header.MeshCount; ++i)
+        {
+            const MeshData &src = model.Meshes[i];
+            out.write(padding, meshes[i].VertexOffset - written);
+            PackVertices(src, vertices);
+            if (!vertices.empty())
+                out.write((const char*)&vertices[0], vertices.size());
+            written = meshes[i].VertexOffset + vertices.size();
+            out.write(padding, meshes[i].IndexOffset - written);
+            PackIndices(src.Indices, meshes[i].IndexSize, indices);
+            if (!indices.empty())
+                out.write((const char*)&indices[0], indices.size());
+            written = meshes[i].IndexOffset + indices.size();
+            out.write(padding, meshes[i].MeshletOffset - written);
+            if (!src.Meshlets.empty())
+                out.write((const char*)&src.Meshlets[0], src.Meshlets.size() * sizeof(Meshlet));
+            written = meshes[i].MeshletOffset + src.Meshlets.size() * sizeof(Meshlet);
+            out.write(padding, meshes[i].LodOffset - written);
+            if (!src.Lods.empty())
+                out.write((const char*)&src.Lods[0], src.Lods.size() * sizeof(MeshLod));
+            written = meshes[i].LodOffset + src.Lods.size() * sizeof(MeshLod);
+        }
+        if (!out)
+        {
+            std::cout << "ERROR::MESH_CACHE: Failed to write " << tempPath << std::endl;
+            return false;
+        }
+    }
+    remove(cachePath.c_str());
+    if (rename(tempPath.c_str(), cachePath.c_str()) != 0)
+    {
+        std::cout << "ERROR::MESH_CACHE: Failed to move " << tempPath << " to " << cachePath << std::endl;
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool MeshCache::IsFresh(const std::string &sourcePath, const MeshProcessingOptions &options)
+{
+    std::string cachePath = CachePath(sourcePath, options);
+    MappedFile cache;
+    if (!cache.Open(cachePath) || cache.Size() < sizeof(MeshCacheHeader))
+        return false;
+    const MeshCacheHeader &header = *(const MeshCacheHeader*)cache.Data();
+    if (header.Magic != MESH_CACHE_MAGIC || header.Version != MESH_CACHE_VERSION || header.OptionsHash != HashOptions(options) ||
+        header.SourceCount == 0 || header.SourceCount > MESH_CACHE_MAX_SOURCES)
+        return false;
+    std::string directory = directoryOf(sourcePath);
+    std::vector<unsigned int> touched;
+    std::vector<int64_t> mtimes;
+    for (unsigned int i = 0; i < header.SourceCount; ++i)
+    {
+        const MeshCacheSource &recorded = header.Sources[i];
+        std::string path = directory + "/" + std::string(recorded.Path, strnlen(recorded.Path, sizeof(recorded.Path)));
+        int64_t mtime;
+        uint64_t size;
+        if (!StatFile(path, mtime, size) || size != recorded.Size)
+            return false;
+        // same timestamp and size: trust it without reading the file
+        if (mtime == recorded.MTime)
+            continue;
+        // touched (checkout, copy) but possibly unchanged: compare contents
+        MappedFile source;
+        if (!source.Open(path) || HashBytes(source.Data(), source.Size()) != recorded.Hash)
+            return false;
+        touched.push_back(i);
+        mtimes.push_back(mtime);
+    }
+    // unchanged after all: record the new timestamps so later launches skip the hashing again
+    cache.Close();
+    for (size_t i = 0; i < touched.size(); ++i)
+        recordMTime(cachePath, touched[i], mtimes[i]);
+    return true;
+}
@@ -0,0 +1,103 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <stdint.h>
+#include <string>
+
+#include "mapped_file.h"
+#include "mesh_processing.h"
+#include "model_data.h"
+
+// On-disk layout of a compiled model (<model>.<options hash>.meshcache, written next to the source).
+// All offsets are from the start of the file, every blob is 16 byte aligned so vertex
+// and index data can be passed to glBufferData directly from the mapping.
+const uint32_t MESH_CACHE_MAGIC = 0x4853454D; // "MESH"
+const uint32_t MESH_CACHE_VERSION = 12;
+const unsigned int MESH_CACHE_MAX_SOURCES = 4;
+
+// A file the cache was built from (the model itself and its material libraries)
+struct MeshCacheSource
+{
+    char Path[256]; // Relative to the model directory
+    int64_t MTime;
+    uint64_t Size;
+    uint64_t Hash;
+};
+
+struct MeshCacheHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t SourceCount;
+    uint32_t MaterialCount;
+    uint32_t MeshCount;
+    uint32_t Reserved;
+    uint64_t OptionsHash;    // Processing options the meshes were built with
+    uint64_t MaterialOffset; // MeshCacheMaterial[MaterialCount]
+    uint64_t MeshOffset;     // MeshCacheMesh[MeshCount]
+    MeshCacheSource Sources[MESH_CACHE_MAX_SOURCES];
+};
+
+struct MeshCacheMaterial
+{
+    char Name[64];
+    char DiffuseMap[256];
+    float Ambient[3];
+    float Diffuse[3];
+    float Specular[3];
+    int32_t Illum;
+};
+
+struct MeshCacheMesh
+{
+    char Name[64];
+    uint32_t Material;
+    uint32_t VertexCount;
+    uint32_t VertexStride; // VertexStride(VertexFormat)
+    uint32_t IndexCount;
+    uint32_t IndexSize;    // 2 or 4 bytes
+    uint32_t VertexFormat; // VERTEX_FORMAT_FLOAT or VERTEX_FORMAT_COMPACT
+    float PositionScale[3];  // Dequantization of compact positions
+    float PositionOffset[3];
+    uint32_t MeshletCount;
+    uint32_t LodCount;
+    float Center[3];         // Bounding sphere
+    float Radius;
+    uint64_t VertexOffset;
+    uint64_t IndexOffset;    // All levels of detail
+    uint64_t MeshletOffset;  // Meshlet[MeshletCount]
+    uint64_t LodOffset;      // MeshLod[LodCount]
+};
+
+// MeshCache maps the compiled binary copy of a model file into memory.
+// Loading it involves no parsing and no copies: the accessors point into the mapping.
+class MeshCache
+{
+public:
+    // Maps the cache belonging to sourcePath, (re)building it first if it is missing, stale or fails Map
+    bool Load(const std::string &sourcePath, const MeshProcessingOptions &options = MeshProcessingOptions());
+    // Maps an existing cache file without checking it against its sources, false if its tables or
+    // the meshlet and level of detail ranges point outside the file or the index buffers
+    bool Map(const std::string &cachePath);
+    // Unmaps the cache
+    void Close();
+    // Accessors into the mapped cache
+    const MeshCacheHeader &Header() const;
+    const MeshCacheMaterial &Material(unsigned int index) const;
+    const MeshCacheMesh &Mesh(unsigned int index) const;
+    const void *Vertices(unsigned int mesh) const;
+    const void *Indices(unsigned int mesh) const;
+    const Meshlet *Meshlets(unsigned int mesh) const;
+    const MeshLod *Lods(unsigned int mesh) const;
+    // Compiles model (loaded from sourcePath and processed with options) into the cache file for sourcePath
+    static bool Write(const std::string &sourcePath, const ModelData &model, const MeshProcessingOptions &options);
+    // Returns true if the cache for sourcePath exists, was built with options and still matches its source files.
+    // Sources touched but unchanged get their new timestamps written back, so only the first check hashes them.
+    static bool IsFresh(const std::string &sourcePath, const MeshProcessingOptions &options);
+    // Location of the cache file belonging to sourcePath processed with options
+    static std::string CachePath(const std::string &sourcePath, const MeshProcessingOptions &options);
+private:
+    MappedFile file;
+};
+
+#endif
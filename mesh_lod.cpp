@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <cmath>
+
+#include "mesh_lod.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplify.h"
+
+
+// A level that keeps more than this fraction of the previous one isn't worth its memory
+static const float MIN_SHRINK = 0.9f;
+
+void BuildLods(MeshData &mesh, unsigned int levels, float reduction, float maxError)
+{
+    mesh.Lods.clear();
+    if (mesh.Indices.empty())
+        return;
+    // bounding sphere, also used to pick levels at runtime
+    glm::vec3 lower = mesh.Vertices[0].Position, upper = lower;
+    for (size_t i = 1; i < mesh.Vertices.size(); ++i)
+    {
+        lower = glm::min(lower, mesh.Vertices[i].Position);
+        upper = glm::max(upper, mesh.Vertices[i].Position);
+    }
+    mesh.Center = (lower + upper) * 0.5f;
+    mesh.Radius = glm::length(upper - lower) * 0.5f;
+
+    MeshLod base = { 0, (unsigned int)mesh.Indices.size(), 0.0f };
+    mesh.Lods.push_back(base);
+    std::vector<unsigned int> current(mesh.Indices), simplified;
+    float error = 0.0f;
+    for (unsigned int level = 1; level < levels; ++level)
+    {
+        float budget = maxError * mesh.Radius - error;
+        if (budget <= 0.0f)
+            break;
+        size_t target = (size_t)(current.size() / 3 * reduction) * 3;
+        float levelError = SimplifyMesh(current, mesh.Vertices, target, budget, simplified);
+        if (simplified.size() > current.size() * MIN_SHRINK)
+            break;
+        OptimizeVertexCache(simplified, mesh.Vertices.size());
+        // each level is simplified from the previous one, adding their bounds keeps a bound
+        error += levelError;
+        MeshLod lod = { (unsigned int)mesh.Indices.size(), (unsigned int)simplified.size(), error };
+        mesh.Lods.push_back(lod);
+        mesh.Indices.insert(mesh.Indices.end(), simplified.begin(), simplified.end());
+        current.swap(simplified);
+    }
+}
+
+unsigned int SelectLod(const MeshLod *lods, unsigned int count, float distance, float scale, float zoom, float viewportHeight, float pixelError)
+{
+    if (distance <= 0.0f)
+        return 0;
+    // pixels covered by one world unit at distance
+    float pixelsPerUnit = viewportHeight / (2.0f * distance * tanf(glm::radians(zoom) * 0.5f));
+    unsigned int lod = 0;
+    for (unsigned int i = 1; i < count; ++i)
+        if (lods[i].Error * scale * pixelsPerUnit <= pixelError)
+            lod = i;
+    return lod;
+}
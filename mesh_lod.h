@@ -0,0 +1,19 @@
+#ifndef MESH_LOD_H
+#define MESH_LOD_H
+
+#include <vector>
+
+#include "model_data.h"
+
+// Appends simplified copies of mesh (levels - 1 of them, each with about reduction times
+// the triangles of the previous one) to mesh.Indices and describes all levels, the original
+// included, in mesh.Lods. Levels share the vertex buffer. The chain ends early when a level
+// would exceed maxError (relative to the mesh's bounding radius) or stops shrinking.
+// Also sets mesh.Center and mesh.Radius.
+void BuildLods(MeshData &mesh, unsigned int levels, float reduction, float maxError);
+// Picks the coarsest of count levels whose error (MeshLod::Error), projected to the screen, is
+// at most pixelError pixels: vertices move at most that far from the original's planes. distance is from the camera to the mesh in world units, scale the
+// model matrix's scale, zoom the vertical field of view in degrees (Camera::Zoom).
+unsigned int SelectLod(const MeshLod *lods, unsigned int count, float distance, float scale, float zoom, float viewportHeight, float pixelError);
+
+#endif
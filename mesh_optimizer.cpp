@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <cmath>
+
+#include "mesh_optimizer.h"
+
+
+namespace {
+
+// Forsyth scoring parameters, tuned for a 32 entry LRU model of the cache
+const int MODEL_CACHE_SIZE = 32;
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+float vertexScore(int cachePosition, unsigned int remaining)
+{
+    if (remaining == 0)
+        return -1.0f;
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // the three vertices of the last triangle get a fixed score so the next one doesn't just reuse them
+        if (cachePosition < 3)
+            score = LAST_TRIANGLE_SCORE;
+        else
+            score = powf(1.0f - (float)(cachePosition - 3) / (MODEL_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+    }
+    // favour vertices with few triangles left, so they get finished off
+    return score + VALENCE_BOOST_SCALE * powf((float)remaining, -VALENCE_BOOST_POWER);
+}
+
+struct Cluster
+{
+    size_t Begin, End; // Triangle range
+    float Sort;
+};
+
+bool sortsBefore(const Cluster &a, const Cluster &b)
+{
+    return a.Sort > b.Sort;
+}
+
+// FIFO cache simulation that can be flushed, a vertex is cached as long as
+// fewer than Size misses happened since it was loaded
+class FifoCache
+{
+public:
+    FifoCache(size_t vertexCount, unsigned int size) : stamps(vertexCount, 0), time(size + 1), size(size) { }
+    // Returns the number of vertices of triangle that missed
+    unsigned int Add(const unsigned int *triangle)
+    {
+        unsigned int misses = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            if (this->time - this->stamps[triangle[k]] > this->size)
+            {
+                this->stamps[triangle[k]] = this->time++;
+                misses++;
+            }
+        }
+        return misses;
+    }
+    void Flush() { this->time += this->size + 1; }
+private:
+    std::vector<unsigned int> stamps;
+    unsigned int time, size;
+};
+
+} // namespace
+
+VertexCacheStats SimulateVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize, bool lru)
+{
+    VertexCacheStats stats;
+    stats.Misses = 0;
+    std::vector<bool> referenced(vertexCount, false);
+    if (lru)
+    {
+        std::vector<unsigned int> cache;
+        cache.reserve(cacheSize + 1);
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            unsigned int vertex = indices[i];
+            referenced[vertex] = true;
+            std::vector<unsigned int>::iterator it = std::find(cache.begin(), cache.end(), vertex);
+            if (it != cache.end())
+                cache.erase(it);
+            else
+                stats.Misses++;
+            cache.insert(cache.begin(), vertex);
+            if (cache.size() > cacheSize)
+                cache.pop_back();
+        }
+    }
+    else
+    {
+        // a vertex is in the FIFO as long as fewer than cacheSize misses happened since it was loaded
+        std::vector<unsigned int> stamps(vertexCount, 0);
+        unsigned int time = cacheSize + 1;
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            unsigned int vertex = indices[i];
+            referenced[vertex] = true;
+            if (time - stamps[vertex] > cacheSize)
+            {
+                stamps[vertex] = time++;
+                stats.Misses++;
+            }
+        }
+    }
+    size_t used = std::count(referenced.begin(), referenced.end(), true);
+    size_t triangles = indices.size() / 3;
+    stats.ACMR = triangles ? (float)stats.Misses / triangles : 0.0f;
+    stats.ATVR = used ? (float)stats.Misses / used : 0.0f;
+    return stats;
+}
+
+void OptimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+    // triangles of every vertex, packed (remaining ones first)
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        remaining[indices[i]]++;
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+        offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    {
+        std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; ++i)
+            adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        score[v] = vertexScore(-1, remaining[v]);
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    int best = 0;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+        if (triangleScore[t] > triangleScore[best])
+            best = (int)t;
+    }
+
+    std::vector<unsigned int> output;
+    output.reserve(triangleCount * 3);
+    std::vector<unsigned int> cache, newCache;
+    size_t nextUnemitted = 0;
+    while (output.size() < triangleCount * 3)
+    {
+        if (best < 0)
+        {
+            // dead end: nothing in the cache has triangles left, continue in input order
+            while (emitted[nextUnemitted])
+                nextUnemitted++;
+            best = (int)nextUnemitted;
+        }
+        const unsigned int *triangle = &indices[best * 3];
+        emitted[best] = true;
+        newCache.assign(triangle, triangle + 3);
+        for (int k = 0; k < 3; ++k)
+        {
+            output.push_back(triangle[k]);
+            // remove the triangle from the vertex' remaining list
+            unsigned int vertex = triangle[k];
+            unsigned int *begin = &adjacency[offsets[vertex]];
+            unsigned int *end = begin + remaining[vertex];
+            *std::find(begin, end, (unsigned int)best) = end[-1];
+            remaining[vertex]--;
+        }
+        for (size_t i = 0; i < cache.size(); ++i)
+            if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2])
+                newCache.push_back(cache[i]);
+        // vertices pushed out of the modelled cache lose their cache score
+        for (size_t i = MODEL_CACHE_SIZE; i < newCache.size(); ++i)
+        {
+            cachePosition[newCache[i]] = -1;
+            score[newCache[i]] = vertexScore(-1, remaining[newCache[i]]);
+        }
+        if (newCache.size() > (size_t)MODEL_CACHE_SIZE)
+            newCache.resize(MODEL_CACHE_SIZE);
+        cache.swap(newCache);
+        for (size_t i = 0; i < cache.size(); ++i)
+        {
+            cachePosition[cache[i]] = (int)i;
+            score[cache[i]] = vertexScore((int)i, remaining[cache[i]]);
+        }
+        // only triangles touching the cache changed score, the next pick is among them
+        best = -1;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < cache.size(); ++i)
+        {
+            unsigned int vertex = cache[i];
+            for (unsigned int j = 0; j < remaining[vertex]; ++j)
+            {
+                unsigned int t = adjacency[offsets[vertex] + j];
+                triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+                if (triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    best = (int)t;
+                }
+            }
+        }
+    }
+    indices.swap(output);
+}
+
+OverdrawStats OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<MeshVertex> &vertices, unsigned int cacheSize, float threshold)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+    {
+        OverdrawStats stats = { 0, 0, 0.0f, 0.0f, true };
+        return stats;
+    }
+    // 1. hard boundaries: triangles where the cache optimizer had to start over (all vertices missed)
+    std::vector<size_t> hard;
+    {
+        FifoCache cache(vertices.size(), cacheSize);
+        for (size_t t = 0; t < triangleCount; ++t)
+            if (cache.Add(&indices[t * 3]) == 3 || t == 0)
+                hard.push_back(t);
+        hard.push_back(triangleCount);
+    }
+
+    // 2. soft boundaries: split a hard cluster as soon as the part so far, drawn with a cold cache,
+    //    is within threshold of the ACMR of the whole cluster. Smaller clusters sort better and
+    //    every cluster stays within the threshold wherever it ends up.
+    std::vector<Cluster> clusters;
+    FifoCache cache(vertices.size(), cacheSize);
+    for (size_t h = 0; h + 1 < hard.size(); ++h)
+    {
+        size_t begin = hard[h], end = hard[h + 1];
+        unsigned int clusterMisses = 0;
+        cache.Flush();
+        for (size_t t = begin; t < end; ++t)
+            clusterMisses += cache.Add(&indices[t * 3]);
+        float clusterAcmr = (float)clusterMisses / (end - begin);
+        Cluster cluster;
+        cluster.Begin = begin;
+        unsigned int runningMisses = 0;
+        cache.Flush();
+        for (size_t t = begin; t < end; ++t)
+        {
+            runningMisses += cache.Add(&indices[t * 3]);
+            if (t + 1 < end && (float)runningMisses / (t + 1 - cluster.Begin) <= clusterAcmr * threshold)
+            {
+                cluster.End = t + 1;
+                clusters.push_back(cluster);
+                cluster.Begin = t + 1;
+                runningMisses = 0;
+                cache.Flush();
+            }
+        }
+        cluster.End = end;
+        clusters.push_back(cluster);
+    }
+
+    // 3. sort clusters by how much they face away from the mesh centroid, outward facing clusters occlude the rest
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> centroids(triangleCount), normals(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        const glm::vec3 &a = vertices[indices[t * 3]].Position;
+        const glm::vec3 &b = vertices[indices[t * 3 + 1]].Position;
+        const glm::vec3 &c = vertices[indices[t * 3 + 2]].Position;
+        normals[t] = glm::cross(b - a, c - a); // length is twice the area
+        centroids[t] = (a + b + c) / 3.0f;
+        float area = glm::length(normals[t]);
+        meshCentroid += centroids[t] * area;
+        meshArea += area;
+    }
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    // 4. every cluster starts with a cold cache wherever it lands, so the sorted buffer as a whole
+    //    can still lose more than threshold. Until it doesn't, merge neighbouring clusters (in
+    //    cache order) and sort again; a single cluster is the vertex cache order itself.
+    OverdrawStats stats;
+    stats.CacheACMR = SimulateVertexCache(indices, vertices.size(), cacheSize, false).ACMR;
+    stats.Merges = 0;
+    float budget = stats.CacheACMR * threshold;
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    for (;;)
+    {
+        for (size_t i = 0; i < clusters.size(); ++i)
+        {
+            Cluster &cluster = clusters[i];
+            glm::vec3 centroid(0.0f), normal(0.0f);
+            float area = 0.0f;
+            for (size_t t = cluster.Begin; t < cluster.End; ++t)
+            {
+                float triangleArea = glm::length(normals[t]);
+                centroid += centroids[t] * triangleArea;
+                normal += normals[t];
+                area += triangleArea;
+            }
+            if (area > 0.0f)
+                centroid /= area;
+            float length = glm::length(normal);
+            cluster.Sort = length > 0.0f ? glm::dot(centroid - meshCentroid, normal / length) : 0.0f;
+        }
+        std::vector<Cluster> sorted(clusters);
+        std::stable_sort(sorted.begin(), sorted.end(), sortsBefore);
+        output.clear();
+        for (size_t i = 0; i < sorted.size(); ++i)
+            output.insert(output.end(), indices.begin() + sorted[i].Begin * 3, indices.begin() + sorted[i].End * 3);
+        stats.ACMR = SimulateVertexCache(output, vertices.size(), cacheSize, false).ACMR;
+        if (stats.ACMR <= budget || clusters.size() == 1)
+            break;
+        std::vector<Cluster> merged;
+        for (size_t i = 0; i < clusters.size(); i += 2)
+        {
+            merged.push_back(clusters[i]);
+            if (i + 1 < clusters.size())
+                merged.back().End = clusters[i + 1].End;
+        }
+        clusters.swap(merged);
+        stats.Merges++;
+    }
+    stats.Clusters = (unsigned int)clusters.size();
+    // only missed with a threshold below 1, when even the vertex cache order (one cluster) is over
+    stats.WithinBudget = stats.ACMR <= budget;
+    indices.swap(output);
+    return stats;
+}
+
+void OptimizeVertexFetch(MeshData &mesh)
+{
+    std::vector<unsigned int> remap(mesh.Vertices.size(), 0xFFFFFFFFu);
+    std::vector<MeshVertex> vertices;
+    vertices.reserve(mesh.Vertices.size());
+    for (size_t i = 0; i < mesh.Indices.size(); ++i)
+    {
+        unsigned int &index = mesh.Indices[i];
+        if (remap[index] == 0xFFFFFFFFu)
+        {
+            remap[index] = (unsigned int)vertices.size();
+            vertices.push_back(mesh.Vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.Vertices.swap(vertices);
+}
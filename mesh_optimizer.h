@@ -0,0 +1,41 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "model_data.h"
+
+// Result of running an index buffer through a simulated post-transform vertex cache
+struct VertexCacheStats
+{
+    unsigned int Misses;
+    float ACMR; // Average cache miss ratio: transformed vertices per triangle (0.5 is the ideal for large regular meshes)
+    float ATVR; // Average transformed to vertex ratio: transformed vertices per referenced vertex (1.0 is ideal)
+};
+
+// What OptimizeOverdraw did to a mesh, measured with the FIFO cache it targets
+struct OverdrawStats
+{
+    unsigned int Clusters; // Clusters sorted, 1 if the vertex cache order was kept
+    unsigned int Merges;   // Times neighbouring clusters were merged to get back within budget
+    float CacheACMR;       // ACMR of the vertex cache order
+    float ACMR;            // ACMR of the result
+    bool WithinBudget;     // ACMR <= CacheACMR * threshold
+};
+
+// Simulates a FIFO (as on most GPUs) or LRU post-transform cache with cacheSize entries
+VertexCacheStats SimulateVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize, bool lru);
+// Reorders triangles for vertex cache locality (Forsyth's linear-speed greedy algorithm)
+void OptimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount);
+// Reorders the clusters of a cache optimized index buffer so triangles likely to occlude others
+// come first. Clusters are cut where the cache restarts (hard) or where the running ACMR of a
+// cluster gets within threshold of the whole cluster (soft), then sorted by a view independent
+// measure: how far the cluster faces away from the mesh centroid (Sander et al. 2007). Each
+// cluster starts with a cold cache, so if the sorted buffer as a whole is over threshold times
+// the ACMR of the cache order, neighbouring clusters are merged pairwise until it is within.
+OverdrawStats OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<MeshVertex> &vertices, unsigned int cacheSize, float threshold);
+// Reorders vertices in order of first use by the index buffer and drops unused ones
+void OptimizeVertexFetch(MeshData &mesh);
+
+#endif
@@ -0,0 +1,197 @@
+#include <iostream>
+
+#include "mapped_file.h"
+#include "mesh_processing.h"
+#include "obj_loader.h"
+
+
+static void reportWeld(const MeshData &mesh, const WeldStats &stats)
+{
+    std::cout << "  " << mesh.Name << ": weld " << stats.TrianglesBefore * 3 << " corners, " << stats.VerticesBefore << " -> " << stats.VerticesAfter << " vertices, "
+        << stats.TrianglesBefore << " -> " << stats.TrianglesAfter << " triangles, "
+        << stats.BytesBefore / 1024 << " -> " << stats.BytesAfter / 1024 << " KiB, "
+        << stats.IndexSize * 8 << "-bit indices" << std::endl;
+}
+
+static void reportCache(const char *stage, const MeshData &mesh, unsigned int cacheSize)
+{
+    VertexCacheStats fifo = SimulateVertexCache(mesh.Indices, mesh.Vertices.size(), cacheSize, false);
+    VertexCacheStats lru = SimulateVertexCache(mesh.Indices, mesh.Vertices.size(), 32, true);
+    std::cout << "    " << stage << ": ACMR " << fifo.ACMR << " / ATVR " << fifo.ATVR << " (FIFO " << cacheSize << "), "
+        << "ACMR " << lru.ACMR << " / ATVR " << lru.ATVR << " (LRU 32)" << std::endl;
+}
+
+static void reportOverdraw(const OverdrawStats &stats, float threshold)
+{
+    std::cout << "    overdraw budget: ACMR " << stats.ACMR << (stats.WithinBudget ? " <= " : " > ") << stats.CacheACMR * threshold
+        << " (" << stats.CacheACMR << " x " << threshold << "), " << (stats.WithinBudget ? "respected" : "EXCEEDED") << ", "
+        << stats.Clusters << " clusters";
+    if (stats.Merges)
+        std::cout << " after " << stats.Merges << " pairwise merges";
+    std::cout << std::endl;
+}
+
+static void reportMeshlets(const MeshData &mesh)
+{
+    unsigned int vertices = 0, triangles = 0, cones = 0;
+    for (size_t i = 0; i < mesh.Meshlets.size(); ++i)
+    {
+        vertices += mesh.Meshlets[i].VertexCount;
+        triangles += mesh.Meshlets[i].TriangleCount;
+        cones += mesh.Meshlets[i].ConeCutoff < 1.0f;
+    }
+    size_t count = mesh.Meshlets.size() ? mesh.Meshlets.size() : 1;
+    std::cout << "    meshlets: " << mesh.Meshlets.size() << ", " << (float)vertices / count << " vertices / "
+        << (float)triangles / count << " triangles on average, " << cones << " back face cullable" << std::endl;
+}
+
+static void reportLods(const MeshData &mesh)
+{
+    std::cout << "    levels of detail:";
+    for (size_t i = 0; i < mesh.Lods.size(); ++i)
+        std::cout << (i ? ", " : " ") << mesh.Lods[i].IndexCount / 3 << " triangles (error " << mesh.Lods[i].Error << ")";
+    std::cout << std::endl;
+}
+
+static void reportQuantize(const MeshData &mesh, const QuantizationStats &stats)
+{
+    std::cout << "    quantize: position error " << stats.PositionError << " (" << stats.PositionRelative << " of extent), normal error "
+        << stats.NormalError << " deg, uv error " << stats.TexCoordError << " -> "
+        << (stats.Compact ? "compact" : "float") << " (" << VertexStride(mesh.Format) << " bytes per vertex)" << std::endl;
+}
+
+bool LoadProcessedModel(const std::string &path, ModelData &model, const MeshProcessingOptions &options)
+{
+    if (!LoadObj(path, model))
+        return false;
+    ProcessModel(model, options);
+    return true;
+}
+
+void ProcessModel(ModelData &model, const MeshProcessingOptions &options)
+{
+    size_t bytesBefore = 0, bytesAfter = 0;
+    for (unsigned int i = 0; i < model.Meshes.size(); ++i)
+    {
+        MeshData &mesh = model.Meshes[i];
+        bytesBefore += mesh.Vertices.size() * sizeof(MeshVertex) + mesh.Indices.size() * sizeof(unsigned int);
+        if (options.Weld)
+        {
+            WeldStats stats = WeldMesh(mesh, options.Welding);
+            if (options.Report)
+                reportWeld(mesh, stats);
+        }
+        OverdrawStats overdraw = OverdrawStats();
+        if (options.Optimize)
+        {
+            if (options.Report)
+                reportCache("input order", mesh, options.CacheSize);
+            OptimizeVertexCache(mesh.Indices, mesh.Vertices.size());
+            if (options.Report)
+                reportCache("vertex cache", mesh, options.CacheSize);
+            overdraw = OptimizeOverdraw(mesh.Indices, mesh.Vertices, options.CacheSize, options.OverdrawThreshold);
+            if (options.Report)
+            {
+                reportCache("overdraw", mesh, options.CacheSize);
+                reportOverdraw(overdraw, options.OverdrawThreshold);
+            }
+        }
+        if (options.Meshlets)
+        {
+            // every meshlet starts with a cold vertex cache, small ones can't stay within the
+            // overdraw budget: retry with limits twice as large until the buffer is (a single
+            // meshlet is the vertex cache order), drop them if it still isn't
+            std::vector<unsigned int> ordered(mesh.Indices);
+            unsigned int maxVertices = options.MeshletVertices, maxTriangles = options.MeshletTriangles;
+            float budget = overdraw.CacheACMR * options.OverdrawThreshold, acmr = 0.0f;
+            for (;;)
+            {
+                BuildMeshlets(mesh, maxVertices, maxTriangles);
+                if (!options.Optimize)
+                    break;
+                acmr = SimulateVertexCache(mesh.Indices, mesh.Vertices.size(), options.CacheSize, false).ACMR;
+                if (acmr <= budget)
+                    break;
+                mesh.Indices = ordered;
+                if (mesh.Meshlets.size() <= 1)
+                {
+                    mesh.Meshlets.clear();
+                    acmr = overdraw.ACMR;
+                    break;
+                }
+                maxVertices *= 2;
+                maxTriangles *= 2;
+            }
+            if (options.Report)
+            {
+                reportMeshlets(mesh);
+                reportCache("meshlets", mesh, options.CacheSize);
+                if (options.Optimize)
+                {
+                    std::cout << "    meshlet budget: ACMR " << acmr << (acmr <= budget ? " <= " : " > ") << budget;
+                    if (mesh.Meshlets.empty())
+                        std::cout << ", meshlets dropped";
+                    else
+                        std::cout << " with at most " << maxVertices << " vertices / " << maxTriangles << " triangles per meshlet";
+                    std::cout << std::endl;
+                }
+            }
+        }
+        if (options.Lods)
+        {
+            BuildLods(mesh, options.LodLevels, options.LodReduction, options.LodMaxError);
+            if (options.Report)
+                reportLods(mesh);
+        }
+        // vertex order follows the final triangle order
+        if (options.Optimize)
+            OptimizeVertexFetch(mesh);
+        if (options.Quantize)
+        {
+            QuantizationStats stats = QuantizeMesh(mesh, options.Quantization);
+            if (options.Report)
+                reportQuantize(mesh, stats);
+        }
+        bytesAfter += mesh.Vertices.size() * VertexStride(mesh.Format) + mesh.Indices.size() * IndexSizeFor(mesh.Vertices.size());
+    }
+    if (options.Report)
+        std::cout << "  total: " << bytesBefore / 1024 << " -> " << bytesAfter / 1024 << " KiB" << std::endl;
+}
+
+uint64_t HashOptions(const MeshProcessingOptions &options)
+{
+    uint64_t hash = HashBytes(&options.Weld, sizeof(options.Weld));
+    if (options.Weld)
+    {
+        hash = HashBytes(&options.Welding.PositionEpsilon, sizeof(float), hash);
+        hash = HashBytes(&options.Welding.NormalEpsilon, sizeof(float), hash);
+        hash = HashBytes(&options.Welding.TexCoordEpsilon, sizeof(float), hash);
+    }
+    hash = HashBytes(&options.Optimize, sizeof(options.Optimize), hash);
+    if (options.Optimize)
+    {
+        hash = HashBytes(&options.CacheSize, sizeof(options.CacheSize), hash);
+        hash = HashBytes(&options.OverdrawThreshold, sizeof(options.OverdrawThreshold), hash);
+    }
+    hash = HashBytes(&options.Meshlets, sizeof(options.Meshlets), hash);
+    if (options.Meshlets)
+    {
+        hash = HashBytes(&options.MeshletVertices, sizeof(options.MeshletVertices), hash);
+        hash = HashBytes(&options.MeshletTriangles, sizeof(options.MeshletTriangles), hash);
+    }
+    hash = HashBytes(&options.Lods, sizeof(options.Lods), hash);
+    if (options.Lods)
+    {
+        hash = HashBytes(&options.LodLevels, sizeof(options.LodLevels), hash);
+        hash = HashBytes(&options.LodReduction, sizeof(options.LodReduction), hash);
+        hash = HashBytes(&options.LodMaxError, sizeof(options.LodMaxError), hash);
+    }
+    hash = HashBytes(&options.Quantize, sizeof(options.Quantize), hash);
+    if (options.Quantize)
+    {
+        hash = HashBytes(&options.Quantization.PositionTolerance, sizeof(float), hash);
+        hash = HashBytes(&options.Quantization.NormalTolerance, sizeof(float), hash);
+        hash = HashBytes(&options.Quantization.TexCoordTolerance, sizeof(float), hash);
+    }
+    return hash;
+}
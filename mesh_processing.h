@@ -0,0 +1,44 @@
+#ifndef MESH_PROCESSING_H
+#define MESH_PROCESSING_H
+
+#include <stdint.h>
+#include <string>
+
+#include "mesh_lod.h"
+#include "mesh_optimizer.h"
+#include "meshlet.h"
+#include "mesh_weld.h"
+#include "model_data.h"
+#include "vertex_format.h"
+
+// Processing stages run on every mesh between loading and GPU upload
+struct MeshProcessingOptions
+{
+    bool Weld;               // Merge duplicate vertices
+    WeldOptions Welding;
+    bool Optimize;           // Reorder triangles (vertex cache, then overdraw) and vertices (fetch)
+    unsigned int CacheSize;  // FIFO size of the targeted post-transform cache
+    float OverdrawThreshold; // How much ACMR the overdraw pass may give up (1.05 = 5%)
+    bool Meshlets;                   // Split the index buffer into meshlets for culling, in the order of the overdraw clusters
+    unsigned int MeshletVertices;    // Limits per meshlet, doubled while the result is over the overdraw budget
+    unsigned int MeshletTriangles;
+    bool Lods;                       // Append simplified levels of detail to every mesh
+    unsigned int LodLevels;          // Levels including the original
+    float LodReduction;              // Triangles of a level relative to the previous one
+    float LodMaxError;               // Largest error of the coarsest level, relative to the bounding radius
+    bool Quantize;           // Switch meshes to the compact vertex format where it stays within tolerance
+    QuantizationOptions Quantization;
+    bool Report;             // Print per mesh statistics while processing
+    MeshProcessingOptions() : Weld(true), Optimize(true), CacheSize(16), OverdrawThreshold(1.05f),
+        Meshlets(true), MeshletVertices(64), MeshletTriangles(124),
+        Lods(true), LodLevels(4), LodReduction(0.5f), LodMaxError(0.1f), Quantize(false), Report(false) { }
+};
+
+// Loads the model at path and runs the enabled processing stages on it
+bool LoadProcessedModel(const std::string &path, ModelData &model, const MeshProcessingOptions &options);
+// Runs the enabled processing stages on every mesh of model
+void ProcessModel(ModelData &model, const MeshProcessingOptions &options);
+// Identifies the output produced by options (Report excluded), stored in the mesh cache
+uint64_t HashOptions(const MeshProcessingOptions &options);
+
+#endif
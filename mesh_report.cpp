@@ -0,0 +1,25 @@
+// Prints what the mesh processing stages do to a model, mesh by mesh.
+//
+// usage: mesh_report [model.obj] [position epsilon]
+#include <cstdlib>
+#include <iostream>
+
+#include "mesh_processing.h"
+#include "obj_loader.h"
+
+int main(int argc, char **argv)
+{
+    std::string path = argc > 1 ? argv[1] : "resources/objects/SUV_BF3/suv.obj";
+    MeshProcessingOptions options;
+    options.Quantize = true;
+    options.Report = true;
+    if (argc > 2)
+        options.Welding.PositionEpsilon = (float)atof(argv[2]);
+
+    ModelData model;
+    if (!LoadObj(path, model))
+        return 1;
+    std::cout << path << std::endl;
+    ProcessModel(model, options);
+    return 0;
+}
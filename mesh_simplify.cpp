@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <cmath>
+
+#include "mesh_simplify.h"
+
+
+namespace {
+
+// In the quadrics, planes through open borders and seams weigh this much more than the
+// surface, so vertices on them slide along them first
+const float BOUNDARY_WEIGHT = 10.0f;
+// A collapse may not turn any remaining triangle by more than ~75 degrees
+const float FLIP_COSINE = 0.25f;
+const unsigned int NONE = 0xFFFFFFFFu;
+
+// Sum of squared distances to a set of weighted planes
+struct Quadric
+{
+    double A00, A11, A22, A10, A20, A21;
+    double B0, B1, B2, C;
+    double Weight;
+};
+
+void addPlane(Quadric &q, const glm::vec3 &normal, float distance, float weight)
+{
+    q.A00 += weight * normal.x * normal.x;
+    q.A11 += weight * normal.y * normal.y;
+    q.A22 += weight * normal.z * normal.z;
+    q.A10 += weight * normal.y * normal.x;
+    q.A20 += weight * normal.z * normal.x;
+    q.A21 += weight * normal.z * normal.y;
+    q.B0 += weight * normal.x * distance;
+    q.B1 += weight * normal.y * distance;
+    q.B2 += weight * normal.z * distance;
+    q.C += weight * distance * distance;
+    q.Weight += weight;
+}
+
+void addQuadric(Quadric &q, const Quadric &other)
+{
+    q.A00 += other.A00; q.A11 += other.A11; q.A22 += other.A22;
+    q.A10 += other.A10; q.A20 += other.A20; q.A21 += other.A21;
+    q.B0 += other.B0; q.B1 += other.B1; q.B2 += other.B2;
+    q.C += other.C;
+    q.Weight += other.Weight;
+}
+
+// Weighted mean squared distance of point to the planes of q
+float quadricError(const Quadric &q, const glm::vec3 &p)
+{
+    double x = p.x, y = p.y, z = p.z;
+    double rx = q.A00 * x + q.A10 * y + q.A20 * z;
+    double ry = q.A10 * x + q.A11 * y + q.A21 * z;
+    double rz = q.A20 * x + q.A21 * y + q.A22 * z;
+    double r = rx * x + ry * y + rz * z + 2.0 * (q.B0 * x + q.B1 * y + q.B2 * z) + q.C;
+    return q.Weight > 0.0 ? (float)(fabs(r) / q.Weight) : 0.0f;
+}
+
+// Compressed sparse rows of (vertex -> values)
+struct Adjacency
+{
+    std::vector<unsigned int> Offsets, Data;
+    void Build(size_t vertexCount, const std::vector<unsigned int> &indices, bool edges)
+    {
+        this->Offsets.assign(vertexCount + 1, 0);
+        for (size_t i = 0; i < indices.size(); ++i)
+            this->Offsets[indices[i] + 1]++;
+        for (size_t v = 0; v < vertexCount; ++v)
+            this->Offsets[v + 1] += this->Offsets[v];
+        this->Data.resize(indices.size());
+        std::vector<unsigned int> fill(this->Offsets.begin(), this->Offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            // edges: the next corner of the triangle (half-edge a -> b), else the triangle itself
+            size_t next = i - i % 3 + (i + 1) % 3;
+            this->Data[fill[indices[i]]++] = edges ? indices[next] : (unsigned int)(i / 3);
+        }
+    }
+    bool Contains(unsigned int vertex, unsigned int value) const
+    {
+        for (unsigned int j = this->Offsets[vertex]; j < this->Offsets[vertex + 1]; ++j)
+            if (this->Data[j] == value)
+                return true;
+        return false;
+    }
+};
+
+struct Collapse
+{
+    unsigned int From, To;
+    float Error;    // Orders the collapses: Distance, or the quadric's RMS distance where larger (seams)
+    float Distance; // Farthest To is from the input planes From stands for, bounds the result
+};
+
+bool cheaper(const Collapse &a, const Collapse &b)
+{
+    return a.Error < b.Error;
+}
+
+// Whether moving vertex from onto to turns one of its other triangles over
+bool flipsTriangle(unsigned int from, unsigned int to, const std::vector<unsigned int> &indices, const Adjacency &triangles,
+    const std::vector<MeshVertex> &vertices, const std::vector<unsigned int> &remap)
+{
+    const glm::vec3 &p0 = vertices[from].Position;
+    const glm::vec3 &p1 = vertices[to].Position;
+    for (unsigned int j = triangles.Offsets[from]; j < triangles.Offsets[from + 1]; ++j)
+    {
+        const unsigned int *triangle = &indices[triangles.Data[j] * 3];
+        int k = triangle[0] == from ? 0 : triangle[1] == from ? 1 : 2;
+        unsigned int a = triangle[(k + 1) % 3], b = triangle[(k + 2) % 3];
+        // triangles on the collapsed edge disappear
+        if (remap[a] == remap[to] || remap[b] == remap[to])
+            continue;
+        const glm::vec3 &pa = vertices[a].Position;
+        const glm::vec3 &pb = vertices[b].Position;
+        glm::vec3 before = glm::cross(pa - p0, pb - p0);
+        glm::vec3 after = glm::cross(pa - p1, pb - p1);
+        if (glm::dot(before, after) < FLIP_COSINE * glm::length(before) * glm::length(after))
+            return true;
+    }
+    return false;
+}
+
+// Largest distance of point to the planes listed
+float planeDistance(const std::vector<unsigned int> &list, const std::vector<glm::vec4> &planes, const glm::vec3 &point)
+{
+    float distance = 0.0f;
+    for (size_t i = 0; i < list.size(); ++i)
+        distance = std::max(distance, std::fabs(glm::dot(glm::vec3(planes[list[i]]), point) + planes[list[i]].w));
+    return distance;
+}
+
+// Moves collapsing the position of from onto the position of to: every copy of from still in
+// use goes to a copy of to it shares a triangle with, keeping its attributes. False when a copy
+// has none (a corner where more than two attribute regions meet moved along one of its seams).
+// removed counts the triangles the collapse drops.
+bool collapseMoves(unsigned int from, unsigned int to, const std::vector<unsigned int> &indices, const Adjacency &triangles,
+    const std::vector<unsigned int> &remap, const std::vector<unsigned int> &wedge, std::vector<Collapse> &moves, size_t &removed)
+{
+    moves.clear();
+    removed = 0;
+    unsigned int copy = from;
+    do
+    {
+        unsigned int target = NONE;
+        for (unsigned int j = triangles.Offsets[copy]; j < triangles.Offsets[copy + 1]; ++j)
+        {
+            const unsigned int *triangle = &indices[triangles.Data[j] * 3];
+            for (int k = 0; k < 3; ++k)
+                if (remap[triangle[k]] == remap[to])
+                {
+                    target = triangle[k];
+                    removed++;
+                }
+        }
+        if (target == NONE && triangles.Offsets[copy] != triangles.Offsets[copy + 1])
+            return false;
+        if (target != NONE)
+        {
+            Collapse move = { copy, target, 0.0f, 0.0f };
+            moves.push_back(move);
+        }
+        copy = wedge[copy];
+    } while (copy != from);
+    return !moves.empty();
+}
+
+} // namespace
+
+float SimplifyMesh(const std::vector<unsigned int> &indices, const std::vector<MeshVertex> &vertices, size_t targetIndexCount, float maxError,
+    std::vector<unsigned int> &destination)
+{
+    destination = indices;
+    size_t vertexCount = vertices.size();
+    if (indices.size() <= targetIndexCount || vertexCount == 0)
+        return 0.0f;
+
+    // 1. vertices sharing a position: remap to the first one, wedge links them in a cycle
+    std::vector<unsigned int> remap(vertexCount), wedge(vertexCount);
+    {
+        std::vector<unsigned int> order(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v)
+            order[v] = (unsigned int)v;
+        struct ByPosition
+        {
+            const std::vector<MeshVertex> *Vertices;
+            bool operator()(unsigned int a, unsigned int b) const
+            {
+                const glm::vec3 &pa = (*this->Vertices)[a].Position, &pb = (*this->Vertices)[b].Position;
+                return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z != pb.z ? pa.z < pb.z : a < b;
+            }
+        } byPosition = { &vertices };
+        std::sort(order.begin(), order.end(), byPosition);
+        for (size_t i = 0; i < vertexCount; )
+        {
+            size_t end = i + 1;
+            while (end < vertexCount && vertices[order[end]].Position == vertices[order[i]].Position)
+                end++;
+            for (size_t j = i; j < end; ++j)
+            {
+                remap[order[j]] = order[i];
+                wedge[order[j]] = order[j + 1 < end ? j + 1 : i];
+            }
+            i = end;
+        }
+    }
+
+    // 2. half-edges, an edge without its twin is on an open border or a seam
+    Adjacency edges;
+    edges.Build(vertexCount, indices, true);
+
+    // 3. quadrics per position: triangle planes weighted by area, plus planes through open edges.
+    // Each position also lists the planes of the input triangles and open borders it stands for,
+    // a collapse hands them on to its target, so the error bound is measured against the input
+    // and doesn't depend on the weights.
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<glm::vec4> planes(indices.size() / 3);
+    std::vector<std::vector<unsigned int> > planeLists(vertexCount);
+    for (size_t t = 0; t < indices.size() / 3; ++t)
+    {
+        const unsigned int *triangle = &indices[t * 3];
+        const glm::vec3 &p0 = vertices[triangle[0]].Position;
+        glm::vec3 normal = glm::cross(vertices[triangle[1]].Position - p0, vertices[triangle[2]].Position - p0);
+        float area = glm::length(normal);
+        if (area == 0.0f)
+            continue;
+        normal /= area;
+        planes[t] = glm::vec4(normal, -glm::dot(normal, p0));
+        for (int k = 0; k < 3; ++k)
+        {
+            addPlane(quadrics[remap[triangle[k]]], normal, -glm::dot(normal, p0), area * 0.5f);
+            planeLists[remap[triangle[k]]].push_back((unsigned int)t);
+        }
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int a = triangle[k], b = triangle[(k + 1) % 3];
+            if (edges.Contains(b, a))
+                continue;
+            glm::vec3 edge = vertices[b].Position - vertices[a].Position;
+            float length = glm::length(edge);
+            if (length == 0.0f)
+                continue;
+            glm::vec3 side = glm::normalize(glm::cross(edge, normal));
+            float distance = -glm::dot(side, vertices[a].Position);
+            addPlane(quadrics[remap[a]], side, distance, length * length * BOUNDARY_WEIGHT);
+            addPlane(quadrics[remap[b]], side, distance, length * length * BOUNDARY_WEIGHT);
+            // the outline is part of the shape the bound covers, a seam (the reverse edge between
+            // other copies of the same positions) only splits attributes
+            bool seam = false;
+            for (unsigned int copy = wedge[b]; copy != b && !seam; copy = wedge[copy])
+                for (unsigned int j = edges.Offsets[copy]; j < edges.Offsets[copy + 1] && !seam; ++j)
+                    seam = remap[edges.Data[j]] == remap[a];
+            if (seam)
+                continue;
+            planeLists[remap[a]].push_back((unsigned int)planes.size());
+            planeLists[remap[b]].push_back((unsigned int)planes.size());
+            planes.push_back(glm::vec4(side, distance));
+        }
+    }
+
+    // 4. passes of independent collapses, cheapest first
+    float resultError = 0.0f;
+    Adjacency triangles;
+    std::vector<Collapse> candidates, moves;
+    std::vector<unsigned int> collapse(vertexCount);
+    std::vector<bool> locked(vertexCount);
+    float floorLimit = 0.0f;
+    for (int pass = 0; pass < 100 && destination.size() > targetIndexCount; ++pass)
+    {
+        triangles.Build(vertexCount, destination, false);
+        candidates.clear();
+        for (size_t i = 0; i < destination.size(); ++i)
+        {
+            unsigned int from = destination[i], to = destination[i - i % 3 + (i + 1) % 3];
+            for (int direction = 0; direction < 2; ++direction, std::swap(from, to))
+            {
+                size_t removed;
+                if (remap[from] == remap[to] || !collapseMoves(from, to, destination, triangles, remap, wedge, moves, removed))
+                    continue;
+                const glm::vec3 &position = vertices[to].Position;
+                Collapse candidate = { from, to, 0.0f, planeDistance(planeLists[remap[from]], planes, position) };
+                candidate.Error = std::max(candidate.Distance, sqrtf(quadricError(quadrics[remap[from]], position)));
+                if (candidate.Distance <= maxError)
+                    candidates.push_back(candidate);
+            }
+        }
+        if (candidates.empty())
+            break;
+        std::sort(candidates.begin(), candidates.end(), cheaper);
+        // a pass only takes collapses up to a little more than the error of the ones it needs,
+        // the next pass re-evaluates the rest with the quadrics merged so far. When a pass finds
+        // nothing (the cheap ones all fold triangles over) the limit doubles until one does.
+        size_t goal = (destination.size() - targetIndexCount) / 6;
+        float passLimit = goal < candidates.size() ? candidates[goal].Error * 1.5f : candidates.back().Error;
+        passLimit = std::max(passLimit, floorLimit);
+
+        for (size_t v = 0; v < vertexCount; ++v)
+            collapse[v] = (unsigned int)v;
+        std::fill(locked.begin(), locked.end(), false);
+        size_t triangleCount = destination.size() / 3, removed = 0, collapses = 0, considered = 0;
+        for (size_t i = 0; i < candidates.size() && (triangleCount - removed) * 3 > targetIndexCount; ++i, ++considered)
+        {
+            const Collapse &candidate = candidates[i];
+            if (candidate.Error > passLimit)
+                break;
+            unsigned int from = candidate.From, to = candidate.To;
+            size_t dropped;
+            if (locked[remap[from]] || locked[remap[to]] || !collapseMoves(from, to, destination, triangles, remap, wedge, moves, dropped))
+                continue;
+            bool flips = false;
+            for (size_t m = 0; m < moves.size() && !flips; ++m)
+                flips = flipsTriangle(moves[m].From, moves[m].To, destination, triangles, vertices, remap);
+            if (flips)
+                continue;
+            for (size_t m = 0; m < moves.size(); ++m)
+                collapse[moves[m].From] = moves[m].To;
+            addQuadric(quadrics[remap[to]], quadrics[remap[from]]);
+            std::vector<unsigned int> &list = planeLists[remap[to]];
+            list.insert(list.end(), planeLists[remap[from]].begin(), planeLists[remap[from]].end());
+            std::vector<unsigned int>().swap(planeLists[remap[from]]);
+            locked[remap[from]] = locked[remap[to]] = true;
+            removed += dropped;
+            collapses++;
+            resultError = std::max(resultError, candidate.Distance);
+        }
+        if (collapses == 0)
+        {
+            if (considered == candidates.size())
+                break;
+            floorLimit = std::max(passLimit * 2.0f, candidates[considered].Error);
+            continue;
+        }
+
+        // apply, dropping triangles that lost an edge
+        size_t write = 0;
+        for (size_t t = 0; t < destination.size() / 3; ++t)
+        {
+            unsigned int a = collapse[destination[t * 3]], b = collapse[destination[t * 3 + 1]], c = collapse[destination[t * 3 + 2]];
+            if (remap[a] == remap[b] || remap[b] == remap[c] || remap[c] == remap[a])
+                continue;
+            destination[write++] = a;
+            destination[write++] = b;
+            destination[write++] = c;
+        }
+        destination.resize(write);
+    }
+    return resultError;
+}
@@ -0,0 +1,24 @@
+#ifndef MESH_SIMPLIFY_H
+#define MESH_SIMPLIFY_H
+
+#include <cstddef>
+#include <vector>
+
+#include "model_data.h"
+
+// Reduces the triangles of indices (over vertices) towards targetIndexCount by edge
+// collapses, writing the result to destination. Vertices are only ever collapsed onto
+// neighbours, so destination indexes the same vertex buffer. Collapses move a position: every
+// copy of it split at a UV/normal seam moves onto the copy of the neighbour it shares a
+// triangle with, corners where more than two copies meet only move towards neighbours all of
+// them touch. Each position stands for the planes of the input triangles and open borders it
+// has absorbed. A collapse's error is the largest distance of its target from those planes
+// (Ronfard & Rossignac 1996), cheapest first, ties and seams weighed by quadric error (Garland
+// & Heckbert 1997) with heavily weighted planes through open borders and seams rather than
+// locks. Collapses with an error over maxError (model units) are skipped. Returns the largest
+// error of the collapses made: no vertex of destination is farther than that from the planes
+// of the input triangles and borders it replaced.
+float SimplifyMesh(const std::vector<unsigned int> &indices, const std::vector<MeshVertex> &vertices, size_t targetIndexCount, float maxError,
+    std::vector<unsigned int> &destination);
+
+#endif
@@ -0,0 +1,155 @@
+#include <cmath>
+#include <cstring>
+
+#include "mesh_weld.h"
+
+
+namespace {
+
+const unsigned int EMPTY = 0xFFFFFFFFu;
+
+// Cell of the position grid, one epsilon wide
+struct CellKey
+{
+    int Q[3];
+    bool operator==(const CellKey &other) const { return this->Q[0] == other.Q[0] && this->Q[1] == other.Q[1] && this->Q[2] == other.Q[2]; }
+};
+
+inline int cellOf(float value, float inverseEpsilon)
+{
+    double cell = std::floor((double)value * inverseEpsilon);
+    return cell > 2147483646.0 ? 2147483646 : cell < -2147483646.0 ? -2147483646 : (int)cell;
+}
+
+inline unsigned int hashCell(const CellKey &key)
+{
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < 3; ++i)
+    {
+        hash ^= (unsigned int)key.Q[i];
+        hash *= 16777619u;
+        hash ^= hash >> 13;
+    }
+    return hash;
+}
+
+inline bool within(const glm::vec3 &a, const glm::vec3 &b, float epsilon)
+{
+    return std::fabs(a.x - b.x) <= epsilon && std::fabs(a.y - b.y) <= epsilon && std::fabs(a.z - b.z) <= epsilon;
+}
+
+inline bool matches(const MeshVertex &a, const MeshVertex &b, const WeldOptions &options)
+{
+    return within(a.Position, b.Position, options.PositionEpsilon) && within(a.Normal, b.Normal, options.NormalEpsilon) &&
+        std::fabs(a.TexCoords.x - b.TexCoords.x) <= options.TexCoordEpsilon && std::fabs(a.TexCoords.y - b.TexCoords.y) <= options.TexCoordEpsilon;
+}
+
+} // namespace
+
+unsigned int IndexSizeFor(size_t vertexCount)
+{
+    return vertexCount <= 65536 ? 2 : 4;
+}
+
+void PackIndices(const std::vector<unsigned int> &indices, unsigned int indexSize, std::vector<unsigned char> &packed)
+{
+    packed.resize(indices.size() * indexSize);
+    if (indexSize == 4)
+    {
+        if (!indices.empty())
+            memcpy(&packed[0], &indices[0], packed.size());
+        return;
+    }
+    unsigned short *dst = (unsigned short*)(packed.empty() ? NULL : &packed[0]);
+    for (size_t i = 0; i < indices.size(); ++i)
+        dst[i] = (unsigned short)indices[i];
+}
+
+WeldStats WeldMesh(MeshData &mesh, const WeldOptions &options)
+{
+    WeldStats stats;
+    stats.VerticesBefore = mesh.Vertices.size();
+    stats.TrianglesBefore = mesh.Indices.size() / 3;
+    stats.BytesBefore = mesh.Vertices.size() * sizeof(MeshVertex) + mesh.Indices.size() * sizeof(unsigned int);
+
+    // welded vertices are chained per position cell, a vertex within PositionEpsilon of another
+    // lies in the same or a neighbouring cell, so the 27 cells around it hold every candidate
+    float inversePosition = 1.0f / options.PositionEpsilon;
+    size_t capacity = 16;
+    while (capacity < mesh.Vertices.size() * 2)
+        capacity <<= 1;
+    std::vector<unsigned int> slots(capacity, EMPTY);  // First welded vertex of the cell
+    std::vector<CellKey> cells;                        // Cell of each welded vertex
+    std::vector<unsigned int> chain;                   // Next welded vertex in the same cell
+    std::vector<unsigned int> remap(mesh.Vertices.size());
+    std::vector<MeshVertex> welded;
+    welded.reserve(mesh.Vertices.size());
+    for (size_t i = 0; i < mesh.Vertices.size(); ++i)
+    {
+        const MeshVertex &vertex = mesh.Vertices[i];
+        CellKey cell;
+        cell.Q[0] = cellOf(vertex.Position.x, inversePosition);
+        cell.Q[1] = cellOf(vertex.Position.y, inversePosition);
+        cell.Q[2] = cellOf(vertex.Position.z, inversePosition);
+        // the earliest welded vertex within all tolerances, so the result doesn't depend on probe order
+        unsigned int match = EMPTY;
+        for (int neighbour = 0; neighbour < 27; ++neighbour)
+        {
+            CellKey probe = { { cell.Q[0] + neighbour % 3 - 1, cell.Q[1] + neighbour / 3 % 3 - 1, cell.Q[2] + neighbour / 9 - 1 } };
+            for (size_t slot = hashCell(probe) & (capacity - 1); slots[slot] != EMPTY; slot = (slot + 1) & (capacity - 1))
+            {
+                if (!(cells[slots[slot]] == probe))
+                    continue;
+                for (unsigned int w = slots[slot]; w != EMPTY; w = chain[w])
+                    if (w < match && matches(vertex, welded[w], options))
+                        match = w;
+                break;
+            }
+        }
+        if (match != EMPTY)
+        {
+            remap[i] = match;
+            continue;
+        }
+        unsigned int index = (unsigned int)welded.size();
+        remap[i] = index;
+        welded.push_back(vertex);
+        cells.push_back(cell);
+        chain.push_back(EMPTY);
+        for (size_t slot = hashCell(cell) & (capacity - 1); ; slot = (slot + 1) & (capacity - 1))
+        {
+            if (slots[slot] == EMPTY)
+            {
+                slots[slot] = index;
+                break;
+            }
+            if (cells[slots[slot]] == cell)
+            {
+                // the slot keeps naming a vertex of this cell, the new one joins its chain
+                chain[index] = chain[slots[slot]];
+                chain[slots[slot]] = index;
+                break;
+            }
+        }
+    }
+
+    // remap triangles, dropping the ones that collapsed
+    size_t kept = 0;
+    for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+    {
+        unsigned int a = remap[mesh.Indices[i]], b = remap[mesh.Indices[i + 1]], c = remap[mesh.Indices[i + 2]];
+        if (a == b || b == c || a == c)
+            continue;
+        mesh.Indices[kept++] = a;
+        mesh.Indices[kept++] = b;
+        mesh.Indices[kept++] = c;
+    }
+    mesh.Indices.resize(kept);
+    mesh.Vertices.swap(welded);
+
+    stats.VerticesAfter = mesh.Vertices.size();
+    stats.TrianglesAfter = mesh.Indices.size() / 3;
+    stats.IndexSize = IndexSizeFor(mesh.Vertices.size());
+    stats.BytesAfter = mesh.Vertices.size() * sizeof(MeshVertex) + mesh.Indices.size() * stats.IndexSize;
+    return stats;
+}
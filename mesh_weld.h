@@ -0,0 +1,38 @@
+#ifndef MESH_WELD_H
+#define MESH_WELD_H
+
+#include <cstddef>
+#include <vector>
+
+#include "model_data.h"
+
+// Tolerances under which two vertices are considered the same
+struct WeldOptions
+{
+    float PositionEpsilon;
+    float NormalEpsilon;
+    float TexCoordEpsilon;
+    WeldOptions() : PositionEpsilon(1e-4f), NormalEpsilon(1e-3f), TexCoordEpsilon(1e-5f) { }
+};
+
+// Before/after numbers of a weld, memory is vertex plus index buffer size
+struct WeldStats
+{
+    size_t VerticesBefore, VerticesAfter;
+    size_t TrianglesBefore, TrianglesAfter;
+    size_t BytesBefore, BytesAfter;
+    unsigned int IndexSize; // Bytes per index after welding
+};
+
+// Merges vertices whose position, normal and texture coordinates are equal within
+// the given tolerances (per component) and drops triangles that became degenerate.
+// Each vertex joins the first kept vertex within tolerance of it, found through a hash
+// of the position grid and its neighbouring cells, or is kept itself. The index width
+// is chosen from the resulting vertex count.
+WeldStats WeldMesh(MeshData &mesh, const WeldOptions &options);
+// Smallest index size in bytes (2 or 4) able to address vertexCount vertices
+unsigned int IndexSizeFor(size_t vertexCount);
+// Writes indices with indexSize bytes each into packed
+void PackIndices(const std::vector<unsigned int> &indices, unsigned int indexSize, std::vector<unsigned char> &packed);
+
+#endif
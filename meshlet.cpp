@@ -0,0 +1,360 @@
+#include <algorithm>
+#include <cmath>
+
+#include "mesh_optimizer.h"
+#include "meshlet.h"
+
+
+static void finishMeshlet(const MeshData &mesh, Meshlet &meshlet)
+{
+    const unsigned int *indices = &mesh.Indices[meshlet.IndexOffset];
+    unsigned int count = meshlet.TriangleCount * 3;
+    // bounding sphere: center of the bounding box, radius to the farthest vertex
+    glm::vec3 lower = mesh.Vertices[indices[0]].Position, upper = lower;
+    for (unsigned int i = 1; i < count; ++i)
+    {
+        lower = glm::min(lower, mesh.Vertices[indices[i]].Position);
+        upper = glm::max(upper, mesh.Vertices[indices[i]].Position);
+    }
+    meshlet.Center = (lower + upper) * 0.5f;
+    meshlet.Radius = 0.0f;
+    for (unsigned int i = 0; i < count; ++i)
+        meshlet.Radius = std::max(meshlet.Radius, glm::length(mesh.Vertices[indices[i]].Position - meshlet.Center));
+
+    // normal cone: area weighted average face normal, half angle to the least aligned face
+    std::vector<glm::vec3> normals(meshlet.TriangleCount);
+    glm::vec3 axis(0.0f);
+    for (unsigned int t = 0; t < meshlet.TriangleCount; ++t)
+    {
+        const glm::vec3 &a = mesh.Vertices[indices[t * 3]].Position;
+        const glm::vec3 &b = mesh.Vertices[indices[t * 3 + 1]].Position;
+        const glm::vec3 &c = mesh.Vertices[indices[t * 3 + 2]].Position;
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        axis += normal;
+        float length = glm::length(normal);
+        normals[t] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+    }
+    float length = glm::length(axis);
+    meshlet.ConeAxis = length > 0.0f ? axis / length : glm::vec3(0.0f, 0.0f, 1.0f);
+    float minDot = length > 0.0f ? 1.0f : -1.0f;
+    for (unsigned int t = 0; t < meshlet.TriangleCount; ++t)
+        if (normals[t] != glm::vec3(0.0f))
+            minDot = std::min(minDot, glm::dot(normals[t], meshlet.ConeAxis));
+    // a cone wider than 90 degrees has no direction it is back facing from
+    meshlet.ConeCutoff = minDot <= 0.0f ? 1.0f : sqrtf(1.0f - minDot * minDot);
+}
+
+namespace {
+
+const unsigned int KD_LEAF_SIZE = 8;
+// How much farther a triangle facing away from a meshlet may be than one facing its way
+const float KD_CONE_WEIGHT = 32.0f;
+
+// Node of a kd-tree over triangle centroids: a split plane, or a leaf (Axis 3) holding Count
+// triangles from First in the tree's item list
+struct KdNode
+{
+    unsigned int Axis;
+    float Split;
+    unsigned int Left, Right; // Children of a split
+    unsigned int First, Count;
+};
+
+unsigned int buildKdTree(std::vector<KdNode> &nodes, std::vector<unsigned int> &items, unsigned int first, unsigned int count,
+    const std::vector<glm::vec3> &points)
+{
+    unsigned int index = (unsigned int)nodes.size();
+    nodes.push_back(KdNode());
+    glm::vec3 lower = points[items[first]], upper = lower;
+    for (unsigned int i = first + 1; i < first + count; ++i)
+    {
+        lower = glm::min(lower, points[items[i]]);
+        upper = glm::max(upper, points[items[i]]);
+    }
+    glm::vec3 extent = upper - lower;
+    if (count <= KD_LEAF_SIZE || (extent.x == 0.0f && extent.y == 0.0f && extent.z == 0.0f))
+    {
+        KdNode &leaf = nodes[index];
+        leaf.Axis = 3;
+        leaf.First = first;
+        leaf.Count = count;
+        return index;
+    }
+    unsigned int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+    // median split: the left half lies at or below the plane, the right half at or above it
+    unsigned int half = count / 2;
+    std::nth_element(items.begin() + first, items.begin() + first + half, items.begin() + first + count,
+        [&points, axis](unsigned int a, unsigned int b) { return points[a][axis] < points[b][axis]; });
+    float split = points[items[first + half]][axis];
+    unsigned int left = buildKdTree(nodes, items, first, half, points);
+    unsigned int right = buildKdTree(nodes, items, first + half, count - half, points);
+    KdNode &node = nodes[index];
+    node.Axis = axis;
+    node.Split = split;
+    node.Left = left;
+    node.Right = right;
+    return index;
+}
+
+// Triangle not emitted yet with the lowest squared distance to point, scaled up the further
+// its normal turns from direction (so the distance stays a lower bound for pruning), best
+// stays -1 if there is none
+void findNearest(const std::vector<KdNode> &nodes, unsigned int index, const std::vector<unsigned int> &items, const std::vector<glm::vec3> &points,
+    const std::vector<glm::vec3> &normals, const std::vector<bool> &emitted, const glm::vec3 &point, const glm::vec3 &direction, int &best, float &bestDistance)
+{
+    const KdNode &node = nodes[index];
+    if (node.Axis == 3)
+    {
+        for (unsigned int i = node.First; i < node.First + node.Count; ++i)
+        {
+            unsigned int t = items[i];
+            if (emitted[t])
+                continue;
+            glm::vec3 delta = points[t] - point;
+            float distance = glm::dot(delta, delta) * (1.0f + KD_CONE_WEIGHT * (1.0f - glm::dot(normals[t], direction)));
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                best = (int)t;
+            }
+        }
+        return;
+    }
+    float delta = point[node.Axis] - node.Split;
+    findNearest(nodes, delta < 0.0f ? node.Left : node.Right, items, points, normals, emitted, point, direction, best, bestDistance);
+    if (delta * delta <= bestDistance)
+        findNearest(nodes, delta < 0.0f ? node.Right : node.Left, items, points, normals, emitted, point, direction, best, bestDistance);
+}
+
+} // namespace
+
+void BuildMeshlets(MeshData &mesh, unsigned int maxVertices, unsigned int maxTriangles)
+{
+    mesh.Meshlets.clear();
+    size_t triangleCount = mesh.Indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+    const std::vector<unsigned int> &indices = mesh.Indices;
+    // triangles of every vertex
+    std::vector<unsigned int> offsets(mesh.Vertices.size() + 1, 0);
+    for (size_t i = 0; i < indices.size(); ++i)
+        offsets[indices[i] + 1]++;
+    for (size_t v = 0; v < mesh.Vertices.size(); ++v)
+        offsets[v + 1] += offsets[v];
+    std::vector<unsigned int> adjacency(indices.size());
+    {
+        std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i)
+            adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+    }
+    std::vector<glm::vec3> normals(triangleCount), centroids(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        const glm::vec3 &a = mesh.Vertices[indices[t * 3]].Position;
+        const glm::vec3 &b = mesh.Vertices[indices[t * 3 + 1]].Position;
+        const glm::vec3 &c = mesh.Vertices[indices[t * 3 + 2]].Position;
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+        normals[t] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+        centroids[t] = (a + b + c) / 3.0f;
+    }
+    // where a meshlet runs out of neighbours it continues with the nearest triangle left
+    std::vector<KdNode> nodes;
+    std::vector<unsigned int> items(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t)
+        items[t] = (unsigned int)t;
+    nodes.reserve(2 * triangleCount / KD_LEAF_SIZE + 1);
+    buildKdTree(nodes, items, 0, (unsigned int)triangleCount, centroids);
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    std::vector<bool> emitted(triangleCount, false);
+    // stamp of the meshlet a vertex was last counted for
+    std::vector<unsigned int> stamps(mesh.Vertices.size(), 0);
+    std::vector<unsigned int> meshletVertices;
+    // mean position of each meshlet's triangles in the incoming (overdraw) order
+    std::vector<float> ranks;
+    unsigned int stamp = 0;
+    size_t nextSeed = 0;
+    while (output.size() < indices.size())
+    {
+        // seed with the first triangle left in the optimized order, then grow over shared vertices
+        // and on to nearby triangles until the meshlet is full
+        while (emitted[nextSeed])
+            nextSeed++;
+        Meshlet meshlet;
+        meshlet.IndexOffset = (unsigned int)output.size();
+        meshlet.TriangleCount = 0;
+        meshlet.VertexCount = 0;
+        meshletVertices.clear();
+        stamp++;
+        glm::vec3 axis(0.0f);
+        double rank = 0.0;
+        int next = (int)nextSeed;
+        while (next >= 0)
+        {
+            const unsigned int *triangle = &indices[next * 3];
+            emitted[next] = true;
+            for (int k = 0; k < 3; ++k)
+            {
+                output.push_back(triangle[k]);
+                if (stamps[triangle[k]] != stamp)
+                {
+                    stamps[triangle[k]] = stamp;
+                    meshletVertices.push_back(triangle[k]);
+                }
+            }
+            meshlet.TriangleCount++;
+            rank += next;
+            axis += normals[next];
+            float length = glm::length(axis);
+            glm::vec3 direction = length > 0.0f ? axis / length : axis;
+            if (meshlet.TriangleCount == maxTriangles)
+                break;
+            // best neighbour: fewest new vertices, then closest to the meshlet's facing so the normal cone stays narrow
+            next = -1;
+            float bestCost = 1e30f;
+            for (size_t i = 0; i < meshletVertices.size(); ++i)
+            {
+                unsigned int vertex = meshletVertices[i];
+                for (unsigned int j = offsets[vertex]; j < offsets[vertex + 1]; ++j)
+                {
+                    unsigned int t = adjacency[j];
+                    if (emitted[t])
+                        continue;
+                    unsigned int added = 0;
+                    for (int k = 0; k < 3; ++k)
+                        added += stamps[indices[t * 3 + k]] != stamp;
+                    if (meshletVertices.size() + added > maxVertices)
+                        continue;
+                    float cost = added + 2.0f * (1.0f - glm::dot(normals[t], direction));
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        next = (int)t;
+                    }
+                }
+            }
+            // no neighbour left (fragmented geometry): the triangle nearest the middle of the
+            // meshlet's bounds, favouring its facing, if its three vertices still fit
+            if (next < 0 && meshletVertices.size() + 3 <= maxVertices)
+            {
+                glm::vec3 lower = mesh.Vertices[meshletVertices[0]].Position, upper = lower;
+                for (size_t i = 1; i < meshletVertices.size(); ++i)
+                {
+                    lower = glm::min(lower, mesh.Vertices[meshletVertices[i]].Position);
+                    upper = glm::max(upper, mesh.Vertices[meshletVertices[i]].Position);
+                }
+                float distance = 1e30f;
+                findNearest(nodes, 0, items, centroids, normals, emitted, (lower + upper) * 0.5f, direction, next, distance);
+            }
+        }
+        meshlet.VertexCount = (unsigned int)meshletVertices.size();
+        mesh.Meshlets.push_back(meshlet);
+        ranks.push_back((float)(rank / meshlet.TriangleCount));
+    }
+
+    // meshlets in the order of the overdraw clusters their triangles came from, each one's
+    // triangles reordered for the vertex cache (numbered locally, so it only costs its own vertices)
+    std::vector<unsigned int> order(mesh.Meshlets.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = (unsigned int)i;
+    struct ByRank
+    {
+        const std::vector<float> *Ranks;
+        bool operator()(unsigned int a, unsigned int b) const { return (*this->Ranks)[a] < (*this->Ranks)[b]; }
+    } byRank = { &ranks };
+    std::stable_sort(order.begin(), order.end(), byRank);
+    std::vector<Meshlet> meshlets;
+    meshlets.reserve(order.size());
+    std::vector<unsigned int> local, global, localIndex(mesh.Vertices.size());
+    mesh.Indices.clear();
+    stamp++;
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        Meshlet meshlet = mesh.Meshlets[order[i]];
+        const unsigned int *triangles = &output[meshlet.IndexOffset];
+        local.resize(meshlet.TriangleCount * 3);
+        global.clear();
+        for (size_t j = 0; j < local.size(); ++j)
+        {
+            unsigned int vertex = triangles[j];
+            if (stamps[vertex] != stamp)
+            {
+                stamps[vertex] = stamp;
+                localIndex[vertex] = (unsigned int)global.size();
+                global.push_back(vertex);
+            }
+            local[j] = localIndex[vertex];
+        }
+        stamp++;
+        OptimizeVertexCache(local, global.size());
+        meshlet.IndexOffset = (unsigned int)mesh.Indices.size();
+        for (size_t j = 0; j < local.size(); ++j)
+            mesh.Indices.push_back(global[local[j]]);
+        meshlets.push_back(meshlet);
+    }
+    mesh.Meshlets.swap(meshlets);
+    for (size_t i = 0; i < mesh.Meshlets.size(); ++i)
+        finishMeshlet(mesh, mesh.Meshlets[i]);
+}
+
+Frustum ExtractFrustum(const glm::mat4 &clip)
+{
+    // Gribb/Hartmann: the planes are sums and differences of the rows of the matrix
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+        rows[i] = glm::vec4(clip[0][i], clip[1][i], clip[2][i], clip[3][i]);
+    Frustum frustum;
+    frustum.Planes[0] = rows[3] + rows[0]; // left
+    frustum.Planes[1] = rows[3] - rows[0]; // right
+    frustum.Planes[2] = rows[3] + rows[1]; // bottom
+    frustum.Planes[3] = rows[3] - rows[1]; // top
+    frustum.Planes[4] = rows[3] + rows[2]; // near
+    frustum.Planes[5] = rows[3] - rows[2]; // far
+    for (int i = 0; i < 6; ++i)
+    {
+        float length = glm::length(glm::vec3(frustum.Planes[i]));
+        if (length > 0.0f)
+            frustum.Planes[i] /= length;
+    }
+    return frustum;
+}
+
+void CullMeshlets(const std::vector<Meshlet> &meshlets, const Frustum &frustum, const glm::vec3 &cameraPosition,
+    unsigned int indexSize, DrawRanges &ranges, MeshletCullStats &stats)
+{
+    // end of the last range appended by this call, to merge with
+    unsigned int rangeEnd = 0xFFFFFFFFu;
+    for (size_t i = 0; i < meshlets.size(); ++i)
+    {
+        const Meshlet &meshlet = meshlets[i];
+        stats.Meshlets++;
+        stats.Triangles += meshlet.TriangleCount;
+        // back facing: every direction from the camera to the sphere lies inside the cone widened by 90 degrees
+        glm::vec3 toCenter = meshlet.Center - cameraPosition;
+        if (meshlet.ConeCutoff < 1.0f && glm::dot(toCenter, meshlet.ConeAxis) >= meshlet.ConeCutoff * glm::length(toCenter) + meshlet.Radius)
+        {
+            stats.BackfaceCulled++;
+            continue;
+        }
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; ++p)
+            inside = glm::dot(glm::vec3(frustum.Planes[p]), meshlet.Center) + frustum.Planes[p].w > -meshlet.Radius;
+        if (!inside)
+        {
+            stats.FrustumCulled++;
+            continue;
+        }
+        stats.TrianglesDrawn += meshlet.TriangleCount;
+        if (meshlet.IndexOffset == rangeEnd)
+            ranges.Counts.back() += meshlet.TriangleCount * 3;
+        else
+        {
+            ranges.Counts.push_back(meshlet.TriangleCount * 3);
+            ranges.Offsets.push_back((const void*)((size_t)meshlet.IndexOffset * indexSize));
+            stats.Ranges++;
+        }
+        rangeEnd = meshlet.IndexOffset + meshlet.TriangleCount * 3;
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "model_data.h"
+
+// Culling frustum as six inward facing planes (xyz normalized, w distance) in the space of
+// the matrix it was extracted from
+struct Frustum
+{
+    glm::vec4 Planes[6];
+};
+
+// Meshlet counts of a culling pass, accumulated over the meshes and models it ran on
+struct MeshletCullStats
+{
+    unsigned int Meshlets;
+    unsigned int BackfaceCulled;
+    unsigned int FrustumCulled;
+    unsigned int Triangles;
+    unsigned int TrianglesDrawn;
+    unsigned int Ranges;        // Draws left after merging adjacent visible meshlets
+    MeshletCullStats() : Meshlets(0), BackfaceCulled(0), FrustumCulled(0), Triangles(0), TrianglesDrawn(0), Ranges(0) { }
+};
+
+// Index ranges to pass to glMultiDrawElements: index counts and byte offsets into the element buffer
+struct DrawRanges
+{
+    std::vector<int> Counts;
+    std::vector<const void*> Offsets;
+    void Clear() { this->Counts.clear(); this->Offsets.clear(); }
+};
+
+// Splits mesh into mesh.Meshlets of at most maxVertices unique vertices and maxTriangles
+// triangles. Each meshlet is seeded with the first triangle left in the current (optimized)
+// order and grown over shared vertices, preferring triangles facing the way the meshlet
+// does. When no triangle shares a vertex with it, it continues with the triangle nearest the
+// middle of its bounds until it is full. The index buffer is reordered so every meshlet is one
+// contiguous index range: meshlets follow the mean position of their triangles in the current
+// order (the overdraw clusters), and the triangles of each are reordered for the vertex cache.
+// Each meshlet still starts with a cold cache, ProcessModel checks the result against the
+// overdraw budget.
+void BuildMeshlets(MeshData &mesh, unsigned int maxVertices, unsigned int maxTriangles);
+// Extracts the frustum planes of a projection * view (* model) matrix
+Frustum ExtractFrustum(const glm::mat4 &clip);
+// Culls meshlets against frustum and against a camera at cameraPosition (same space as the
+// meshlets), appending the index ranges of the visible ones to ranges. Adjacent visible
+// meshlets are merged into one range.
+void CullMeshlets(const std::vector<Meshlet> &meshlets, const Frustum &frustum, const glm::vec3 &cameraPosition,
+    unsigned int indexSize, DrawRanges &ranges, MeshletCullStats &stats);
+
+#endif
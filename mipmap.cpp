@@ -0,0 +1,224 @@
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "mipmap.h"
+
+
+namespace {
+
+// Entries of the linear to sRGB table, fine enough that every 8-bit code gets its own range
+const int ENCODE_SIZE = 16384;
+// Floats of padding after every row buffer, the 3 component SSE filter reads and writes one pixel past the row
+const size_t ROW_PADDING = 4;
+
+// Conversion tables between 8-bit values and linear floats
+struct ConversionTables
+{
+    float SrgbToLinear[256];
+    float UnitToLinear[256];
+    unsigned char LinearToSrgb[ENCODE_SIZE];
+    ConversionTables()
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            float c = i / 255.0f;
+            SrgbToLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+            UnitToLinear[i] = c;
+        }
+        for (int i = 0; i < ENCODE_SIZE; ++i)
+        {
+            float l = (float)i / (ENCODE_SIZE - 1);
+            float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+            LinearToSrgb[i] = (unsigned char)(c * 255.0f + 0.5f);
+        }
+    }
+};
+
+const ConversionTables &tables()
+{
+    static ConversionTables tables;
+    return tables;
+}
+
+// Whether channel k of a pixel with components channels holds color (the last of 2 or 4 is alpha)
+bool isColor(unsigned int components, unsigned int k)
+{
+    return (components != 2 && components != 4) || k + 1 < components;
+}
+
+void decodeRow(const unsigned char *src, size_t count, unsigned int components, bool srgb, float *dst)
+{
+    const ConversionTables &t = tables();
+    for (unsigned int k = 0; k < components; ++k)
+    {
+        const float *table = srgb && isColor(components, k) ? t.SrgbToLinear : t.UnitToLinear;
+        for (size_t i = k; i < count; i += components)
+            dst[i] = table[src[i]];
+    }
+}
+
+void encodeRow(const float *src, size_t count, unsigned int components, bool srgb, unsigned char *dst)
+{
+    const ConversionTables &t = tables();
+    for (unsigned int k = 0; k < components; ++k)
+    {
+        if (srgb && isColor(components, k))
+            for (size_t i = k; i < count; i += components)
+                dst[i] = t.LinearToSrgb[(int)(src[i] * (ENCODE_SIZE - 1) + 0.5f)];
+        else
+            for (size_t i = k; i < count; i += components)
+                dst[i] = (unsigned char)(src[i] * 255.0f + 0.5f);
+    }
+}
+
+// Averages the 2x2 blocks of source rows a and b into dst, an odd last column is dropped
+// (or repeated if the source is a single pixel wide)
+void filterRowScalar(const float *a, const float *b, unsigned int srcWidth, unsigned int dstWidth, unsigned int components, float *dst)
+{
+    for (unsigned int x = 0; x < dstWidth; ++x)
+    {
+        unsigned int x0 = 2 * x * components;
+        unsigned int x1 = (2 * x + 1 < srcWidth ? 2 * x + 1 : srcWidth - 1) * components;
+        for (unsigned int k = 0; k < components; ++k)
+            dst[x * components + k] = ((a[x0 + k] + a[x1 + k]) + (b[x0 + k] + b[x1 + k])) * 0.25f;
+    }
+}
+
+#ifdef __SSE2__
+// filterRowScalar for an even source width and 1, 3 or 4 components (same sums in the same order)
+bool filterRowSse(const float *a, const float *b, unsigned int srcWidth, unsigned int dstWidth, unsigned int components, float *dst)
+{
+    if (srcWidth != 2 * dstWidth || components == 2)
+        return false;
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    unsigned int x = 0;
+    if (components == 4)
+    {
+        // a pixel per register: add the two pixels of both rows
+        for (; x < dstWidth; ++x)
+        {
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(a + 8 * x), _mm_loadu_ps(a + 8 * x + 4)),
+                _mm_add_ps(_mm_loadu_ps(b + 8 * x), _mm_loadu_ps(b + 8 * x + 4)));
+            _mm_storeu_ps(dst + 4 * x, _mm_mul_ps(sum, quarter));
+        }
+    }
+    else if (components == 3)
+    {
+        // as above with the fourth lane running into the next pixel, overwritten by it (ROW_PADDING covers the last)
+        for (; x < dstWidth; ++x)
+        {
+            __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(a + 6 * x), _mm_loadu_ps(a + 6 * x + 3)),
+                _mm_add_ps(_mm_loadu_ps(b + 6 * x), _mm_loadu_ps(b + 6 * x + 3)));
+            _mm_storeu_ps(dst + 3 * x, _mm_mul_ps(sum, quarter));
+        }
+    }
+    else
+    {
+        // four output texels from eight: add the even and odd lanes of both rows
+        for (; x + 4 <= dstWidth; x += 4)
+        {
+            __m128 a0 = _mm_loadu_ps(a + 2 * x), a1 = _mm_loadu_ps(a + 2 * x + 4);
+            __m128 b0 = _mm_loadu_ps(b + 2 * x), b1 = _mm_loadu_ps(b + 2 * x + 4);
+            __m128 sumA = _mm_add_ps(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1)));
+            __m128 sumB = _mm_add_ps(_mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1)));
+            _mm_storeu_ps(dst + x, _mm_mul_ps(_mm_add_ps(sumA, sumB), quarter));
+        }
+        for (; x < dstWidth; ++x)
+            dst[x] = ((a[2 * x] + a[2 * x + 1]) + (b[2 * x] + b[2 * x + 1])) * 0.25f;
+    }
+    return true;
+}
+#endif
+
+void filterRow(const float *a, const float *b, unsigned int srcWidth, unsigned int dstWidth, unsigned int components, bool simd, float *dst)
+{
+#ifdef __SSE2__
+    if (simd && filterRowSse(a, b, srcWidth, dstWidth, components, dst))
+        return;
+#endif
+    filterRowScalar(a, b, srcWidth, dstWidth, components, dst);
+}
+
+} // namespace
+
+unsigned int MipLevelCount(unsigned int width, unsigned int height)
+{
+    unsigned int size = width > height ? width : height, levels = 1;
+    while (size > 1)
+    {
+        size >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+unsigned int MipLevelSize(unsigned int size, unsigned int level)
+{
+    size >>= level;
+    return size ? size : 1;
+}
+
+size_t MipLevelBytes(unsigned int width, unsigned int height, unsigned int components, unsigned int level)
+{
+    return (size_t)MipLevelSize(width, level) * MipLevelSize(height, level) * components;
+}
+
+size_t MipChainBytes(unsigned int width, unsigned int height, unsigned int components, unsigned int levels)
+{
+    size_t bytes = 0;
+    for (unsigned int level = 0; level < levels; ++level)
+        bytes += MipLevelBytes(width, height, components, level);
+    return bytes;
+}
+
+bool GenerateMipChain(unsigned char *&data, unsigned int width, unsigned int height, unsigned int components, unsigned int levels,
+    bool srgb, bool simd)
+{
+    if (levels <= 1)
+        return true;
+    unsigned char *chain = (unsigned char*)realloc(data, MipChainBytes(width, height, components, levels));
+    if (!chain)
+        return false;
+    data = chain;
+    // level 1 from two decoded rows of level 0 at a time, later levels from the linear copy of the
+    // previous one, so the chain is quantized once per level instead of compounding
+    std::vector<float> rows(2 * ((size_t)width * components + ROW_PADDING));
+    float *row0 = &rows[0], *row1 = &rows[rows.size() / 2];
+    std::vector<float> previous, current;
+    unsigned char *source = chain;
+    for (unsigned int level = 1; level < levels; ++level)
+    {
+        unsigned int srcWidth = MipLevelSize(width, level - 1), srcHeight = MipLevelSize(height, level - 1);
+        unsigned int dstWidth = MipLevelSize(width, level), dstHeight = MipLevelSize(height, level);
+        size_t srcRow = (size_t)srcWidth * components, dstRow = (size_t)dstWidth * components;
+        unsigned char *destination = source + srcRow * srcHeight;
+        current.resize(dstRow * dstHeight + ROW_PADDING);
+        for (unsigned int y = 0; y < dstHeight; ++y)
+        {
+            unsigned int y0 = 2 * y, y1 = 2 * y + 1 < srcHeight ? 2 * y + 1 : srcHeight - 1;
+            const float *a, *b;
+            if (level == 1)
+            {
+                decodeRow(source + y0 * srcRow, srcRow, components, srgb, row0);
+                decodeRow(source + y1 * srcRow, srcRow, components, srgb, row1);
+                a = row0;
+                b = row1;
+            }
+            else
+            {
+                a = &previous[y0 * srcRow];
+                b = &previous[y1 * srcRow];
+            }
+            filterRow(a, b, srcWidth, dstWidth, components, simd, &current[y * dstRow]);
+            encodeRow(&current[y * dstRow], dstRow, components, srgb, destination + y * dstRow);
+        }
+        previous.swap(current);
+        source = destination;
+    }
+    return true;
+}
@@ -0,0 +1,21 @@
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <cstddef>
+
+// Levels of a full mip chain of a width x height image, down to 1x1
+unsigned int MipLevelCount(unsigned int width, unsigned int height);
+// Width (or height) of level of an image size pixels wide
+unsigned int MipLevelSize(unsigned int size, unsigned int level);
+// Bytes of level, rows tightly packed (GL_UNPACK_ALIGNMENT 1)
+size_t MipLevelBytes(unsigned int width, unsigned int height, unsigned int components, unsigned int level);
+// Bytes of the first levels of the chain, stored back to back
+size_t MipChainBytes(unsigned int width, unsigned int height, unsigned int components, unsigned int levels);
+// Grows data (malloc'ed, as stb_image returns it) holding level 0 to hold levels levels and fills
+// them, each a 2x2 box filter of the previous one. With srgb the color channels (not alpha) are
+// averaged in linear space, so dark and bright texels mix the way the eye sees them. simd
+// selects the SSE2 row filter where the build has it. Returns false if out of memory.
+bool GenerateMipChain(unsigned char *&data, unsigned int width, unsigned int height, unsigned int components, unsigned int levels,
+    bool srgb, bool simd = true);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef MODEL_DATA_H
+#define MODEL_DATA_H
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// Vertex layout consumed by car.vs (aPos, aNormal, aTexCoords)
+struct MeshVertex
+{
+    glm::vec3 Position;
+    glm::vec3 Normal;
+    glm::vec2 TexCoords;
+};
+
+// Material parameters as declared in the model's .mtl file
+struct MeshMaterial
+{
+    std::string Name;
+    glm::vec3 Ambient;
+    glm::vec3 Diffuse;
+    glm::vec3 Specular;
+    int Illum;
+    std::string DiffuseMap; // map_Kd, relative to the model directory
+};
+
+// A run of consecutive triangles of a mesh's index buffer, small enough to be
+// culled as a whole (meshlet.h): referenced vertices and triangle count are bounded.
+struct Meshlet
+{
+    unsigned int IndexOffset;   // First index in MeshData::Indices
+    unsigned int TriangleCount;
+    unsigned int VertexCount;   // Unique vertices referenced
+    glm::vec3 Center;           // Bounding sphere, model space
+    float Radius;
+    glm::vec3 ConeAxis;         // Average facing of the triangles
+    float ConeCutoff;           // sin of the cone half angle, 1 if the normals spread too far to cull
+};
+
+// A level of detail of a mesh: a range of MeshData::Indices over the shared vertices. Error
+// bounds how far the level's vertices are from the planes of the original triangles and open
+// borders they replaced (summed over the levels it was simplified through), so it doesn't
+// cover texture seams or the interior of the coarser triangles.
+struct MeshLod
+{
+    unsigned int IndexOffset;
+    unsigned int IndexCount;
+    float Error;                // Model units
+};
+
+// Layout of the vertex buffer uploaded for a mesh
+enum VertexFormat
+{
+    VERTEX_FORMAT_FLOAT,  // MeshVertex, 32 bytes
+    VERTEX_FORMAT_COMPACT // CompactVertex (vertex_format.h), 16 bytes
+};
+
+// CPU-side copy of a single mesh (one material, indexed triangles)
+struct MeshData
+{
+    std::string Name;
+    unsigned int Material; // Index into ModelData::Materials
+    std::vector<MeshVertex> Vertices;
+    std::vector<unsigned int> Indices;
+    std::vector<Meshlet> Meshlets; // Partition of the first level of detail, empty if not built
+    std::vector<MeshLod> Lods;     // Levels of detail, finest first, empty if not built
+    glm::vec3 Center;              // Bounding sphere (set with the levels of detail)
+    float Radius;
+    // GPU vertex layout, compact positions decode as aPos * PositionScale + PositionOffset
+    unsigned int Format;
+    glm::vec3 PositionScale;
+    glm::vec3 PositionOffset;
+    MeshData() : Material(0), Center(0.0f), Radius(0.0f), Format(VERTEX_FORMAT_FLOAT), PositionScale(1.0f), PositionOffset(0.0f) { }
+};
+
+// CPU-side copy of a whole model, independent of any GL state
+struct ModelData
+{
+    std::string Directory;
+    std::vector<MeshMaterial> Materials;
+    std::vector<MeshData> Meshes;
+};
+
+#endif
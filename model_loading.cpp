@@ -8,9 +8,19 @@
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
-#include <learnopengl/model.h>
 
+#include "camera_path.h"
+#include "gl_ext.h"
+#include "headless.h"
+#include "profiler.h"
+#include "static_model.h"
+#include "uniform_buffer.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -31,43 +41,85 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main()
+// usage: model_loading [headless [frames=N] [image.ppm]]
+// "headless" renders into a framebuffer object of an EGL context instead of a window, flies the
+// camera along a scripted path for a fixed number of frames (600 by default) and prints timing statistics.
+int main(int argc, char **argv)
 {
-    // glfw: initialize and configure
-    // ------------------------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    bool headless = false;
+    unsigned int frameCount = 600;
+    std::string imagePath;
+    for (int i = 1; i < argc; ++i)
+    {
+        size_t length = strlen(argv[i]);
+        if (strcmp(argv[i], "headless") == 0)
+            headless = true;
+        else if (strncmp(argv[i], "frames=", 7) == 0)
+            frameCount = (unsigned int)atoi(argv[i] + 7);
+        else if (length > 4 && strcmp(argv[i] + length - 4, ".ppm") == 0)
+            imagePath = argv[i];
+    }
+    if (frameCount < 1)
+        frameCount = 1;
+
+    GLFWwindow* window = NULL;
+    OffscreenTarget offscreen;
+    GLADloadproc loadProc = (GLADloadproc)glfwGetProcAddress;
+    if (headless)
+    {
+        // egl: context without a window
+        // -----------------------------
+        if (!CreateHeadlessContext())
+            return -1;
+        loadProc = (GLADloadproc)HeadlessProcAddress;
+    }
+    else
+    {
+        // glfw: initialize and configure
+        // ------------------------------
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 #ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
 #endif
 
-    // glfw window creation
-    // --------------------
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
-    if (window == NULL)
-    {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
+        // glfw window creation
+        // --------------------
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+        if (window == NULL)
+        {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetScrollCallback(window, scroll_callback);
+
+        // tell GLFW to capture our mouse
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-
-    // tell GLFW to capture our mouse
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
     // glad: load all OpenGL function pointers
     // ---------------------------------------
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    if (!gladLoadGLLoader(loadProc))
     {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    if (!LoadGLExtensions(loadProc))
+        return -1;
+    // headless: draw into a framebuffer object of the window's size
+    if (headless)
+    {
+        if (!offscreen.Generate(SCR_WIDTH, SCR_HEIGHT))
+            return -1;
+        offscreen.Bind();
+    }
 
     // configure global opengl state
     // -----------------------------
@@ -75,11 +127,23 @@ int main()
 
     // build and compile shaders
     // -------------------------
-    Shader ourShader("1.model_loading.vs", "1.model_loading.fs");
+    Shader ourShader("car.vs", "car.fs");
+    BindUniformBlocks(ourShader.ID);
+    ourShader.use();
+    ourShader.setInt("texture_diffuse1", 0);
 
     // load models
     // -----------
-    Model ourModel(FileSystem::getPath("resources/objects/SUV_BF3/suv.obj"));
+    StaticModel ourModel(FileSystem::getPath("resources/objects/SUV_BF3/suv.obj"));
+
+    // uniform buffers: camera and light once per frame, a Draw block per mesh
+    UniformBuffer frameUniforms;
+    frameUniforms.Generate(FRAME_UNIFORM_BINDING, sizeof(FrameUniforms));
+    UniformRing drawUniforms;
+    drawUniforms.Generate(DRAW_UNIFORM_BINDING, sizeof(DrawUniforms), (unsigned int)ourModel.Meshes.size());
+    // frame times of headless runs
+    Profiler profiler(frameCount);
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
 
     
     // draw in wireframe
@@ -87,49 +151,73 @@ int main()
 
     // render loop
     // -----------
-    while (!glfwWindowShouldClose(window))
+    while (headless ? profiler.Frame < frameCount : !glfwWindowShouldClose(window))
     {
         // per-frame time logic
         // --------------------
-        float currentFrame = glfwGetTime();
+        float currentFrame = headless ? std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count() : (float)glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        profiler.BeginFrame();
 
         // input
         // -----
-        processInput(window);
+        if (headless)
+            FollowOrbitPath(camera, glm::vec3(0.0f, -1.75f, 0.0f), (float)profiler.Frame / frameCount);
+        else
+            processInput(window);
 
         // render
         // ------
         glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // don't forget to enable shader before setting uniforms
+        // don't forget to enable shader before drawing
         ourShader.use();
 
-        // view/projection transformations
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        ourShader.setMat4("projection", projection);
-        ourShader.setMat4("view", view);
+        // view/projection transformations, the light sits at the camera
+        drawUniforms.BeginFrame();
+        FrameUniforms frame;
+        frame.Projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        frame.View = camera.GetViewMatrix();
+        frame.ViewPosition = glm::vec4(camera.Position, 1.0f);
+        frame.LightPosition = frame.ViewPosition;
+        frame.LightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+        frameUniforms.Update(&frame);
 
         // render the loaded model
         glm::mat4 model1;
         model1 = glm::translate(model1, glm::vec3(0.0f, -1.75f, 0.0f)); // translate it down so it's at the center of the scene
         model1 = glm::scale(model1, glm::vec3(0.02f, 0.02f, 0.02f));	// it's a bit too big for our scene, so scale it down
-        ourShader.setMat4("model1", model1);
-        ourModel.Draw(ourShader);
+        ourModel.Draw(drawUniforms, model1);
+        drawUniforms.EndFrame();
 
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (!headless)
+        {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        profiler.EndFrame();
+    }
+    if (headless)
+    {
+        glFinish();
+        std::cout << "headless: " << frameCount << " frames, frame average " << profiler.FrameAverage() << " ms, p50 "
+            << profiler.FramePercentile(50.0f) << ", p95 " << profiler.FramePercentile(95.0f) << ", p99 " << profiler.FramePercentile(99.0f)
+            << " ms, image checksum " << std::hex << offscreen.Checksum() << std::dec << std::endl;
+        if (!imagePath.empty() && offscreen.WritePPM(imagePath))
+            std::cout << "wrote " << imagePath << std::endl;
     }
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
-    glfwTerminate();
+    if (headless)
+        DestroyHeadlessContext();
+    else
+        glfwTerminate();
     return 0;
 }
 
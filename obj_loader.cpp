@@ -0,0 +1,587 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+#include "mapped_file.h"
+#include "material_registry.h"
+#include "obj_loader.h"
+#include "path_resolver.h"
+
+
+namespace {
+
+// Target size of a parse chunk, small enough to balance well across workers
+const size_t CHUNK_SIZE = 256 * 1024;
+
+// Face corner as written in the file. Negative (relative) .obj indices can only be
+// resolved once all chunks are parsed, they are flagged and stored chunk-relative.
+const unsigned char LOCAL_V = 1, LOCAL_T = 2, LOCAL_N = 4;
+struct ObjCorner
+{
+    int V, T, N; // 0-based, -1 if absent (and not flagged local)
+    unsigned char Local;
+};
+
+// Run of faces sharing a material. The first run of a chunk inherits the
+// material that was active at the end of the previous chunk.
+struct ObjRun
+{
+    std::string Material;
+    size_t FirstCorner;
+    bool Inherit;
+};
+
+struct ObjChunk
+{
+    const char *Begin, *End;
+    std::vector<glm::vec3> Positions;
+    std::vector<glm::vec2> TexCoords;
+    std::vector<glm::vec3> Normals;
+    std::vector<ObjCorner> Corners; // 3 per triangle
+    std::vector<ObjRun> Runs;
+    std::vector<std::string> Libraries;
+    size_t PositionBase, TexCoordBase, NormalBase;
+};
+
+// Range of triangles of one chunk that belong to one material
+struct ObjRange
+{
+    unsigned int Chunk;
+    size_t Begin, End;
+};
+
+const double POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline const char *skipSpace(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t'))
+        ++p;
+    return p;
+}
+
+// Locale independent decimal parser (strtod honours LC_NUMERIC and is much slower)
+float parseFloat(const char *&p, const char *end)
+{
+    p = skipSpace(p, end);
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    unsigned long long mantissa = 0;
+    int digits = 0, exponent = 0;
+    for (; p < end && isDigit(*p); ++p)
+    {
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        }
+        else
+            exponent++;
+    }
+    if (p < end && *p == '.')
+    {
+        for (++p; p < end && isDigit(*p); ++p)
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                exponent--;
+            }
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negativeExponent = *p++ == '-';
+        int value = 0;
+        for (; p < end && isDigit(*p); ++p)
+            value = value < 10000 ? value * 10 + (*p - '0') : value;
+        exponent += negativeExponent ? -value : value;
+    }
+    double result = (double)mantissa;
+    for (; exponent > 22; exponent -= 22)
+        result *= 1e22;
+    for (; exponent < -22; exponent += 22)
+        result /= 1e22;
+    result = exponent < 0 ? result / POWERS_OF_TEN[-exponent] : result * POWERS_OF_TEN[exponent];
+    return (float)(negative ? -result : result);
+}
+
+inline int parseInt(const char *&p, const char *end)
+{
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    int value = 0;
+    for (; p < end && isDigit(*p); ++p)
+        value = value * 10 + (*p - '0');
+    return negative ? -value : value;
+}
+
+// Converts a 1-based (or negative, relative) .obj index, count is the number of elements parsed so far in the chunk
+inline int resolveIndex(int index, size_t count, unsigned char &local, unsigned char flag)
+{
+    if (index > 0)
+        return index - 1;
+    if (index < 0)
+    {
+        local |= flag;
+        return (int)count + index;
+    }
+    return -1;
+}
+
+// Text between p and end without surrounding whitespace
+std::string restOfLine(const char *p, const char *end)
+{
+    p = skipSpace(p, end);
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+        --end;
+    return std::string(p, end);
+}
+
+inline bool isKeyword(const char *p, const char *end, const char *keyword, size_t length)
+{
+    return (size_t)(end - p) > length && memcmp(p, keyword, length) == 0 && (p[length] == ' ' || p[length] == '\t');
+}
+
+void parseChunk(ObjChunk &chunk)
+{
+    ObjRun first = { std::string(), 0, true };
+    chunk.Runs.push_back(first);
+    for (const char *line = chunk.Begin; line < chunk.End; )
+    {
+        const char *eol = (const char*)memchr(line, '\n', chunk.End - line);
+        if (!eol)
+            eol = chunk.End;
+        const char *p = skipSpace(line, eol);
+        line = eol + 1;
+        if (p == eol || *p == '#')
+            continue;
+        if (p[0] == 'v')
+        {
+            if (p + 1 < eol && (p[1] == ' ' || p[1] == '\t'))
+            {
+                p += 1;
+                glm::vec3 position;
+                position.x = parseFloat(p, eol);
+                position.y = parseFloat(p, eol);
+                position.z = parseFloat(p, eol);
+                chunk.Positions.push_back(position);
+            }
+            else if (isKeyword(p, eol, "vt", 2))
+            {
+                p += 2;
+                glm::vec2 texCoords;
+                texCoords.x = parseFloat(p, eol);
+                // flipped, like aiProcess_FlipUVs: stb_image loads images top row first
+                texCoords.y = 1.0f - parseFloat(p, eol);
+                chunk.TexCoords.push_back(texCoords);
+            }
+            else if (isKeyword(p, eol, "vn", 2))
+            {
+                p += 2;
+                glm::vec3 normal;
+                normal.x = parseFloat(p, eol);
+                normal.y = parseFloat(p, eol);
+                normal.z = parseFloat(p, eol);
+                chunk.Normals.push_back(normal);
+            }
+        }
+        else if (p[0] == 'f' && p + 1 < eol && (p[1] == ' ' || p[1] == '\t'))
+        {
+            // polygons are triangulated as a fan around their first corner
+            ObjCorner corners[3];
+            int count = 0;
+            for (p = skipSpace(p + 1, eol); p < eol && *p != '\r' && *p != '#'; p = skipSpace(p, eol))
+            {
+                ObjCorner corner;
+                corner.Local = 0;
+                corner.V = resolveIndex(parseInt(p, eol), chunk.Positions.size(), corner.Local, LOCAL_V);
+                corner.T = corner.N = -1;
+                if (p < eol && *p == '/')
+                {
+                    ++p;
+                    if (p < eol && *p != '/')
+                        corner.T = resolveIndex(parseInt(p, eol), chunk.TexCoords.size(), corner.Local, LOCAL_T);
+                    if (p < eol && *p == '/')
+                    {
+                        ++p;
+                        corner.N = resolveIndex(parseInt(p, eol), chunk.Normals.size(), corner.Local, LOCAL_N);
+                    }
+                }
+                // skip anything unexpected up to the next corner
+                while (p < eol && *p != ' ' && *p != '\t')
+                    ++p;
+                if (count < 3)
+                    corners[count++] = corner;
+                else
+                {
+                    corners[1] = corners[2];
+                    corners[2] = corner;
+                }
+                if (count == 3)
+                {
+                    chunk.Corners.push_back(corners[0]);
+                    chunk.Corners.push_back(corners[1]);
+                    chunk.Corners.push_back(corners[2]);
+                }
+            }
+        }
+        else if (isKeyword(p, eol, "usemtl", 6))
+        {
+            ObjRun run = { restOfLine(p + 6, eol), chunk.Corners.size(), false };
+            if (chunk.Runs.back().FirstCorner == run.FirstCorner)
+                chunk.Runs.back() = run;
+            else
+                chunk.Runs.push_back(run);
+        }
+        else if (isKeyword(p, eol, "mtllib", 6))
+        {
+            for (p = skipSpace(p + 6, eol); p < eol; p = skipSpace(p, eol))
+            {
+                const char *start = p;
+                while (p < eol && *p != ' ' && *p != '\t' && *p != '\r')
+                    ++p;
+                if (p > start)
+                    chunk.Libraries.push_back(std::string(start, p));
+                else
+                    break;
+            }
+        }
+        // 'g', 'o', 's' and everything else are skipped: groups don't split meshes, meshes are per material
+    }
+}
+
+// Open addressing table mapping (position, texcoord, normal) triples to output vertices
+class CornerTable
+{
+public:
+    CornerTable(size_t corners)
+    {
+        size_t capacity = 16;
+        while (capacity < corners * 2)
+            capacity <<= 1;
+        this->mask = capacity - 1;
+        this->slots.assign(capacity, 0xFFFFFFFFu);
+    }
+    // Returns the vertex index for the triple, isNew tells whether it was just added
+    unsigned int Insert(int v, int t, int n, unsigned int next, bool &isNew)
+    {
+        unsigned int hash = (unsigned int)v * 0x9E3779B1u + (unsigned int)t * 0x85EBCA77u + (unsigned int)n * 0xC2B2AE3Du;
+        hash ^= hash >> 15;
+        for (size_t slot = hash & this->mask; ; slot = (slot + 1) & this->mask)
+        {
+            unsigned int index = this->slots[slot];
+            if (index == 0xFFFFFFFFu)
+            {
+                this->slots[slot] = next;
+                int key[3] = { v, t, n };
+                this->keys.insert(this->keys.end(), key, key + 3);
+                isNew = true;
+                return next;
+            }
+            if (this->keys[index * 3] == v && this->keys[index * 3 + 1] == t && this->keys[index * 3 + 2] == n)
+            {
+                isNew = false;
+                return index;
+            }
+        }
+    }
+private:
+    size_t mask;
+    std::vector<unsigned int> slots;
+    std::vector<int> keys;
+};
+
+struct ObjGlobals
+{
+    std::vector<glm::vec3> Positions;
+    std::vector<glm::vec2> TexCoords;
+    std::vector<glm::vec3> Normals;
+};
+
+inline int globalIndex(int index, unsigned char local, unsigned char flag, size_t base, size_t count)
+{
+    if (local & flag)
+        index += (int)base;
+    return index >= 0 && (size_t)index < count ? index : -1;
+}
+
+void buildMesh(const std::vector<ObjChunk> &chunks, const std::vector<ObjRange> &ranges, const ObjGlobals &globals, MeshData &mesh)
+{
+    size_t corners = 0;
+    for (unsigned int i = 0; i < ranges.size(); ++i)
+        corners += ranges[i].End - ranges[i].Begin;
+    CornerTable table(corners);
+    mesh.Indices.reserve(corners);
+    bool missingNormals = false;
+    for (unsigned int r = 0; r < ranges.size(); ++r)
+    {
+        const ObjChunk &chunk = chunks[ranges[r].Chunk];
+        for (size_t c = ranges[r].Begin; c + 2 < ranges[r].End; c += 3)
+        {
+            int v[3], t[3], n[3];
+            bool valid = true;
+            for (int k = 0; k < 3; ++k)
+            {
+                const ObjCorner &corner = chunk.Corners[c + k];
+                v[k] = globalIndex(corner.V, corner.Local, LOCAL_V, chunk.PositionBase, globals.Positions.size());
+                t[k] = globalIndex(corner.T, corner.Local, LOCAL_T, chunk.TexCoordBase, globals.TexCoords.size());
+                n[k] = globalIndex(corner.N, corner.Local, LOCAL_N, chunk.NormalBase, globals.Normals.size());
+                valid = valid && v[k] >= 0;
+            }
+            if (!valid)
+                continue;
+            for (int k = 0; k < 3; ++k)
+            {
+                bool isNew;
+                unsigned int index = table.Insert(v[k], t[k], n[k], (unsigned int)mesh.Vertices.size(), isNew);
+                if (isNew)
+                {
+                    MeshVertex vertex;
+                    vertex.Position = globals.Positions[v[k]];
+                    vertex.Normal = n[k] >= 0 ? globals.Normals[n[k]] : glm::vec3(0.0f);
+                    vertex.TexCoords = t[k] >= 0 ? globals.TexCoords[t[k]] : glm::vec2(0.0f);
+                    missingNormals = missingNormals || n[k] < 0;
+                    mesh.Vertices.push_back(vertex);
+                }
+                mesh.Indices.push_back(index);
+            }
+        }
+    }
+    if (!missingNormals)
+        return;
+    // vertices without a normal get the area weighted average of their faces
+    std::vector<glm::vec3> accumulated(mesh.Vertices.size(), glm::vec3(0.0f));
+    for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+    {
+        const glm::vec3 &a = mesh.Vertices[mesh.Indices[i]].Position;
+        const glm::vec3 &b = mesh.Vertices[mesh.Indices[i + 1]].Position;
+        const glm::vec3 &c = mesh.Vertices[mesh.Indices[i + 2]].Position;
+        glm::vec3 faceNormal = glm::cross(b - a, c - a);
+        for (int k = 0; k < 3; ++k)
+            accumulated[mesh.Indices[i + k]] += faceNormal;
+    }
+    for (size_t i = 0; i < mesh.Vertices.size(); ++i)
+    {
+        MeshVertex &vertex = mesh.Vertices[i];
+        if (vertex.Normal == glm::vec3(0.0f) && glm::length(accumulated[i]) > 0.0f)
+            vertex.Normal = glm::normalize(accumulated[i]);
+    }
+}
+
+unsigned int findOrAddMaterial(std::vector<MeshMaterial> &materials, const std::string &name)
+{
+    for (unsigned int i = 0; i < materials.size(); ++i)
+        if (materials[i].Name == name)
+            return i;
+    MeshMaterial material;
+    material.Name = name;
+    material.Ambient = glm::vec3(0.0f);
+    material.Diffuse = glm::vec3(1.0f);
+    material.Specular = glm::vec3(0.0f);
+    material.Illum = 0;
+    materials.push_back(material);
+    return (unsigned int)materials.size() - 1;
+}
+
+} // namespace
+
+bool LoadMtl(const std::string &path, std::vector<MeshMaterial> &materials)
+{
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        std::cout << "ERROR::OBJ_LOADER: Failed to open material library " << path << std::endl;
+        return false;
+    }
+    const char *end = file.Data() + file.Size();
+    MeshMaterial *current = NULL;
+    for (const char *line = file.Data(); line < end; )
+    {
+        const char *eol = (const char*)memchr(line, '\n', end - line);
+        if (!eol)
+            eol = end;
+        const char *p = skipSpace(line, eol);
+        line = eol + 1;
+        if (isKeyword(p, eol, "newmtl", 6))
+        {
+            current = &materials[findOrAddMaterial(materials, restOfLine(p + 6, eol))];
+            continue;
+        }
+        if (!current)
+            continue;
+        glm::vec3 *color = isKeyword(p, eol, "Ka", 2) ? &current->Ambient :
+            isKeyword(p, eol, "Kd", 2) ? &current->Diffuse :
+            isKeyword(p, eol, "Ks", 2) ? &current->Specular : NULL;
+        if (color)
+        {
+            p += 2;
+            color->x = parseFloat(p, eol);
+            color->y = parseFloat(p, eol);
+            color->z = parseFloat(p, eol);
+        }
+        else if (isKeyword(p, eol, "illum", 5))
+        {
+            p += 5;
+            current->Illum = (int)parseFloat(p, eol);
+        }
+        else if (isKeyword(p, eol, "map_Kd", 6))
+        {
+            // the file name is the last token, anything before it are options
+            std::string value = restOfLine(p + 6, eol);
+            size_t space = value.find_last_of(" \t");
+            current->DiffuseMap = space == std::string::npos ? value : value.substr(space + 1);
+        }
+    }
+    return true;
+}
+
+bool ParseObj(const char *data, size_t size, const std::string &directory, ModelData &model, ThreadPool &pool)
+{
+    model.Directory = directory;
+    model.Materials.clear();
+    model.Meshes.clear();
+
+    // 1. split into line aligned chunks and parse them in parallel
+    std::vector<ObjChunk> chunks;
+    const char *end = data + size;
+    for (const char *begin = data; begin < end; )
+    {
+        const char *split = begin + CHUNK_SIZE < end ? begin + CHUNK_SIZE : end;
+        if (split < end)
+        {
+            const char *eol = (const char*)memchr(split, '\n', end - split);
+            split = eol ? eol + 1 : end;
+        }
+        ObjChunk chunk;
+        chunk.Begin = begin;
+        chunk.End = split;
+        chunks.push_back(chunk);
+        begin = split;
+    }
+    for (unsigned int i = 0; i < chunks.size(); ++i)
+    {
+        ObjChunk *chunk = &chunks[i];
+        pool.Submit([chunk]() { parseChunk(*chunk); });
+    }
+    pool.Wait();
+
+    // 2. resolve element bases, inherited materials and material libraries in file order
+    ObjGlobals globals;
+    std::vector<MeshMaterial> declared;
+    PathResolver resolver;
+    size_t positions = 0, texCoords = 0, normals = 0;
+    std::string material;
+    for (unsigned int i = 0; i < chunks.size(); ++i)
+    {
+        ObjChunk &chunk = chunks[i];
+        chunk.PositionBase = positions;
+        chunk.TexCoordBase = texCoords;
+        chunk.NormalBase = normals;
+        positions += chunk.Positions.size();
+        texCoords += chunk.TexCoords.size();
+        normals += chunk.Normals.size();
+        for (unsigned int r = 0; r < chunk.Runs.size(); ++r)
+        {
+            if (chunk.Runs[r].Inherit)
+                chunk.Runs[r].Material = material;
+            material = chunk.Runs[r].Material;
+        }
+        for (unsigned int l = 0; l < chunk.Libraries.size(); ++l)
+            LoadMtl(directory + "/" + resolver.Resolve(directory, chunk.Libraries[l]), declared);
+    }
+    globals.Positions.resize(positions);
+    globals.TexCoords.resize(texCoords);
+    globals.Normals.resize(normals);
+    for (unsigned int i = 0; i < chunks.size(); ++i)
+    {
+        const ObjChunk *chunk = &chunks[i];
+        ObjGlobals *target = &globals;
+        pool.Submit([chunk, target]() {
+            std::copy(chunk->Positions.begin(), chunk->Positions.end(), target->Positions.begin() + chunk->PositionBase);
+            std::copy(chunk->TexCoords.begin(), chunk->TexCoords.end(), target->TexCoords.begin() + chunk->TexCoordBase);
+            std::copy(chunk->Normals.begin(), chunk->Normals.end(), target->Normals.begin() + chunk->NormalBase);
+        });
+    }
+
+    // 3. gather the triangle ranges of every distinct material, in order of first use: materials
+    // declared more than once, or under several names with the same parameters, share a mesh
+    MaterialRegistry registry;
+    std::vector<unsigned int> distinct;
+    for (unsigned int i = 0; i < declared.size(); ++i)
+        distinct.push_back(registry.Add(declared[i]));
+    std::vector<std::vector<ObjRange> > ranges;
+    std::vector<unsigned int> meshMaterials;
+    std::map<unsigned int, unsigned int> meshOfMaterial;
+    for (unsigned int i = 0; i < chunks.size(); ++i)
+    {
+        const ObjChunk &chunk = chunks[i];
+        for (unsigned int r = 0; r < chunk.Runs.size(); ++r)
+        {
+            ObjRange range;
+            range.Chunk = i;
+            range.Begin = chunk.Runs[r].FirstCorner;
+            range.End = r + 1 < chunk.Runs.size() ? chunk.Runs[r + 1].FirstCorner : chunk.Corners.size();
+            if (range.Begin == range.End)
+                continue;
+            const std::string &name = chunk.Runs[r].Material.empty() ? std::string("default") : chunk.Runs[r].Material;
+            unsigned int material = findOrAddMaterial(declared, name);
+            if (material == distinct.size())
+                distinct.push_back(registry.Add(declared[material]));
+            std::map<unsigned int, unsigned int>::iterator it = meshOfMaterial.find(distinct[material]);
+            if (it == meshOfMaterial.end())
+            {
+                it = meshOfMaterial.insert(std::make_pair(distinct[material], (unsigned int)ranges.size())).first;
+                ranges.push_back(std::vector<ObjRange>());
+                meshMaterials.push_back(distinct[material]);
+            }
+            ranges[it->second].push_back(range);
+        }
+    }
+    model.Materials = registry.Materials;
+    pool.Wait();
+
+    // 4. build one indexed mesh per material in parallel
+    model.Meshes.resize(ranges.size());
+    for (unsigned int i = 0; i < ranges.size(); ++i)
+    {
+        MeshData *mesh = &model.Meshes[i];
+        mesh->Name = model.Materials[meshMaterials[i]].Name;
+        mesh->Material = meshMaterials[i];
+        const std::vector<ObjChunk> *allChunks = &chunks;
+        const std::vector<ObjRange> *meshRanges = &ranges[i];
+        const ObjGlobals *source = &globals;
+        pool.Submit([allChunks, meshRanges, source, mesh]() { buildMesh(*allChunks, *meshRanges, *source, *mesh); });
+    }
+    pool.Wait();
+    return true;
+}
+
+bool LoadObj(const std::string &path, ModelData &model, ThreadPool *pool)
+{
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        std::cout << "ERROR::OBJ_LOADER: Failed to open " << path << std::endl;
+        return false;
+    }
+    std::string directory = path.substr(0, path.find_last_of('/'));
+    if (pool)
+        return ParseObj(file.Data(), file.Size(), directory, model, *pool);
+    ThreadPool localPool;
+    return ParseObj(file.Data(), file.Size(), directory, model, localPool);
+}
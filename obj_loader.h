@@ -0,0 +1,24 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "model_data.h"
+#include "thread_pool.h"
+
+// Loads a Wavefront .obj file and the .mtl libraries it references into model,
+// producing one indexed mesh per distinct material (see MaterialRegistry). Group,
+// object and smoothing records ('g', 'o', 's') are skipped: unlike Assimp, which
+// made a mesh per group, faces of every group using a material share its mesh. The
+// file is split into line aligned chunks that are parsed in parallel on pool (a
+// temporary pool with one thread per core is used if pool is NULL), then the
+// chunks are stitched together. Library names are matched to the files ignoring case.
+bool LoadObj(const std::string &path, ModelData &model, ThreadPool *pool = NULL);
+// Same as LoadObj for an .obj held in memory, mtllib statements are resolved against directory
+bool ParseObj(const char *data, size_t size, const std::string &directory, ModelData &model, ThreadPool &pool);
+// Parses an .mtl file into materials, a redefined material updates the existing entry
+bool LoadMtl(const std::string &path, std::vector<MeshMaterial> &materials);
+
+#endif
@@ -0,0 +1,309 @@
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "gl_ext.h"
+#include "particle_feedback.h"
+
+
+// Texture unit of the exhaust points during Update, clear of the sprite on unit 0
+const GLuint EXHAUST_TEXTURE_UNIT = 1;
+
+// particle_update.vs reads FeedbackParticle as three vec4
+static_assert(sizeof(FeedbackParticle) == 12 * sizeof(float), "FeedbackParticle is not tightly packed");
+
+// The hash of particle_update.vs
+static GLuint hash(GLuint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Factors of one step, as ParticleSystem::Integrate scales its forces
+struct FeedbackStep
+{
+    float Keep, Grow, Fade;
+    glm::vec2 Acceleration;
+};
+
+static FeedbackStep stepFactors(const ParticleForces &forces, GLfloat dt)
+{
+    FeedbackStep step;
+    step.Keep = std::max(1.0f - forces.Drag * dt, 0.0f);
+    step.Acceleration = glm::vec2(forces.Acceleration.x * dt, forces.Acceleration.y * dt);
+    step.Grow = forces.Growth * dt;
+    step.Fade = forces.Fade * dt;
+    return step;
+}
+
+// Compiles and links the update vertex shader at path, capturing its outputs interleaved;
+// 0 (and the log printed) on failure
+static GLuint loadFeedbackProgram(const char *path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::GPU_PARTICLES: Failed to read " << path << std::endl;
+        return 0;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    std::string code = stream.str();
+    const char *source = code.c_str();
+    GLuint shader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    GLint success;
+    char infoLog[1024];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+        std::cout << "ERROR::GPU_PARTICLES: Failed to compile " << path << "\n" << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, shader);
+    const char *varyings[] = { "outParticle", "outColor", "outState" };
+    glTransformFeedbackVaryings(program, 3, varyings, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(program);
+    glDeleteShader(shader);
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+        std::cout << "ERROR::GPU_PARTICLES: Failed to link " << path << "\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void InitialFeedbackParticles(std::vector<FeedbackParticle> &particles, unsigned int emitters, unsigned int perEmitter, GLfloat lifeMin)
+{
+    particles.resize((size_t)emitters * perEmitter);
+    for (unsigned int i = 0; i < particles.size(); ++i)
+    {
+        FeedbackParticle &particle = particles[i];
+        particle.Particle = glm::vec4(0.0f);
+        particle.Color = glm::vec4(0.0f);
+        particle.State = glm::vec4(0.0f, 0.0f, (float)(hash(i) & 0xffffu) / 65535.0f * lifeMin, 0.0f);
+    }
+}
+
+void StepFeedbackParticles(std::vector<FeedbackParticle> &particles, const std::vector<glm::vec2> &exhausts, unsigned int perEmitter,
+    const ParticleForces &forces, const ParticleEmission &emission, GLfloat dt, GLuint frame)
+{
+    FeedbackStep step = stepFactors(forces, dt);
+    GLuint frameHash = hash(frame);
+    for (unsigned int i = 0; i < particles.size(); ++i)
+    {
+        FeedbackParticle &particle = particles[i];
+        if (particle.State.z <= 0.0f)
+        {
+            GLuint h1 = hash(i ^ frameHash);
+            GLuint h2 = hash(h1);
+            float a = (float)(h1 & 0xffffu) / 65535.0f;
+            float b = (float)(h1 >> 16) / 65535.0f;
+            float c = (float)(h2 & 0xffffu) / 65535.0f;
+            const glm::vec2 &exhaust = exhausts[i / perEmitter];
+            particle.Particle = glm::vec4(exhaust.x, exhaust.y, emission.Size, b * 6.28318f);
+            particle.Color = emission.Color;
+            particle.State = glm::vec4((b - 0.5f) * emission.Spread, -emission.Speed * (1.0f + c * 0.5f),
+                emission.LifeMin + a * emission.LifeRange, 0.0f);
+            continue;
+        }
+        float vx = particle.State.x * step.Keep + step.Acceleration.x;
+        float vy = particle.State.y * step.Keep + step.Acceleration.y;
+        particle.Particle = glm::vec4(particle.Particle.x + vx * dt, particle.Particle.y + vy * dt, particle.Particle.z + step.Grow,
+            particle.Particle.w);
+        particle.Color.w = std::max(particle.Color.w - step.Fade, 0.0f);
+        particle.State = glm::vec4(vx, vy, particle.State.z - dt, 0.0f);
+    }
+}
+
+GpuParticles::GpuParticles()
+    : Program(0), QuadVBO(0), ExhaustBuffer(0), ExhaustTexture(0), Count(0), Current(0), Frame(0), PerEmitter(1), instancedLocation(-1)
+{
+    for (unsigned int i = 0; i < 2; ++i)
+        this->Buffers[i] = this->UpdateVAO[i] = this->DrawVAO[i] = 0;
+    this->Forces.Acceleration = glm::vec2(0.0f);
+    this->Forces.Drag = 0.0f;
+    this->Forces.Growth = 0.0f;
+    this->Forces.Fade = 0.0f;
+    this->Emission.LifeMin = 1.0f;
+    this->Emission.LifeRange = 0.0f;
+    this->Emission.Speed = 0.0f;
+    this->Emission.Spread = 0.0f;
+    this->Emission.Size = 1.0f;
+    this->Emission.Color = glm::vec4(1.0f);
+}
+
+bool GpuParticles::Generate(GLuint drawProgram, unsigned int emitters, unsigned int perEmitter, const char *updatePath)
+{
+    this->Program = loadFeedbackProgram(updatePath);
+    if (!this->Program)
+        return false;
+    this->Count = emitters * perEmitter;
+    this->PerEmitter = perEmitter;
+    this->instancedLocation = glGetUniformLocation(drawProgram, "instanced");
+    this->perEmitterLocation = glGetUniformLocation(this->Program, "perEmitter");
+    this->frameLocation = glGetUniformLocation(this->Program, "frame");
+    this->dtLocation = glGetUniformLocation(this->Program, "dt");
+    this->keepLocation = glGetUniformLocation(this->Program, "keep");
+    this->accelerationLocation = glGetUniformLocation(this->Program, "acceleration");
+    this->growLocation = glGetUniformLocation(this->Program, "grow");
+    this->fadeLocation = glGetUniformLocation(this->Program, "fade");
+    this->lifeMinLocation = glGetUniformLocation(this->Program, "lifeMin");
+    this->lifeRangeLocation = glGetUniformLocation(this->Program, "lifeRange");
+    this->speedLocation = glGetUniformLocation(this->Program, "speed");
+    this->spreadLocation = glGetUniformLocation(this->Program, "spread");
+    this->sizeLocation = glGetUniformLocation(this->Program, "size");
+    this->colorLocation = glGetUniformLocation(this->Program, "emitColor");
+    this->exhaustsLocation = glGetUniformLocation(this->Program, "exhausts");
+
+    std::vector<FeedbackParticle> particles;
+    InitialFeedbackParticles(particles, emitters, perEmitter, this->Emission.LifeMin);
+    glGenBuffers(2, this->Buffers);
+    glGenVertexArrays(2, this->UpdateVAO);
+    glGenVertexArrays(2, this->DrawVAO);
+    GLsizei stride = sizeof(FeedbackParticle);
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, this->Buffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)particles.size() * stride, particles.empty() ? NULL : &particles[0], GL_DYNAMIC_COPY);
+        // particle_update.vs reads all of a particle
+        glBindVertexArray(this->UpdateVAO[i]);
+        for (GLuint attribute = 0; attribute < 3; ++attribute)
+        {
+            glEnableVertexAttribArray(attribute);
+            glVertexAttribPointer(attribute, 4, GL_FLOAT, GL_FALSE, stride, (void*)(attribute * sizeof(glm::vec4)));
+        }
+        // smoke.vs reads the ParticleInstance part per instance
+        glBindVertexArray(this->DrawVAO[i]);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(FeedbackParticle, Particle));
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(FeedbackParticle, Color));
+        glVertexAttribDivisor(2, 1);
+    }
+    glBindVertexArray(0);
+
+    GLfloat quad[] = {
+        // pos        // tex
+        -0.5f,  0.5f, 0.0f, 1.0f,
+         0.5f, -0.5f, 1.0f, 0.0f,
+        -0.5f, -0.5f, 0.0f, 0.0f,
+
+        -0.5f,  0.5f, 0.0f, 1.0f,
+         0.5f,  0.5f, 1.0f, 1.0f,
+         0.5f, -0.5f, 1.0f, 0.0f
+    };
+    glGenBuffers(1, &this->QuadVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->QuadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        glBindVertexArray(this->DrawVAO[i]);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)0);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenBuffers(1, &this->ExhaustBuffer);
+    glGenTextures(1, &this->ExhaustTexture);
+    this->SetExhausts(std::vector<glm::vec2>(emitters, glm::vec2(0.0f)));
+    this->Current = 0;
+    this->Frame = 0;
+    return true;
+}
+
+void GpuParticles::Upload(const std::vector<FeedbackParticle> &particles)
+{
+    if (particles.size() != this->Count || particles.empty())
+        return;
+    glBindBuffer(GL_ARRAY_BUFFER, this->Buffers[this->Current]);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)particles.size() * sizeof(FeedbackParticle), &particles[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GpuParticles::SetExhausts(const std::vector<glm::vec2> &exhausts)
+{
+    glBindBuffer(GL_TEXTURE_BUFFER, this->ExhaustBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)exhausts.size() * sizeof(glm::vec2), exhausts.empty() ? NULL : &exhausts[0], GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, this->ExhaustTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, this->ExhaustBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void GpuParticles::Update(GLfloat dt)
+{
+    if (this->Count == 0)
+        return;
+    FeedbackStep step = stepFactors(this->Forces, dt);
+    // the draws that follow use the caller's program
+    GLint program = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    glUseProgram(this->Program);
+    glUniform1i(this->perEmitterLocation, (GLint)this->PerEmitter);
+    glUniform1ui(this->frameLocation, this->Frame);
+    glUniform1f(this->dtLocation, dt);
+    glUniform1f(this->keepLocation, step.Keep);
+    glUniform2f(this->accelerationLocation, step.Acceleration.x, step.Acceleration.y);
+    glUniform1f(this->growLocation, step.Grow);
+    glUniform1f(this->fadeLocation, step.Fade);
+    glUniform1f(this->lifeMinLocation, this->Emission.LifeMin);
+    glUniform1f(this->lifeRangeLocation, this->Emission.LifeRange);
+    glUniform1f(this->speedLocation, this->Emission.Speed);
+    glUniform1f(this->spreadLocation, this->Emission.Spread);
+    glUniform1f(this->sizeLocation, this->Emission.Size);
+    glUniform4fv(this->colorLocation, 1, &this->Emission.Color[0]);
+    glUniform1i(this->exhaustsLocation, EXHAUST_TEXTURE_UNIT);
+    glActiveTexture(GL_TEXTURE0 + EXHAUST_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, this->ExhaustTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    GLuint next = 1 - this->Current;
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(this->UpdateVAO[this->Current]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, this->Buffers[next]);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, (GLsizei)this->Count);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    glUseProgram((GLuint)program);
+    this->Current = next;
+    this->Frame++;
+}
+
+void GpuParticles::Draw()
+{
+    if (this->Count == 0)
+        return;
+    glUniform1i(this->instancedLocation, 1);
+    glBindVertexArray(this->DrawVAO[this->Current]);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)this->Count);
+    glBindVertexArray(0);
+}
+
+void GpuParticles::Read(std::vector<FeedbackParticle> &particles) const
+{
+    particles.resize(this->Count);
+    if (this->Count == 0)
+        return;
+    glBindBuffer(GL_ARRAY_BUFFER, this->Buffers[this->Current]);
+    glGetBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)this->Count * sizeof(FeedbackParticle), &particles[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,77 @@
+#ifndef PARTICLE_FEEDBACK_H
+#define PARTICLE_FEEDBACK_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "particle_system.h"
+
+// Layout of a particle in the transform feedback buffers, its first two vec4 are the
+// ParticleInstance smoke.vs reads
+struct FeedbackParticle
+{
+    glm::vec4 Particle; // Position xy, size, rotation
+    glm::vec4 Color;
+    glm::vec4 State;    // Velocity xy, life, unused
+};
+
+// How dead particles are emitted again from the exhaust of their emitter
+struct ParticleEmission
+{
+    GLfloat LifeMin, LifeRange; // Seconds
+    GLfloat Speed, Spread;      // Upward speed (up to 1.5x), sideways spread
+    GLfloat Size;
+    glm::vec4 Color;
+};
+
+// Particles waiting to be emitted, perEmitter for each of emitters, invisible and with lives
+// spread over lifeMin seconds so they are emitted over the first frames instead of at once
+void InitialFeedbackParticles(std::vector<FeedbackParticle> &particles, unsigned int emitters, unsigned int perEmitter, GLfloat lifeMin);
+// Steps particles on the CPU with the arithmetic of particle_update.vs, as GpuParticles::Update
+// with the same exhausts, forces, emission, dt and frame
+void StepFeedbackParticles(std::vector<FeedbackParticle> &particles, const std::vector<glm::vec2> &exhausts, unsigned int perEmitter,
+    const ParticleForces &forces, const ParticleEmission &emission, GLfloat dt, GLuint frame);
+
+// Particles simulated without leaving the GPU: particle_update.vs steps every particle of one
+// buffer and transform feedback writes it to the other (rasterizer discarded), the two buffers
+// swapping roles every step. Dead particles are emitted again from their emitter's exhaust
+// point, read from a buffer texture. Draw renders the last written buffer with smoke.vs /
+// smoke.fs as instances, the attributes pointing straight into it.
+class GpuParticles
+{
+public:
+    GLuint Program;            // particle_update.vs
+    GLuint Buffers[2];         // Particle states, the last written one is Buffers[Current]
+    GLuint UpdateVAO[2], DrawVAO[2];
+    GLuint QuadVBO;
+    GLuint ExhaustBuffer, ExhaustTexture;
+    GLuint Count, Current, Frame;
+    unsigned int PerEmitter;
+    ParticleForces Forces;
+    ParticleEmission Emission;
+    // Constructor (objects created by Generate)
+    GpuParticles();
+    // Compiles updatePath, creates the buffers for perEmitter particles of each of emitters
+    // starting out as InitialFeedbackParticles and the vertex arrays drawing them with
+    // drawProgram (smoke.vs), false if the program fails to build. Emission.LifeMin spreads the
+    // first emissions, set it before.
+    bool Generate(GLuint drawProgram, unsigned int emitters, unsigned int perEmitter, const char *updatePath = "particle_update.vs");
+    // Replaces the particle states (Count of them)
+    void Upload(const std::vector<FeedbackParticle> &particles);
+    // Moves the exhaust points, one per emitter
+    void SetExhausts(const std::vector<glm::vec2> &exhausts);
+    // Steps all particles over dt seconds into the other buffer
+    void Update(GLfloat dt);
+    // Draws the particles instanced, drawProgram in use
+    void Draw();
+    // Reads the particle states back (stalls)
+    void Read(std::vector<FeedbackParticle> &particles) const;
+private:
+    GLint instancedLocation;
+    GLint perEmitterLocation, frameLocation, dtLocation, keepLocation, accelerationLocation, growLocation, fadeLocation;
+    GLint lifeMinLocation, lifeRangeLocation, speedLocation, spreadLocation, sizeLocation, colorLocation, exhaustsLocation;
+};
+
+#endif
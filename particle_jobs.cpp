@@ -0,0 +1,47 @@
+#include "particle_jobs.h"
+
+
+// Compacts system and submits the fill of its instances, after its integration jobs
+static void fillJobs(JobSystem &jobs, ParticleSystem *system, ParticleRenderer *renderer, unsigned int chunk)
+{
+    system->Compact();
+    if (system->Count == 0)
+        return;
+    ParticleInstance *instances = renderer->Allocate(system->Count);
+    if (!instances)
+        return;
+    // a single chunk is filled right away
+    if (system->Count <= chunk)
+    {
+        system->Fill(instances, 0, system->Count);
+        return;
+    }
+    for (unsigned int first = 0; first < system->Count; first += chunk)
+        jobs.Submit(jobs.Create([=]() { system->Fill(instances + first, first, chunk); }));
+}
+
+void SubmitParticleUpdate(JobSystem &jobs, const std::vector<ParticleSystem*> &systems, GLfloat dt, ParticleRenderer &renderer,
+    unsigned int chunk)
+{
+    ParticleRenderer *target = &renderer;
+    JobSystem *pool = &jobs;
+    std::vector<Job*> integrate;
+    for (unsigned int i = 0; i < systems.size(); ++i)
+    {
+        ParticleSystem *system = systems[i];
+        if (system->Count == 0)
+            continue;
+        Job *fill = jobs.Create([=]() { fillJobs(*pool, system, target, chunk); });
+        integrate.clear();
+        for (unsigned int first = 0; first < system->Count; first += chunk)
+        {
+            Job *job = jobs.Create([=]() { system->Integrate(dt, first, chunk); });
+            jobs.DependsOn(fill, job);
+            integrate.push_back(job);
+        }
+        // the fill job waits for all of them, so it can only run after they were submitted
+        jobs.Submit(fill);
+        for (unsigned int j = 0; j < integrate.size(); ++j)
+            jobs.Submit(integrate[j]);
+    }
+}
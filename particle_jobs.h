@@ -0,0 +1,23 @@
+#ifndef PARTICLE_JOBS_H
+#define PARTICLE_JOBS_H
+
+#include <glad/glad.h>
+
+#include <vector>
+
+#include "job_system.h"
+#include "particle_renderer.h"
+#include "particle_system.h"
+
+// Particles per integration and instance fill job
+const unsigned int PARTICLE_JOB_CHUNK = 4096;
+
+// Submits the update of systems over dt seconds to jobs. Every system is integrated in jobs of
+// chunk particles; once they finished, a job compacts it, allocates its instances in renderer
+// and submits the jobs filling them, also chunk particles each, while other systems may still
+// be integrating. The frame's instances are complete after jobs.Wait(), in no particular order
+// of systems. renderer.BeginFrame comes first, the systems stay untouched until the wait.
+void SubmitParticleUpdate(JobSystem &jobs, const std::vector<ParticleSystem*> &systems, GLfloat dt, ParticleRenderer &renderer,
+    unsigned int chunk = PARTICLE_JOB_CHUNK);
+
+#endif
@@ -0,0 +1,176 @@
+#include <cstddef>
+#include <iostream>
+
+#include "gl_ext.h"
+#include "particle_renderer.h"
+
+
+ParticleRenderer::ParticleRenderer()
+    : VAO(0), QuadVBO(0), InstanceVBO(0), Capacity(0), Persistent(false), mapped(NULL), frame(0), count(0), drawn(0),
+      instancedLocation(-1), particleLocation(-1), colorLocation(-1)
+{
+    for (unsigned int i = 0; i < UNIFORM_RING_FRAMES; ++i)
+        this->fences[i] = 0;
+}
+
+void ParticleRenderer::Generate(GLuint program, GLuint capacity)
+{
+    this->Capacity = capacity;
+    this->instancedLocation = glGetUniformLocation(program, "instanced");
+    this->particleLocation = glGetUniformLocation(program, "particle");
+    this->colorLocation = glGetUniformLocation(program, "color");
+    // a unit quad centered on the particle, smoke.vs scales and rotates it
+    GLfloat quad[] = {
+        // pos        // tex
+        -0.5f,  0.5f, 0.0f, 1.0f,
+         0.5f, -0.5f, 1.0f, 0.0f,
+        -0.5f, -0.5f, 0.0f, 0.0f,
+
+        -0.5f,  0.5f, 0.0f, 1.0f,
+         0.5f,  0.5f, 1.0f, 1.0f,
+         0.5f, -0.5f, 1.0f, 0.0f
+    };
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &this->QuadVBO);
+    glGenBuffers(1, &this->InstanceVBO);
+    glBindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->QuadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (void*)0);
+    glBindVertexArray(0);
+
+    GLsizeiptr size = (GLsizeiptr)capacity * sizeof(ParticleInstance);
+    glBindBuffer(GL_ARRAY_BUFFER, this->InstanceVBO);
+    this->Persistent = glBufferStorage != NULL;
+    if (this->Persistent)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, size * UNIFORM_RING_FRAMES, NULL, flags);
+        this->mapped = (ParticleInstance*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size * UNIFORM_RING_FRAMES, flags);
+        if (!this->mapped)
+        {
+            std::cout << "ERROR::PARTICLE_RENDERER: persistent mapping failed, uploading instances instead" << std::endl;
+            // buffer storage is immutable, start over with a plain buffer
+            glDeleteBuffers(1, &this->InstanceVBO);
+            glGenBuffers(1, &this->InstanceVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, this->InstanceVBO);
+            this->Persistent = false;
+        }
+    }
+    if (!this->Persistent)
+    {
+        // a single frame of storage, orphaned by every frame's first Draw
+        glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+        this->staging.resize(capacity);
+    }
+    // per-instance attributes, pointed at this frame's instances by Draw
+    glBindVertexArray(this->VAO);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)offsetof(ParticleInstance, Particle));
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)offsetof(ParticleInstance, Color));
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ParticleRenderer::BeginFrame()
+{
+    GLsync &fence = this->fences[this->frame];
+    if (fence)
+    {
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        while (result == GL_TIMEOUT_EXPIRED)
+            result = glClientWaitSync(fence, 0, 1000000000);
+        glDeleteSync(fence);
+        fence = 0;
+    }
+    this->count = 0;
+    this->drawn = 0;
+}
+
+ParticleInstance *ParticleRenderer::Allocate(GLuint count)
+{
+    GLuint first = this->count;
+    do
+    {
+        if (first + count > this->Capacity)
+        {
+            std::cout << "ERROR::PARTICLE_RENDERER: more than " << this->Capacity << " particles in a frame" << std::endl;
+            return NULL;
+        }
+    } while (!this->count.compare_exchange_weak(first, first + count));
+    ParticleInstance *instances = this->Persistent ? this->mapped + (size_t)this->frame * this->Capacity : &this->staging[0];
+    return instances + first;
+}
+
+GLuint ParticleRenderer::Add(const std::vector<Particle> &particles)
+{
+    GLuint live = 0;
+    for (unsigned int i = 0; i < particles.size(); ++i)
+        live += particles[i].Life > 0.0f;
+    ParticleInstance *instances = live > 0 ? this->Allocate(live) : NULL;
+    if (!instances)
+        return 0;
+    for (unsigned int i = 0; i < particles.size(); ++i)
+    {
+        const Particle &particle = particles[i];
+        if (particle.Life <= 0.0f)
+            continue;
+        instances->Particle = glm::vec4(particle.Position.x, particle.Position.y, particle.Size, particle.Rotation);
+        instances->Color = particle.Color;
+        ++instances;
+    }
+    return live;
+}
+
+void ParticleRenderer::Draw()
+{
+    if (this->count == this->drawn)
+        return;
+    GLuint instances = this->count - this->drawn;
+    size_t first = this->drawn;
+    glBindBuffer(GL_ARRAY_BUFFER, this->InstanceVBO);
+    if (this->Persistent)
+        first += (size_t)this->frame * this->Capacity;
+    else
+    {
+        // fresh storage on the frame's first draw, the previous frame's may still be read
+        if (this->drawn == 0)
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)this->Capacity * sizeof(ParticleInstance), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(first * sizeof(ParticleInstance)), (GLsizeiptr)instances * sizeof(ParticleInstance),
+            &this->staging[first]);
+    }
+    glBindVertexArray(this->VAO);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)(first * sizeof(ParticleInstance) + offsetof(ParticleInstance, Particle)));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)(first * sizeof(ParticleInstance) + offsetof(ParticleInstance, Color)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUniform1i(this->instancedLocation, 1);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)instances);
+    glBindVertexArray(0);
+    this->drawn = this->count;
+}
+
+void ParticleRenderer::DrawPerParticle(const std::vector<Particle> &particles)
+{
+    glUniform1i(this->instancedLocation, 0);
+    glBindVertexArray(this->VAO);
+    for (unsigned int i = 0; i < particles.size(); ++i)
+    {
+        const Particle &particle = particles[i];
+        if (particle.Life <= 0.0f)
+            continue;
+        glUniform4f(this->particleLocation, particle.Position.x, particle.Position.y, particle.Size, particle.Rotation);
+        glUniform4fv(this->colorLocation, 1, &particle.Color[0]);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+    }
+    glBindVertexArray(0);
+}
+
+void ParticleRenderer::EndFrame()
+{
+    this->fences[this->frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    this->frame = (this->frame + 1) % UNIFORM_RING_FRAMES;
+}
@@ -0,0 +1,69 @@
+#ifndef PARTICLE_RENDERER_H
+#define PARTICLE_RENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <vector>
+
+#include "uniform_buffer.h"
+
+// Represents a single smoke particle and its state
+struct Particle
+{
+    glm::vec2 Position, Velocity;
+    glm::vec4 Color;
+    GLfloat Size, Rotation; // Quad edge in pixels, radians
+    GLfloat Life;           // Seconds left, dead at 0
+};
+
+// Per-instance attributes of a particle read by smoke.vs
+struct ParticleInstance
+{
+    glm::vec4 Particle; // Offset xy, size, rotation
+    glm::vec4 Color;
+};
+
+// Draws the particles of all emitters of a frame with one glDrawArraysInstanced. Live
+// particles are packed into a streaming instance buffer holding UNIFORM_RING_FRAMES frames of
+// Capacity instances, a fence per frame keeps the CPU from overwriting instances still drawn.
+// With GL 4.4 / ARB_buffer_storage the buffer is mapped once (persistent, coherent) and
+// instances are written straight into it, otherwise they are staged and uploaded at Draw into
+// orphaned storage. DrawPerParticle keeps the old path, a uniform update and draw per particle.
+class ParticleRenderer
+{
+public:
+    GLuint VAO, QuadVBO, InstanceVBO;
+    GLuint Capacity;  // Instances per frame
+    bool Persistent;  // Mapped once instead of uploaded per frame
+    // Constructor (buffers created by Generate)
+    ParticleRenderer();
+    // Creates the quad and the instance ring for capacity particles per frame, drawn with program (smoke.vs)
+    void Generate(GLuint program, GLuint capacity);
+    // Starts the next frame, waits until the GPU is done with its instances
+    void BeginFrame();
+    // Room for count instances to write before Draw, NULL when the frame ran out of capacity.
+    // May be called from several threads at once, as the particle update jobs do.
+    ParticleInstance *Allocate(GLuint count);
+    // Packs the live particles of an emitter, returns how many were added
+    GLuint Add(const std::vector<Particle> &particles);
+    // Instances added this frame
+    GLuint Size() const { return this->count; }
+    // Draws everything added since the last Draw with one instanced draw, program in use
+    void Draw();
+    // Draws the live particles one uniform update and draw call each, program in use
+    void DrawPerParticle(const std::vector<Particle> &particles);
+    // Ends the frame, fencing its instances
+    void EndFrame();
+private:
+    ParticleInstance *mapped;
+    std::vector<ParticleInstance> staging; // Instances of the frame without a persistent mapping
+    GLsync fences[UNIFORM_RING_FRAMES];
+    unsigned int frame;
+    std::atomic<GLuint> count; // Instances added this frame
+    GLuint drawn;              // The ones already drawn
+    GLint instancedLocation, particleLocation, colorLocation;
+};
+
+#endif
@@ -0,0 +1,230 @@
+#include <algorithm>
+
+#include "particle_system.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+// the AVX2 kernel is compiled for its own target and only run after CPUID reports AVX2
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PARTICLE_AVX2
+#include <immintrin.h>
+#endif
+
+
+// Particles per vector of the widest kernel, every stream is padded to a multiple of it
+const unsigned int PARTICLE_LANES = 8;
+const unsigned int PARTICLE_STREAMS = 11;
+
+// Factors of one Integrate step, the same for every kernel so they give the same results
+struct StepConstants
+{
+    float Dt, Keep, AccelerationX, AccelerationY, Grow, Fade;
+};
+
+ParticleKernel DetectParticleKernel()
+{
+#ifdef PARTICLE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return PARTICLE_KERNEL_AVX2;
+#endif
+#ifdef __SSE2__
+    return PARTICLE_KERNEL_SSE;
+#else
+    return PARTICLE_KERNEL_SCALAR;
+#endif
+}
+
+const char *ParticleKernelName(ParticleKernel kernel)
+{
+    switch (kernel)
+    {
+    case PARTICLE_KERNEL_SSE:
+        return "SSE";
+    case PARTICLE_KERNEL_AVX2:
+        return "AVX2";
+    default:
+        return "scalar";
+    }
+}
+
+static void integrateScalar(ParticleSystem &system, const StepConstants &step, unsigned int first, unsigned int end)
+{
+    for (unsigned int i = first; i < end; ++i)
+    {
+        system.VelocityX[i] = system.VelocityX[i] * step.Keep + step.AccelerationX;
+        system.VelocityY[i] = system.VelocityY[i] * step.Keep + step.AccelerationY;
+        system.PositionX[i] = system.PositionX[i] + system.VelocityX[i] * step.Dt;
+        system.PositionY[i] = system.PositionY[i] + system.VelocityY[i] * step.Dt;
+        system.Life[i] = system.Life[i] - step.Dt;
+        system.Size[i] = system.Size[i] + step.Grow;
+        system.ColorA[i] = std::max(system.ColorA[i] - step.Fade, 0.0f);
+    }
+}
+
+#ifdef __SSE2__
+static void integrateSSE(ParticleSystem &system, const StepConstants &step, unsigned int first, unsigned int end)
+{
+    const __m128 dt = _mm_set1_ps(step.Dt), keep = _mm_set1_ps(step.Keep), grow = _mm_set1_ps(step.Grow), fade = _mm_set1_ps(step.Fade);
+    const __m128 ax = _mm_set1_ps(step.AccelerationX), ay = _mm_set1_ps(step.AccelerationY), zero = _mm_setzero_ps();
+    for (unsigned int i = first; i < end; i += 4)
+    {
+        __m128 vx = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(system.VelocityX + i), keep), ax);
+        __m128 vy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(system.VelocityY + i), keep), ay);
+        _mm_storeu_ps(system.VelocityX + i, vx);
+        _mm_storeu_ps(system.VelocityY + i, vy);
+        _mm_storeu_ps(system.PositionX + i, _mm_add_ps(_mm_loadu_ps(system.PositionX + i), _mm_mul_ps(vx, dt)));
+        _mm_storeu_ps(system.PositionY + i, _mm_add_ps(_mm_loadu_ps(system.PositionY + i), _mm_mul_ps(vy, dt)));
+        _mm_storeu_ps(system.Life + i, _mm_sub_ps(_mm_loadu_ps(system.Life + i), dt));
+        _mm_storeu_ps(system.Size + i, _mm_add_ps(_mm_loadu_ps(system.Size + i), grow));
+        _mm_storeu_ps(system.ColorA + i, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(system.ColorA + i), fade), zero));
+    }
+}
+#endif
+
+#ifdef PARTICLE_AVX2
+// no FMA: multiply and add round separately, as in the other kernels
+__attribute__((target("avx2")))
+static void integrateAVX2(ParticleSystem &system, const StepConstants &step, unsigned int first, unsigned int end)
+{
+    const __m256 dt = _mm256_set1_ps(step.Dt), keep = _mm256_set1_ps(step.Keep), grow = _mm256_set1_ps(step.Grow), fade = _mm256_set1_ps(step.Fade);
+    const __m256 ax = _mm256_set1_ps(step.AccelerationX), ay = _mm256_set1_ps(step.AccelerationY), zero = _mm256_setzero_ps();
+    for (unsigned int i = first; i < end; i += 8)
+    {
+        __m256 vx = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(system.VelocityX + i), keep), ax);
+        __m256 vy = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(system.VelocityY + i), keep), ay);
+        _mm256_storeu_ps(system.VelocityX + i, vx);
+        _mm256_storeu_ps(system.VelocityY + i, vy);
+        _mm256_storeu_ps(system.PositionX + i, _mm256_add_ps(_mm256_loadu_ps(system.PositionX + i), _mm256_mul_ps(vx, dt)));
+        _mm256_storeu_ps(system.PositionY + i, _mm256_add_ps(_mm256_loadu_ps(system.PositionY + i), _mm256_mul_ps(vy, dt)));
+        _mm256_storeu_ps(system.Life + i, _mm256_sub_ps(_mm256_loadu_ps(system.Life + i), dt));
+        _mm256_storeu_ps(system.Size + i, _mm256_add_ps(_mm256_loadu_ps(system.Size + i), grow));
+        _mm256_storeu_ps(system.ColorA + i, _mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(system.ColorA + i), fade), zero));
+    }
+}
+#endif
+
+ParticleSystem::ParticleSystem()
+    : PositionX(NULL), PositionY(NULL), VelocityX(NULL), VelocityY(NULL), Life(NULL), Size(NULL), Rotation(NULL),
+      ColorR(NULL), ColorG(NULL), ColorB(NULL), ColorA(NULL), Count(0), Capacity(0), Kernel(PARTICLE_KERNEL_SCALAR)
+{
+    this->Forces.Acceleration = glm::vec2(0.0f);
+    this->Forces.Drag = 0.0f;
+    this->Forces.Growth = 0.0f;
+    this->Forces.Fade = 0.0f;
+}
+
+void ParticleSystem::Generate(unsigned int capacity)
+{
+    // streams padded to whole vectors, so they all start as aligned as the first
+    unsigned int stride = (capacity + PARTICLE_LANES - 1) / PARTICLE_LANES * PARTICLE_LANES;
+    this->storage.assign((size_t)stride * PARTICLE_STREAMS, 0.0f);
+    GLfloat **streams[PARTICLE_STREAMS] = { &this->PositionX, &this->PositionY, &this->VelocityX, &this->VelocityY, &this->Life,
+        &this->Size, &this->Rotation, &this->ColorR, &this->ColorG, &this->ColorB, &this->ColorA };
+    for (unsigned int i = 0; i < PARTICLE_STREAMS; ++i)
+        *streams[i] = &this->storage[(size_t)i * stride];
+    this->Count = 0;
+    this->Capacity = capacity;
+    this->Kernel = DetectParticleKernel();
+}
+
+bool ParticleSystem::Emit(const Particle &particle)
+{
+    if (this->Count == this->Capacity)
+        return false;
+    unsigned int i = this->Count++;
+    this->PositionX[i] = particle.Position.x;
+    this->PositionY[i] = particle.Position.y;
+    this->VelocityX[i] = particle.Velocity.x;
+    this->VelocityY[i] = particle.Velocity.y;
+    this->Life[i] = particle.Life;
+    this->Size[i] = particle.Size;
+    this->Rotation[i] = particle.Rotation;
+    this->ColorR[i] = particle.Color.x;
+    this->ColorG[i] = particle.Color.y;
+    this->ColorB[i] = particle.Color.z;
+    this->ColorA[i] = particle.Color.w;
+    return true;
+}
+
+void ParticleSystem::Integrate(GLfloat dt, unsigned int first, unsigned int count)
+{
+    StepConstants step;
+    step.Dt = dt;
+    step.Keep = std::max(1.0f - this->Forces.Drag * dt, 0.0f);
+    step.AccelerationX = this->Forces.Acceleration.x * dt;
+    step.AccelerationY = this->Forces.Acceleration.y * dt;
+    step.Grow = this->Forces.Growth * dt;
+    step.Fade = this->Forces.Fade * dt;
+    unsigned int end = std::min(first + count, this->Count);
+    if (first >= end)
+        return;
+    // whole vectors with the kernel, the rest one at a time
+    unsigned int vectorEnd;
+    switch (this->Kernel)
+    {
+#ifdef PARTICLE_AVX2
+    case PARTICLE_KERNEL_AVX2:
+        vectorEnd = first + (end - first) / 8 * 8;
+        integrateAVX2(*this, step, first, vectorEnd);
+        break;
+#endif
+#ifdef __SSE2__
+    case PARTICLE_KERNEL_SSE:
+        vectorEnd = first + (end - first) / 4 * 4;
+        integrateSSE(*this, step, first, vectorEnd);
+        break;
+#endif
+    default:
+        vectorEnd = first;
+        break;
+    }
+    integrateScalar(*this, step, vectorEnd, end);
+}
+
+void ParticleSystem::Compact()
+{
+    GLfloat *streams[PARTICLE_STREAMS] = { this->PositionX, this->PositionY, this->VelocityX, this->VelocityY, this->Life,
+        this->Size, this->Rotation, this->ColorR, this->ColorG, this->ColorB, this->ColorA };
+    unsigned int i = 0;
+#ifdef __SSE2__
+    const __m128 zero = _mm_setzero_ps();
+#endif
+    while (i < this->Count)
+    {
+#ifdef __SSE2__
+        // skip 4 live particles at a time, most are
+        if (i + 4 <= this->Count && _mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(this->Life + i), zero)) == 0)
+        {
+            i += 4;
+            continue;
+        }
+#endif
+        if (this->Life[i] > 0.0f)
+        {
+            ++i;
+            continue;
+        }
+        // the last particle takes the place of the dead one and is tested next
+        unsigned int last = --this->Count;
+        for (unsigned int s = 0; s < PARTICLE_STREAMS; ++s)
+            streams[s][i] = streams[s][last];
+    }
+}
+
+void ParticleSystem::Update(GLfloat dt)
+{
+    this->Integrate(dt, 0, this->Count);
+    this->Compact();
+}
+
+void ParticleSystem::Fill(ParticleInstance *instances, unsigned int first, unsigned int count) const
+{
+    unsigned int end = std::min(first + count, this->Count);
+    for (unsigned int i = first; i < end; ++i, ++instances)
+    {
+        instances->Particle = glm::vec4(this->PositionX[i], this->PositionY[i], this->Size[i], this->Rotation[i]);
+        instances->Color = glm::vec4(this->ColorR[i], this->ColorG[i], this->ColorB[i], this->ColorA[i]);
+    }
+}
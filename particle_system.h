@@ -0,0 +1,65 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "particle_renderer.h"
+
+// Update kernels of ParticleSystem, the widest one the CPU runs is picked at Generate
+enum ParticleKernel
+{
+    PARTICLE_KERNEL_SCALAR,
+    PARTICLE_KERNEL_SSE,  // 4 particles at a time (SSE2)
+    PARTICLE_KERNEL_AVX2  // 8 particles at a time, GCC builds on CPUs reporting AVX2
+};
+
+// Widest kernel this build and CPU (CPUID) can run
+ParticleKernel DetectParticleKernel();
+// Name of kernel for reports
+const char *ParticleKernelName(ParticleKernel kernel);
+
+// Forces acting on all particles of a system
+struct ParticleForces
+{
+    glm::vec2 Acceleration; // Gravity, or buoyancy for smoke
+    GLfloat Drag;           // Fraction of the velocity lost per second
+    GLfloat Growth;         // Size gained per second
+    GLfloat Fade;           // Alpha lost per second
+};
+
+// Particles of an emitter in structure of arrays form: a stream of floats per attribute, so
+// the update kernels load, integrate and store 4 or 8 particles at a time. All streams are
+// allocated once by Generate, padded to a whole number of AVX2 vectors. Dead particles are
+// removed by moving the last live particle into their place, so live particles stay packed at
+// the front and the order is not kept.
+class ParticleSystem
+{
+public:
+    GLfloat *PositionX, *PositionY, *VelocityX, *VelocityY;
+    GLfloat *Life, *Size, *Rotation;
+    GLfloat *ColorR, *ColorG, *ColorB, *ColorA;
+    unsigned int Count, Capacity; // Live particles, room for
+    ParticleForces Forces;
+    ParticleKernel Kernel;        // Used by Integrate, may be set to a narrower one
+    // Constructor (streams allocated by Generate)
+    ParticleSystem();
+    // Allocates the streams for capacity particles and picks the kernel
+    void Generate(unsigned int capacity);
+    // Appends particle, false when full
+    bool Emit(const Particle &particle);
+    // Integrates count particles from first on over dt seconds, dead ones stay until Compact
+    void Integrate(GLfloat dt, unsigned int first, unsigned int count);
+    // Swap-removes the dead particles
+    void Compact();
+    // Integrates all particles and removes the dead ones
+    void Update(GLfloat dt);
+    // Writes the instances of count particles from first on, as ParticleRenderer draws them
+    void Fill(ParticleInstance *instances, unsigned int first, unsigned int count) const;
+private:
+    std::vector<GLfloat> storage;
+};
+
+#endif
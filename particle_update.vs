@@ -0,0 +1,60 @@
+#version 330 core
+// one step of GpuParticles, written back through transform feedback. StepFeedbackParticles
+// (particle_feedback.cpp) does the same arithmetic on the CPU, keep them in sync.
+layout (location = 0) in vec4 particle; // <vec2 position, size, rotation>
+layout (location = 1) in vec4 color;
+layout (location = 2) in vec4 state;    // <vec2 velocity, life, unused>
+
+out vec4 outParticle;
+out vec4 outColor;
+out vec4 outState;
+
+// exhaust point of every emitter (RG32F), particle i belongs to emitter i / perEmitter
+uniform samplerBuffer exhausts;
+uniform int perEmitter;
+uniform uint frame;
+// ParticleForces scaled to the step as ParticleSystem::Integrate does
+uniform float dt;
+uniform float keep;
+uniform vec2 acceleration;
+uniform float grow;
+uniform float fade;
+// ParticleEmission
+uniform float lifeMin;
+uniform float lifeRange;
+uniform float speed;
+uniform float spread;
+uniform float size;
+uniform vec4 emitColor;
+
+uint hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+void main()
+{
+    if (state.z <= 0.0)
+    {
+        // dead, emit again from the exhaust
+        uint h1 = hash(uint(gl_VertexID) ^ hash(frame));
+        uint h2 = hash(h1);
+        float a = float(h1 & 0xffffu) / 65535.0;
+        float b = float(h1 >> 16) / 65535.0;
+        float c = float(h2 & 0xffffu) / 65535.0;
+        vec2 exhaust = texelFetch(exhausts, gl_VertexID / perEmitter).xy;
+        outParticle = vec4(exhaust, size, b * 6.28318);
+        outColor = emitColor;
+        outState = vec4((b - 0.5) * spread, -speed * (1.0 + c * 0.5), lifeMin + a * lifeRange, 0.0);
+        return;
+    }
+    vec2 velocity = state.xy * keep + acceleration;
+    outParticle = vec4(particle.xy + velocity * dt, particle.z + grow, particle.w);
+    outColor = vec4(color.rgb, max(color.a - fade, 0.0));
+    outState = vec4(velocity, state.z - dt, 0.0);
+}
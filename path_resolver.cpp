@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <cctype>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#include "path_resolver.h"
+
+
+static std::string lowerCase(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+    return text;
+}
+
+PathResolver::PathResolver()
+    : Scans(0)
+{
+}
+
+std::string PathResolver::Resolve(const std::string &directory, const std::string &relative)
+{
+    std::string resolved, current = directory;
+    size_t begin = 0;
+    while (begin <= relative.size())
+    {
+        size_t end = relative.find_first_of("/\\", begin);
+        if (end == std::string::npos)
+            end = relative.size();
+        std::string name = relative.substr(begin, end - begin);
+        begin = end + 1;
+        if (name.empty() || name == ".")
+            continue;
+        if (name != "..")
+        {
+            const Listing &listing = this->list(current);
+            std::map<std::string, std::string>::const_iterator folded = listing.Folded.find(lowerCase(name));
+            if (listing.Names.count(name) == 0 && folded != listing.Folded.end())
+                name = folded->second;
+        }
+        resolved += resolved.empty() ? name : "/" + name;
+        current += "/" + name;
+    }
+    return resolved;
+}
+
+const PathResolver::Listing &PathResolver::list(const std::string &directory)
+{
+    std::map<std::string, Listing>::iterator found = this->listings.find(directory);
+    if (found != this->listings.end())
+        return found->second;
+    Listing &listing = this->listings[directory];
+    this->Scans++;
+#ifdef _WIN32
+    WIN32_FIND_DATAA entry;
+    HANDLE find = FindFirstFileA((directory + "/*").c_str(), &entry);
+    if (find == INVALID_HANDLE_VALUE)
+        return listing;
+    do
+    {
+        listing.Names.insert(entry.cFileName);
+        listing.Folded.insert(std::make_pair(lowerCase(entry.cFileName), std::string(entry.cFileName)));
+    }
+    while (FindNextFileA(find, &entry));
+    FindClose(find);
+#else
+    DIR *dir = opendir(directory.c_str());
+    if (!dir)
+        return listing;
+    while (struct dirent *entry = readdir(dir))
+    {
+        // names differing only in case fold to the first one listed
+        listing.Names.insert(entry->d_name);
+        listing.Folded.insert(std::make_pair(lowerCase(entry->d_name), std::string(entry->d_name)));
+    }
+    closedir(dir);
+#endif
+    return listing;
+}
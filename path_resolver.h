@@ -0,0 +1,34 @@
+#ifndef PATH_RESOLVER_H
+#define PATH_RESOLVER_H
+
+#include <map>
+#include <set>
+#include <string>
+
+// Matches the file names of model assets to the files on disk ignoring case, the way the
+// Windows tools that wrote them saw the file system (suv.mtl says tex_0040_1.png, the file
+// is Tex_0040_1.png). Every directory is listed once and kept, so resolving all materials
+// of a model costs a single directory scan.
+class PathResolver
+{
+public:
+    unsigned int Scans; // Directories listed so far
+    // Constructor (nothing scanned)
+    PathResolver();
+    // Spelling on disk of relative (a path below directory, '/' or '\' separated), each
+    // component matched exactly if possible and case-insensitively otherwise. Components
+    // without a match are kept as written, so opening the result fails as before.
+    std::string Resolve(const std::string &directory, const std::string &relative);
+private:
+    // Entry names of a directory, and the same by their lower case spelling
+    struct Listing
+    {
+        std::set<std::string> Names;
+        std::map<std::string, std::string> Folded;
+    };
+    std::map<std::string, Listing> listings;
+    // Listing of directory, read from disk the first time
+    const Listing &list(const std::string &directory);
+};
+
+#endif
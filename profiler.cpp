@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "gl_ext.h"
+#include "profiler.h"
+
+
+Profiler::Profiler(unsigned int window) : Recording(false), Frame(0), DroppedPasses(0), epoch(std::chrono::steady_clock::now()),
+    queriesCreated(false), passOpen(false), frameStart(0.0), gpuTime(0.0), frameTimes(window > 0 ? window : 1, 0.0)
+{
+    for (unsigned int i = 0; i < PROFILER_LATENCY; ++i)
+        this->slots[i].Count = 0;
+}
+
+void Profiler::BeginFrame()
+{
+    if (!this->queriesCreated)
+    {
+        for (unsigned int i = 0; i < PROFILER_LATENCY; ++i)
+            glGenQueries(PROFILER_MAX_PASSES, this->slots[i].Queries);
+        this->queriesCreated = true;
+    }
+    PassSlot &slot = this->slots[this->Frame % PROFILER_LATENCY];
+    this->collect(slot);
+    slot.Frame = this->Frame;
+    slot.Count = 0;
+    this->frameStart = this->now();
+}
+
+void Profiler::EndFrame()
+{
+    double end = this->now();
+    this->frameTimes[this->Frame % this->frameTimes.size()] = end - this->frameStart;
+    if (this->Recording)
+    {
+        ProfileEvent event = { "frame", this->Frame, this->frameStart, end - this->frameStart, false };
+        this->events.push_back(event);
+    }
+    this->Frame++;
+}
+
+void Profiler::Flush()
+{
+    // oldest frame first, so the events stay in frame order
+    for (unsigned int i = 0; i < PROFILER_LATENCY; ++i)
+    {
+        PassSlot &slot = this->slots[(this->Frame + i) % PROFILER_LATENCY];
+        this->collect(slot, true);
+        slot.Count = 0;
+    }
+}
+
+void Profiler::BeginScope(const char *name)
+{
+    Scope scope = { name, this->now() };
+    this->scopes.push_back(scope);
+}
+
+void Profiler::EndScope()
+{
+    if (this->scopes.empty())
+        return;
+    const Scope &scope = this->scopes.back();
+    if (this->Recording)
+    {
+        ProfileEvent event = { scope.Name, this->Frame, scope.Start, this->now() - scope.Start, false };
+        this->events.push_back(event);
+    }
+    this->scopes.pop_back();
+}
+
+void Profiler::BeginPass(const char *name)
+{
+    PassSlot &slot = this->slots[this->Frame % PROFILER_LATENCY];
+    if (this->passOpen || slot.Count == PROFILER_MAX_PASSES)
+    {
+        this->DroppedPasses++;
+        return;
+    }
+    slot.Names[slot.Count] = name;
+    slot.Starts[slot.Count] = this->now();
+    glBeginQuery(GL_TIME_ELAPSED, slot.Queries[slot.Count]);
+    this->passOpen = true;
+}
+
+void Profiler::EndPass()
+{
+    if (!this->passOpen)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    this->slots[this->Frame % PROFILER_LATENCY].Count++;
+    this->passOpen = false;
+}
+
+double Profiler::FramePercentile(float percentile) const
+{
+    size_t count = std::min((size_t)this->Frame, this->frameTimes.size());
+    if (count == 0)
+        return 0.0;
+    std::vector<double> times(this->frameTimes.begin(), this->frameTimes.begin() + count);
+    size_t rank = std::min((size_t)(percentile / 100.0f * count), count - 1);
+    std::nth_element(times.begin(), times.begin() + rank, times.end());
+    return times[rank];
+}
+
+double Profiler::FrameAverage() const
+{
+    size_t count = std::min((size_t)this->Frame, this->frameTimes.size());
+    double total = 0.0;
+    for (size_t i = 0; i < count; ++i)
+        total += this->frameTimes[i];
+    return count ? total / count : 0.0;
+}
+
+bool Profiler::WriteCsv(const std::string &path) const
+{
+    std::ofstream file(path.c_str());
+    if (!file)
+    {
+        std::cout << "ERROR::PROFILER: could not write " << path << std::endl;
+        return false;
+    }
+    file << "frame,track,name,start_ms,duration_ms\n";
+    for (size_t i = 0; i < this->events.size(); ++i)
+    {
+        const ProfileEvent &event = this->events[i];
+        file << event.Frame << ',' << (event.Gpu ? "gpu" : "cpu") << ',' << event.Name << ',' << event.Start << ',' << event.Duration << '\n';
+    }
+    return file.good();
+}
+
+bool Profiler::WriteChromeTrace(const std::string &path) const
+{
+    std::ofstream file(path.c_str());
+    if (!file)
+    {
+        std::cout << "ERROR::PROFILER: could not write " << path << std::endl;
+        return false;
+    }
+    // complete ("X") events in microseconds, CPU scopes on thread 1 and GPU passes on thread 2
+    file << "{\"traceEvents\":[\n"
+        << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n"
+        << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+    file.precision(3);
+    file << std::fixed;
+    for (size_t i = 0; i < this->events.size(); ++i)
+    {
+        const ProfileEvent &event = this->events[i];
+        file << ",\n{\"name\":\"" << event.Name << "\",\"cat\":\"" << (event.Gpu ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+            << (event.Gpu ? 2 : 1) << ",\"ts\":" << event.Start * 1000.0 << ",\"dur\":" << event.Duration * 1000.0
+            << ",\"args\":{\"frame\":" << event.Frame << "}}";
+    }
+    file << "\n]}\n";
+    return file.good();
+}
+
+double Profiler::now() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - this->epoch).count();
+}
+
+void Profiler::collect(PassSlot &slot, bool wait)
+{
+    if (slot.Count == 0)
+        return;
+    double gpuTime = 0.0, gpuEnd = 0.0;
+    for (unsigned int i = 0; i < slot.Count; ++i)
+    {
+        // GL_QUERY_RESULT blocks until the result is there
+        GLuint available = wait;
+        if (!wait)
+            glGetQueryObjectuiv(slot.Queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            this->DroppedPasses++;
+            continue;
+        }
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(slot.Queries[i], GL_QUERY_RESULT, &nanoseconds);
+        double duration = nanoseconds / 1e6;
+        gpuTime += duration;
+        if (this->Recording)
+        {
+            ProfileEvent event = { slot.Names[i], slot.Frame, std::max(slot.Starts[i], gpuEnd), duration, true };
+            gpuEnd = event.Start + duration;
+            this->events.push_back(event);
+        }
+    }
+    this->gpuTime = gpuTime;
+}
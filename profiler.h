@@ -0,0 +1,97 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Frames GPU timings are read back late, so their queries are done and reading never stalls
+const unsigned int PROFILER_LATENCY = 4;
+// GPU passes timed per frame
+const unsigned int PROFILER_MAX_PASSES = 8;
+// Frames the frame time percentiles are taken over by default
+const unsigned int PROFILER_WINDOW = 240;
+
+// A timed CPU scope or GPU pass
+struct ProfileEvent
+{
+    const char *Name;   // String literal, not copied
+    unsigned int Frame;
+    double Start;       // Milliseconds since the profiler was created. GPU passes only have a
+    double Duration;    // duration, they are placed where they were submitted (or after the previous one)
+    bool Gpu;
+};
+
+// Profiler times nested CPU scopes with a steady clock and GPU passes with GL_TIME_ELAPSED
+// queries. Queries cycle through PROFILER_LATENCY frames and are read back when their slot
+// comes round again, results that still aren't available then are dropped instead of waited
+// for; Flush waits for the last frames' ones. Frame times feed a rolling window for percentiles, all events can be kept and written
+// out as CSV or as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+class Profiler
+{
+public:
+    bool Recording;          // Keep every event for WriteCsv/WriteChromeTrace
+    unsigned int Frame;      // Frames ended so far
+    unsigned int DroppedPasses; // GPU passes not timed: queries not done in time or too many passes
+    // Constructor, frame time percentiles over the last window frames. GL queries are created by the first BeginFrame.
+    Profiler(unsigned int window = PROFILER_WINDOW);
+    // Starts a frame, collects the GPU timings of the frame PROFILER_LATENCY frames back
+    void BeginFrame();
+    void EndFrame();
+    // Waits for and collects the GPU timings of the frames not read back yet, call before writing the events out
+    void Flush();
+    // Times a CPU scope, scopes nest
+    void BeginScope(const char *name);
+    void EndScope();
+    // Times a GPU pass, passes don't nest
+    void BeginPass(const char *name);
+    void EndPass();
+    // Frame time (milliseconds) at percentile (0-100) and average over the window
+    double FramePercentile(float percentile) const;
+    double FrameAverage() const;
+    // Summed GPU pass time (milliseconds) of the latest frame read back
+    double GpuTime() const { return this->gpuTime; }
+    // Writes all recorded events, one per line: frame,track,name,start_ms,duration_ms
+    bool WriteCsv(const std::string &path) const;
+    // Writes all recorded events in the Chrome trace event format (JSON)
+    bool WriteChromeTrace(const std::string &path) const;
+private:
+    struct Scope
+    {
+        const char *Name;
+        double Start;
+    };
+    struct PassSlot
+    {
+        unsigned int Frame;
+        unsigned int Count;
+        GLuint Queries[PROFILER_MAX_PASSES];
+        const char *Names[PROFILER_MAX_PASSES];
+        double Starts[PROFILER_MAX_PASSES];
+    };
+    std::chrono::steady_clock::time_point epoch;
+    std::vector<ProfileEvent> events;
+    std::vector<Scope> scopes;
+    PassSlot slots[PROFILER_LATENCY];
+    bool queriesCreated, passOpen;
+    double frameStart, gpuTime;
+    std::vector<double> frameTimes;
+    double now() const;
+    void collect(PassSlot &slot, bool wait = false);
+    Profiler(const Profiler &);
+    Profiler &operator=(const Profiler &);
+};
+
+// Times the enclosing block as a CPU scope of profiler
+class ProfileScope
+{
+public:
+    ProfileScope(Profiler &profiler, const char *name) : profiler(profiler) { profiler.BeginScope(name); }
+    ~ProfileScope() { this->profiler.EndScope(); }
+private:
+    Profiler &profiler;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#include <cstring>
+
+#include "radix_sort.h"
+
+
+void RadixSort(SortEntry *entries, SortEntry *scratch, size_t count)
+{
+    size_t histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+    for (size_t i = 0; i < count; ++i)
+        for (unsigned int digit = 0; digit < 8; ++digit)
+            histograms[digit][(entries[i].Key >> (digit * 8)) & 0xFF]++;
+    SortEntry *source = entries, *target = scratch;
+    for (unsigned int digit = 0; digit < 8; ++digit)
+    {
+        size_t *histogram = histograms[digit];
+        // all keys share this byte: the pass would not move anything
+        if (count == 0 || histogram[(source[0].Key >> (digit * 8)) & 0xFF] == count)
+            continue;
+        size_t offset = 0;
+        for (unsigned int bucket = 0; bucket < 256; ++bucket)
+        {
+            size_t size = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += size;
+        }
+        for (size_t i = 0; i < count; ++i)
+            target[histogram[(source[i].Key >> (digit * 8)) & 0xFF]++] = source[i];
+        SortEntry *swap = source;
+        source = target;
+        target = swap;
+    }
+    if (source != entries)
+        memcpy(entries, source, count * sizeof(SortEntry));
+}
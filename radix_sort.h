@@ -0,0 +1,19 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <cstddef>
+#include <stdint.h>
+
+// A sort key and the item it belongs to
+struct SortEntry
+{
+    uint64_t Key;
+    uint32_t Item;
+};
+
+// Sorts entries by Key, keeping the order of equal keys: least significant digit first radix
+// sort over the 8 bytes of the key, with the histograms of all bytes gathered in one pass and
+// bytes every key shares skipped. scratch must hold count entries.
+void RadixSort(SortEntry *entries, SortEntry *scratch, size_t count);
+
+#endif
@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+
+#include "gl_ext.h"
+#include "rain.h"
+#include "stb_image.h"
+
+#ifdef __SSE2__
+#include <xmmintrin.h>
+#endif
+
+
+RainSystem::RainSystem()
+    : VAO(0), QuadVBO(0), InstanceVBO(0), Texture(0), Capacity(0), Count(0), Extent(1.0f), Density(0.0f), SpeedMin(8.0f), SpeedRange(4.0f),
+      Wind(0.5f, 0.0f, 0.2f), StreakTime(1.0f / 30.0f), Width(0.01f), Color(0.7f, 0.75f, 0.8f, 0.6f), Persistent(false),
+      positionX(NULL), positionY(NULL), positionZ(NULL), speed(NULL), mapped(NULL), frame(0), written(0),
+      windLocation(-1), streakTimeLocation(-1), widthLocation(-1), extentLocation(-1), colorLocation(-1)
+{
+    for (unsigned int i = 0; i < UNIFORM_RING_FRAMES; ++i)
+        this->fences[i] = 0;
+}
+
+bool RainSystem::Generate(GLuint program, GLuint capacity, GLfloat extent, const std::string &texturePath)
+{
+    int width, height, components;
+    unsigned char *data = stbi_load(texturePath.c_str(), &width, &height, &components, 2);
+    if (!data)
+    {
+        std::cout << "ERROR::RAIN: Failed to load " << texturePath << std::endl;
+        return false;
+    }
+    // gray + alpha as two channels, swizzled back into a white drop with alpha
+    glGenTextures(1, &this->Texture);
+    glBindTexture(GL_TEXTURE_2D, this->Texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, width, height, 0, GL_RG, GL_UNSIGNED_BYTE, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_GREEN };
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    stbi_image_free(data);
+
+    this->Capacity = capacity;
+    this->Extent = extent;
+    this->windLocation = glGetUniformLocation(program, "wind");
+    this->streakTimeLocation = glGetUniformLocation(program, "streakTime");
+    this->widthLocation = glGetUniformLocation(program, "width");
+    this->extentLocation = glGetUniformLocation(program, "extent");
+    this->colorLocation = glGetUniformLocation(program, "color");
+    // drops scattered evenly over the cube, Density picks how many of them fall
+    this->storage.resize((size_t)capacity * 4);
+    this->positionX = &this->storage[0];
+    this->positionY = this->positionX + capacity;
+    this->positionZ = this->positionY + capacity;
+    this->speed = this->positionZ + capacity;
+    unsigned int seed = 12345;
+    for (GLuint i = 0; i < capacity; ++i)
+    {
+        GLfloat *streams[] = { this->positionX, this->positionY, this->positionZ, this->speed };
+        for (unsigned int s = 0; s < 4; ++s)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            GLfloat random = (GLfloat)(seed >> 8) / 16777216.0f;
+            streams[s][i] = s < 3 ? random * extent : this->SpeedMin + random * this->SpeedRange;
+        }
+    }
+    this->SetDensity(this->Density);
+
+    // a streak: across from -0.5 to 0.5, along from the drop (0) back to where it was StreakTime ago (1)
+    GLfloat quad[] = {
+        -0.5f, 0.0f,
+         0.5f, 0.0f,
+         0.5f, 1.0f,
+
+        -0.5f, 0.0f,
+         0.5f, 1.0f,
+        -0.5f, 1.0f
+    };
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &this->QuadVBO);
+    glGenBuffers(1, &this->InstanceVBO);
+    glBindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->QuadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void*)0);
+    glBindVertexArray(0);
+
+    GLsizeiptr size = (GLsizeiptr)capacity * sizeof(RainInstance);
+    glBindBuffer(GL_ARRAY_BUFFER, this->InstanceVBO);
+    this->Persistent = glBufferStorage != NULL;
+    if (this->Persistent)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, size * UNIFORM_RING_FRAMES, NULL, flags);
+        this->mapped = (RainInstance*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size * UNIFORM_RING_FRAMES, flags);
+        if (!this->mapped)
+        {
+            std::cout << "ERROR::RAIN: persistent mapping failed, uploading instances instead" << std::endl;
+            // buffer storage is immutable, start over with a plain buffer
+            glDeleteBuffers(1, &this->InstanceVBO);
+            glGenBuffers(1, &this->InstanceVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, this->InstanceVBO);
+            this->Persistent = false;
+        }
+    }
+    if (!this->Persistent)
+    {
+        // a single frame of storage, orphaned by every Draw
+        glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+        this->staging.resize(capacity);
+    }
+    // per-instance attribute, pointed at this frame's instances by Draw
+    glBindVertexArray(this->VAO);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(RainInstance), (void*)offsetof(RainInstance, Drop));
+    glVertexAttribDivisor(1, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void RainSystem::SetDensity(GLfloat density)
+{
+    this->Density = density;
+    double drops = (double)density * this->Extent * this->Extent * this->Extent;
+    this->Count = (GLuint)std::min(std::max(drops, 0.0), (double)this->Capacity);
+}
+
+void RainSystem::BeginFrame()
+{
+    GLsync &fence = this->fences[this->frame];
+    if (fence)
+    {
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        while (result == GL_TIMEOUT_EXPIRED)
+            result = glClientWaitSync(fence, 0, 1000000000);
+        glDeleteSync(fence);
+        fence = 0;
+    }
+    this->written = 0;
+}
+
+// Position modulo extent, in [0, extent)
+static GLfloat wrap(GLfloat position, GLfloat extent)
+{
+    GLfloat wrapped = position - extent * std::floor(position / extent);
+    return wrapped < extent ? wrapped : 0.0f;
+}
+
+void RainSystem::Update(GLfloat dt, const glm::vec3 &cameraPosition)
+{
+    GLfloat extent = this->Extent;
+    GLfloat fastest = std::max(std::fabs(this->Wind.x), std::max(std::fabs(this->Wind.z), std::fabs(this->Wind.y) + this->SpeedMin + this->SpeedRange));
+    if (fastest > 0.0f)
+        dt = std::min(dt, 0.5f * extent / fastest);
+    // the corner of the cube centered on the camera, and where it falls in volume coordinates
+    glm::vec3 origin = cameraPosition - glm::vec3(0.5f * extent);
+    GLfloat shiftX = wrap(origin.x, extent), shiftY = wrap(origin.y, extent), shiftZ = wrap(origin.z, extent);
+    GLfloat moveX = this->Wind.x * dt, moveY = this->Wind.y * dt, moveZ = this->Wind.z * dt;
+    RainInstance *instances = this->Persistent ? this->mapped + (size_t)this->frame * this->Capacity : &this->staging[0];
+    // every move is less than an extent, so one add or subtract brings a drop back into the cube
+    GLuint i = 0;
+#ifdef __SSE2__
+    // four drops at a time, the same operations in the same order as the loop below
+    const __m128 extents = _mm_set1_ps(extent), zero = _mm_setzero_ps(), dts = _mm_set1_ps(dt);
+    const __m128 moveXs = _mm_set1_ps(moveX), moveYs = _mm_set1_ps(moveY), moveZs = _mm_set1_ps(moveZ);
+    const __m128 shiftXs = _mm_set1_ps(shiftX), shiftYs = _mm_set1_ps(shiftY), shiftZs = _mm_set1_ps(shiftZ);
+    const __m128 originXs = _mm_set1_ps(origin.x), originYs = _mm_set1_ps(origin.y), originZs = _mm_set1_ps(origin.z);
+    for (; i + 4 <= this->Count; i += 4)
+    {
+        __m128 speeds = _mm_loadu_ps(this->speed + i);
+        __m128 x = _mm_add_ps(_mm_loadu_ps(this->positionX + i), moveXs);
+        __m128 y = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(this->positionY + i), moveYs), _mm_mul_ps(speeds, dts));
+        __m128 z = _mm_add_ps(_mm_loadu_ps(this->positionZ + i), moveZs);
+        x = _mm_add_ps(x, _mm_and_ps(_mm_cmplt_ps(x, zero), extents));
+        x = _mm_sub_ps(x, _mm_and_ps(_mm_cmpge_ps(x, extents), extents));
+        y = _mm_add_ps(y, _mm_and_ps(_mm_cmplt_ps(y, zero), extents));
+        y = _mm_sub_ps(y, _mm_and_ps(_mm_cmpge_ps(y, extents), extents));
+        z = _mm_add_ps(z, _mm_and_ps(_mm_cmplt_ps(z, zero), extents));
+        z = _mm_sub_ps(z, _mm_and_ps(_mm_cmpge_ps(z, extents), extents));
+        _mm_storeu_ps(this->positionX + i, x);
+        _mm_storeu_ps(this->positionY + i, y);
+        _mm_storeu_ps(this->positionZ + i, z);
+        x = _mm_sub_ps(x, shiftXs);
+        y = _mm_sub_ps(y, shiftYs);
+        z = _mm_sub_ps(z, shiftZs);
+        x = _mm_add_ps(originXs, _mm_add_ps(x, _mm_and_ps(_mm_cmplt_ps(x, zero), extents)));
+        y = _mm_add_ps(originYs, _mm_add_ps(y, _mm_and_ps(_mm_cmplt_ps(y, zero), extents)));
+        z = _mm_add_ps(originZs, _mm_add_ps(z, _mm_and_ps(_mm_cmplt_ps(z, zero), extents)));
+        // streams to instances
+        _MM_TRANSPOSE4_PS(x, y, z, speeds);
+        _mm_storeu_ps(&instances[i].Drop[0], x);
+        _mm_storeu_ps(&instances[i + 1].Drop[0], y);
+        _mm_storeu_ps(&instances[i + 2].Drop[0], z);
+        _mm_storeu_ps(&instances[i + 3].Drop[0], speeds);
+    }
+#endif
+    for (; i < this->Count; ++i)
+    {
+        GLfloat x = this->positionX[i] + moveX, y = this->positionY[i] + moveY - this->speed[i] * dt, z = this->positionZ[i] + moveZ;
+        x += x < 0.0f ? extent : 0.0f;
+        x -= x >= extent ? extent : 0.0f;
+        y += y < 0.0f ? extent : 0.0f;
+        y -= y >= extent ? extent : 0.0f;
+        z += z < 0.0f ? extent : 0.0f;
+        z -= z >= extent ? extent : 0.0f;
+        this->positionX[i] = x;
+        this->positionY[i] = y;
+        this->positionZ[i] = z;
+        // the drop's copy in the cube around the camera
+        GLfloat relativeX = x - shiftX, relativeY = y - shiftY, relativeZ = z - shiftZ;
+        relativeX += relativeX < 0.0f ? extent : 0.0f;
+        relativeY += relativeY < 0.0f ? extent : 0.0f;
+        relativeZ += relativeZ < 0.0f ? extent : 0.0f;
+        instances[i].Drop = glm::vec4(origin.x + relativeX, origin.y + relativeY, origin.z + relativeZ, this->speed[i]);
+    }
+    this->written = this->Count;
+}
+
+void RainSystem::Draw()
+{
+    if (this->written == 0)
+        return;
+    size_t first = 0;
+    glBindBuffer(GL_ARRAY_BUFFER, this->InstanceVBO);
+    if (this->Persistent)
+        first = (size_t)this->frame * this->Capacity;
+    else
+    {
+        // fresh storage, the previous frame's may still be read
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)this->Capacity * sizeof(RainInstance), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)this->written * sizeof(RainInstance), &this->staging[0]);
+    }
+    glBindVertexArray(this->VAO);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(RainInstance), (void*)(first * sizeof(RainInstance) + offsetof(RainInstance, Drop)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUniform3fv(this->windLocation, 1, &this->Wind[0]);
+    glUniform1f(this->streakTimeLocation, this->StreakTime);
+    glUniform1f(this->widthLocation, this->Width);
+    glUniform1f(this->extentLocation, this->Extent);
+    glUniform4fv(this->colorLocation, 1, &this->Color[0]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, this->Texture);
+    GLboolean blend = glIsEnabled(GL_BLEND), depthWrites;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &depthWrites);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)this->written);
+    glDepthMask(depthWrites);
+    if (!blend)
+        glDisable(GL_BLEND);
+    glBindVertexArray(0);
+}
+
+void RainSystem::EndFrame()
+{
+    this->fences[this->frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    this->frame = (this->frame + 1) % UNIFORM_RING_FRAMES;
+}
@@ -0,0 +1,13 @@
+#version 330 core
+in vec2 TexCoords;
+in float Fade;
+out vec4 FragColor;
+
+uniform sampler2D drop;
+uniform vec4 color;
+
+void main()
+{
+    FragColor = texture(drop, TexCoords) * color;
+    FragColor.a *= Fade;
+}
@@ -0,0 +1,72 @@
+#ifndef RAIN_H
+#define RAIN_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+#include "uniform_buffer.h"
+
+// Per-instance attributes of a drop read by rain.vs
+struct RainInstance
+{
+    glm::vec4 Drop; // World position xyz, fall speed
+};
+
+// Rain simulated only in a cube of Extent around the camera, so its cost depends on the
+// density and not on the size of the world. Drops live in volume coordinates that wrap at
+// Extent (the world tiled with copies of the cube), a drop falling out of the bottom comes
+// back in at the top. Every frame each drop is placed in the copy of the tile around the
+// camera, so drops stay put in the world while the camera moves and the ones it leaves behind
+// reappear ahead of it. rain.vs stretches a quad per drop along its velocity, facing the
+// camera, and fades drops out near the faces of the cube, all of them drawn with one
+// glDrawArraysInstanced. Instances stream through a ring of UNIFORM_RING_FRAMES frames as in
+// ParticleRenderer: mapped once with GL 4.4 / ARB_buffer_storage, uploaded into orphaned
+// storage otherwise.
+class RainSystem
+{
+public:
+    GLuint VAO, QuadVBO, InstanceVBO;
+    GLuint Texture;             // Drop sprite, gray + alpha
+    GLuint Capacity;            // Drops generated, the most Density can ask for
+    GLuint Count;               // Drops simulated and drawn
+    GLfloat Extent;             // Edge of the cube around the camera (world units)
+    GLfloat Density;            // Drops per cubic world unit
+    GLfloat SpeedMin, SpeedRange; // Fall speed of the drops (world units per second), set before Generate
+    glm::vec3 Wind;             // Added to every drop's velocity
+    GLfloat StreakTime;         // Seconds of motion a drop's streak covers
+    GLfloat Width;              // Streak width (world units)
+    glm::vec4 Color;            // Multiplies the sprite
+    bool Persistent;            // Mapped once instead of uploaded per frame
+    // Constructor (objects created by Generate)
+    RainSystem();
+    // Scatters capacity drops over a cube of extent, loads the drop sprite from texturePath and
+    // creates the quad and instance ring drawn with program (rain.vs), false if the sprite fails to load
+    bool Generate(GLuint program, GLuint capacity, GLfloat extent, const std::string &texturePath);
+    // Simulates density drops per cubic world unit, as many as Capacity allows
+    void SetDensity(GLfloat density);
+    // Starts the next frame, waits until the GPU is done with its instances
+    void BeginFrame();
+    // Moves the drops over dt seconds and writes their instances around cameraPosition. dt is
+    // clamped so no drop moves more than half the cube, long frames slow the rain down instead.
+    void Update(GLfloat dt, const glm::vec3 &cameraPosition);
+    // Draws the drops with one instanced draw, program in use. Blends them over the scene
+    // without writing depth, blending and depth writes are left as they were found.
+    void Draw();
+    // Ends the frame, fencing its instances
+    void EndFrame();
+private:
+    std::vector<GLfloat> storage;               // The streams below, back to back
+    GLfloat *positionX, *positionY, *positionZ; // Volume coordinates, [0, Extent)
+    GLfloat *speed;
+    RainInstance *mapped;
+    std::vector<RainInstance> staging;          // Instances of the frame without a persistent mapping
+    GLsync fences[UNIFORM_RING_FRAMES];
+    unsigned int frame;
+    GLuint written;                             // Instances written by Update this frame
+    GLint windLocation, streakTimeLocation, widthLocation, extentLocation, colorLocation;
+};
+
+#endif
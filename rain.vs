@@ -0,0 +1,39 @@
+#version 330 core
+layout (location = 0) in vec2 vertex; // <across, along> a streak, along from the drop (0) to its tail (1)
+// per-instance attribute streamed by RainSystem
+layout (location = 1) in vec4 instanceDrop; // <vec3 position, fall speed>
+
+out vec2 TexCoords;
+out float Fade;
+
+// camera and light, shared by all shaders (uniform_buffer.h)
+layout (std140) uniform Frame
+{
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    vec4 lightPos;
+    vec4 lightColor;
+};
+
+uniform vec3 wind;
+uniform float streakTime; // seconds of motion a streak covers
+uniform float width;
+uniform float extent;     // edge of the cube of drops around the camera
+
+void main()
+{
+    vec3 drop = instanceDrop.xyz;
+    vec3 velocity = vec3(wind.x, wind.y - instanceDrop.w, wind.z);
+    // stretched back along the velocity, widened across it facing the camera
+    vec3 side = cross(velocity, drop - viewPos.xyz);
+    float sideLength = length(side);
+    side = sideLength > 0.0 ? side / sideLength : vec3(1.0, 0.0, 0.0);
+    vec3 position = drop - velocity * (streakTime * vertex.y) + side * (width * vertex.x);
+    // the sprite's round end leads
+    TexCoords = vec2(vertex.x + 0.5, 1.0 - vertex.y);
+    // drops wrapping around the cube fade in and out instead of popping
+    vec3 distance = abs(drop - viewPos.xyz) / (0.5 * extent);
+    Fade = 1.0 - smoothstep(0.7, 1.0, max(distance.x, max(distance.y, distance.z)));
+    gl_Position = projection * view * vec4(position, 1.0);
+}
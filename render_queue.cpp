@@ -0,0 +1,137 @@
+#include <cstring>
+
+#include "render_queue.h"
+
+
+// Lowest bits of value as a key field
+static uint64_t keyField(uint64_t value, unsigned int bits)
+{
+    return value & ((1ULL << bits) - 1);
+}
+
+uint64_t RenderKey(GLuint program, GLuint texture, GLuint vertexArray, float depth)
+{
+    depth = depth < 0.0f ? 0.0f : depth > 1.0f ? 1.0f : depth;
+    uint64_t quantized = (uint64_t)(depth * (float)((1 << RENDER_KEY_DEPTH_BITS) - 1));
+    uint64_t key = keyField(program, RENDER_KEY_PROGRAM_BITS);
+    key = (key << RENDER_KEY_TEXTURE_BITS) | keyField(texture, RENDER_KEY_TEXTURE_BITS);
+    key = (key << RENDER_KEY_VERTEX_ARRAY_BITS) | keyField(vertexArray, RENDER_KEY_VERTEX_ARRAY_BITS);
+    return (key << RENDER_KEY_DEPTH_BITS) | quantized;
+}
+
+RenderQueue::RenderQueue()
+    : Program(0), Sorted(true), cameraPosition(0.0f), farPlane(1.0f)
+{
+    this->ResetStats();
+}
+
+void RenderQueue::Begin(const glm::vec3 &cameraPosition, float farPlane)
+{
+    this->cameraPosition = cameraPosition;
+    this->farPlane = farPlane;
+    this->items.clear();
+    this->entries.clear();
+    this->counts.clear();
+    this->offsets.clear();
+}
+
+void RenderQueue::Add(GLuint texture, GLuint vertexArray, GLintptr uniforms, GLenum indexType, const GLsizei *counts, const void *const *offsets,
+    unsigned int rangeCount, const glm::vec3 &center, GLsizei instances, GLint baseVertex)
+{
+    RenderItem item;
+    item.Program = this->Program;
+    item.Texture = texture;
+    item.VertexArray = vertexArray;
+    item.Uniforms = uniforms;
+    item.IndexType = indexType;
+    item.FirstRange = (unsigned int)this->counts.size();
+    item.RangeCount = rangeCount;
+    item.Instances = instances;
+    item.BaseVertex = baseVertex;
+    this->counts.insert(this->counts.end(), counts, counts + rangeCount);
+    this->offsets.insert(this->offsets.end(), offsets, offsets + rangeCount);
+    SortEntry entry;
+    entry.Key = RenderKey(item.Program, texture, vertexArray, glm::length(center - this->cameraPosition) / this->farPlane);
+    entry.Item = (uint32_t)this->items.size();
+    this->entries.push_back(entry);
+    this->items.push_back(item);
+}
+
+void RenderQueue::Submit(UniformRing &draws)
+{
+    if (this->items.empty())
+        return;
+    if (this->Sorted)
+    {
+        this->scratch.resize(this->entries.size());
+        RadixSort(&this->entries[0], &this->scratch[0], this->entries.size());
+    }
+    // nothing is known to be bound before the first draw
+    GLuint program = 0, texture = 0, vertexArray = 0;
+    bool first = true;
+    glActiveTexture(GL_TEXTURE0);
+    for (unsigned int i = 0; i < this->entries.size(); ++i)
+    {
+        const RenderItem &item = this->items[this->entries[i].Item];
+        if (first || item.Program != program)
+        {
+            glUseProgram(item.Program);
+            this->Stats.ProgramBinds++;
+        }
+        else
+            this->Stats.BindsAvoided++;
+        if (first || item.Texture != texture)
+        {
+            glBindTexture(GL_TEXTURE_2D, item.Texture);
+            this->Stats.TextureBinds++;
+        }
+        else
+            this->Stats.BindsAvoided++;
+        if (first || item.VertexArray != vertexArray)
+        {
+            glBindVertexArray(item.VertexArray);
+            this->Stats.VertexArrayBinds++;
+        }
+        else
+            this->Stats.BindsAvoided++;
+        program = item.Program;
+        texture = item.Texture;
+        vertexArray = item.VertexArray;
+        first = false;
+
+        draws.BindBlock(item.Uniforms);
+        const GLsizei *counts = &this->counts[item.FirstRange];
+        const void *const *offsets = &this->offsets[item.FirstRange];
+        if (item.BaseVertex != 0)
+        {
+            if (item.Instances > 0)
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, counts[0], item.IndexType, offsets[0], item.Instances, item.BaseVertex);
+            else if (item.RangeCount == 1)
+                glDrawElementsBaseVertex(GL_TRIANGLES, counts[0], item.IndexType, offsets[0], item.BaseVertex);
+            else
+            {
+                this->baseVertices.assign(item.RangeCount, item.BaseVertex);
+                glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts, item.IndexType, offsets, (GLsizei)item.RangeCount, &this->baseVertices[0]);
+            }
+        }
+        else if (item.Instances > 0)
+            glDrawElementsInstanced(GL_TRIANGLES, counts[0], item.IndexType, offsets[0], item.Instances);
+        else if (item.RangeCount == 1)
+            glDrawElements(GL_TRIANGLES, counts[0], item.IndexType, offsets[0]);
+        else
+            glMultiDrawElements(GL_TRIANGLES, counts, item.IndexType, offsets, (GLsizei)item.RangeCount);
+        this->Stats.Draws++;
+    }
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+unsigned int RenderQueue::Size() const
+{
+    return (unsigned int)this->items.size();
+}
+
+void RenderQueue::ResetStats()
+{
+    memset(&this->Stats, 0, sizeof(this->Stats));
+}
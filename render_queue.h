@@ -0,0 +1,76 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+#include "radix_sort.h"
+#include "uniform_buffer.h"
+
+// Bits of the fields of a render key, most significant first. GL names wider than their
+// field only share a key range with others, the items keep the full names.
+const unsigned int RENDER_KEY_PROGRAM_BITS = 8;
+const unsigned int RENDER_KEY_TEXTURE_BITS = 16;
+const unsigned int RENDER_KEY_VERTEX_ARRAY_BITS = 16;
+const unsigned int RENDER_KEY_DEPTH_BITS = 24;
+
+// Sort key of a draw: program, texture (all there is to a material here), vertex array, then
+// depth (0 to 1, nearest first) so draws sharing all state go front to back
+uint64_t RenderKey(GLuint program, GLuint texture, GLuint vertexArray, float depth);
+
+// A draw recorded by RenderQueue
+struct RenderItem
+{
+    GLuint Program, Texture, VertexArray;
+    GLintptr Uniforms;                   // Offset of its Draw block in the UniformRing
+    GLenum IndexType;
+    unsigned int FirstRange, RangeCount; // Index ranges in the queue's lists, drawn with one glMultiDrawElements
+    GLsizei Instances;                   // glDrawElementsInstanced of the first range if not 0
+    GLint BaseVertex;                    // Added to the indices (geometry pools), the *BaseVertex draws if not 0
+};
+
+// State changes RenderQueue::Submit made and skipped, since construction or ResetStats
+struct RenderQueueStats
+{
+    unsigned int Draws;
+    unsigned int ProgramBinds, TextureBinds, VertexArrayBinds;
+    unsigned int BindsAvoided; // Program, texture and vertex array binds the previous draw made unnecessary
+};
+
+// Collects the draws of a frame, sorts them by RenderKey with a radix sort and issues them,
+// binding program, texture and vertex array only when they differ from the previous draw.
+// The Draw blocks are written to the UniformRing as draws are added, Submit binds them.
+class RenderQueue
+{
+public:
+    GLuint Program; // Program of the draws added from now on
+    bool Sorted;    // Sort before submitting (the default), or submit in the order added
+    RenderQueueStats Stats;
+    // Constructor (empty queue)
+    RenderQueue();
+    // Starts a new list of draws, depth keys are the distance from cameraPosition divided by farPlane
+    void Begin(const glm::vec3 &cameraPosition, float farPlane);
+    // Records a draw of rangeCount index ranges (counts[i] indices at offsets[i]) of vertexArray,
+    // sampling texture with the Draw block written at uniforms. center (world space) sets its depth.
+    void Add(GLuint texture, GLuint vertexArray, GLintptr uniforms, GLenum indexType, const GLsizei *counts, const void *const *offsets,
+        unsigned int rangeCount, const glm::vec3 &center, GLsizei instances = 0, GLint baseVertex = 0);
+    // Sorts and issues the draws added since Begin
+    void Submit(UniformRing &draws);
+    // Draws added since Begin
+    unsigned int Size() const;
+    // Zeroes Stats
+    void ResetStats();
+private:
+    std::vector<RenderItem> items;
+    std::vector<SortEntry> entries, scratch;
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    std::vector<GLint> baseVertices; // Of the ranges of a glMultiDrawElementsBaseVertex
+    glm::vec3 cameraPosition;
+    float farPlane;
+};
+
+#endif
@@ -1,17 +1,25 @@
 #version 330 core
-layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
+layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>, a quad centered on the origin
+// per-instance attributes streamed by ParticleRenderer
+layout (location = 1) in vec4 instanceParticle; // <vec2 offset, size, rotation>
+layout (location = 2) in vec4 instanceColor;
 
 out vec2 TexCoords;
 out vec4 ParticleColor;
 
 uniform mat4 projection;
-uniform vec2 offset;
+uniform bool instanced;
+// the particle of a draw without instancing, same layout as the attributes
+uniform vec4 particle;
 uniform vec4 color;
 
 void main()
 {
-    float scale = 10.0f;
+    vec4 p = instanced ? instanceParticle : particle;
+    float s = sin(p.w);
+    float c = cos(p.w);
+    vec2 position = mat2(c, s, -s, c) * vertex.xy * p.z;
     TexCoords = vertex.zw;
-    ParticleColor = color;
-    gl_Position = projection * vec4((vertex.xy * scale) + offset, 0.0, 1.0);
-}
\ No newline at end of file
+    ParticleColor = instanced ? instanceColor : color;
+    gl_Position = projection * vec4(position + p.xy, 0.0, 1.0);
+}
@@ -0,0 +1,592 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "gl_ext.h"
+#include "instance_culler.h"
+#include "static_model.h"
+
+
+// materialImages entry of untextured materials
+const unsigned int NO_IMAGE = 0xFFFFFFFFu;
+// streamHandles entry of textures the streamer doesn't manage
+const unsigned int NOT_STREAMED = 0xFFFFFFFFu;
+// Anisotropic filtering of the diffuse maps (clamped to what the context supports)
+const GLfloat DIFFUSE_ANISOTROPY = 8.0f;
+
+// Byte offset of index (counted from the first index of mesh) in the index buffer of its pool
+static const void *indexOffset(const StaticMesh &mesh, unsigned int index)
+{
+    return (const void*)(((size_t)mesh.FirstIndex + index) * mesh.IndexSize);
+}
+
+// Sets the formats of texture to those of the pixels (or blocks) of image
+static void imageFormat(const DecodedImage &image, Texture2D &texture)
+{
+    GLenum format = image.Components == 1 ? GL_RED : image.Components == 3 ? GL_RGB : GL_RGBA;
+    texture.Internal_Format = format;
+    texture.Image_Format = format;
+    if (image.Format == BLOCK_BC1)
+        texture.Internal_Format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    else if (image.Format == BLOCK_BC3)
+        texture.Internal_Format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+// Uploads image to texture, a single white texel if it has no data
+static void uploadImage(const DecodedImage &image, Texture2D &texture)
+{
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (image.Data)
+    {
+        imageFormat(image, texture);
+        texture.Generate(image.Width, image.Height, image.Levels, image.Data);
+    }
+    else
+    {
+        // untextured material: a single white texel keeps the lighting visible
+        unsigned char white[] = { 255, 255, 255 };
+        texture.Internal_Format = GL_RGB;
+        texture.Image_Format = GL_RGB;
+        texture.Generate(1, 1, white);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+// Square root of the ratio of texture space to model space area over all triangles of a mesh
+static float texelDensity(const void *vertices, unsigned int format, const glm::vec3 &positionScale, const glm::vec3 &positionOffset,
+    const void *indices, GLsizei indexCount, GLsizei indexSize)
+{
+    double surfaceArea = 0.0, textureArea = 0.0;
+    glm::vec3 positions[3];
+    glm::vec2 texCoords[3];
+    for (GLsizei i = 0; i + 2 < indexCount; i += 3)
+    {
+        for (unsigned int corner = 0; corner < 3; ++corner)
+        {
+            unsigned int index = indexSize == 2 ? ((const unsigned short*)indices)[i + corner] : ((const unsigned int*)indices)[i + corner];
+            if (format == VERTEX_FORMAT_COMPACT)
+            {
+                const CompactVertex &vertex = ((const CompactVertex*)vertices)[index];
+                positions[corner] = glm::vec3(vertex.Position[0], vertex.Position[1], vertex.Position[2]) / 65535.0f * positionScale + positionOffset;
+                texCoords[corner] = glm::vec2(HalfToFloat(vertex.TexCoords[0]), HalfToFloat(vertex.TexCoords[1]));
+            }
+            else
+            {
+                const MeshVertex &vertex = ((const MeshVertex*)vertices)[index];
+                positions[corner] = vertex.Position;
+                texCoords[corner] = vertex.TexCoords;
+            }
+        }
+        surfaceArea += 0.5f * glm::length(glm::cross(positions[1] - positions[0], positions[2] - positions[0]));
+        glm::vec2 u = texCoords[1] - texCoords[0], v = texCoords[2] - texCoords[0];
+        textureArea += 0.5f * fabsf(u.x * v.y - u.y * v.x);
+    }
+    return surfaceArea > 0.0 ? (float)sqrt(textureArea / surfaceArea) : 0.0f;
+}
+
+StaticModel::StaticModel(const std::string &path, const MeshProcessingOptions &options, ThreadPool *pool, TextureUploader *uploader,
+    TextureStreamer *streamer)
+    : PixelError(1.0f), Pooled(false), instanceVBO(0), instanceCount(0), uploader(uploader), streamer(streamer)
+{
+    this->Directory = path.substr(0, path.find_last_of('/'));
+    if (pool)
+    {
+        this->load(path, options, *pool);
+        return;
+    }
+    ThreadPool localPool;
+    this->load(path, options, localPool);
+}
+
+void StaticModel::Draw(UniformRing &draws, const glm::mat4 &model, RenderQueue *queue)
+{
+    if (!queue)
+        glActiveTexture(GL_TEXTURE0);
+    for (unsigned int i = 0; i < this->Meshes.size(); ++i)
+    {
+        const StaticMesh &mesh = this->Meshes[i];
+        const MeshLod &lod = mesh.Lods[mesh.Lod];
+        GLsizei count = lod.IndexCount;
+        const void *offset = indexOffset(mesh, lod.IndexOffset);
+        if (!this->drawMesh(draws, mesh, model, &count, &offset, 1, 0, queue))
+            break;
+    }
+    if (queue)
+        return;
+    if (this->Pooled)
+        this->drawBatches(draws);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void StaticModel::DrawCulled(UniformRing &draws, const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection, MeshletCullStats &stats,
+    RenderQueue *queue)
+{
+    // cull in model space: meshlet bounds stay as stored, the camera moves instead
+    Frustum frustum = ExtractFrustum(projection * view * model);
+    glm::vec3 cameraPosition = glm::vec3(glm::inverse(view * model) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    if (!queue)
+        glActiveTexture(GL_TEXTURE0);
+    for (unsigned int i = 0; i < this->Meshes.size(); ++i)
+    {
+        const StaticMesh &mesh = this->Meshes[i];
+        this->ranges.Clear();
+        if (mesh.Meshlets.empty() || mesh.Lod > 0)
+        {
+            const MeshLod &lod = mesh.Lods[mesh.Lod];
+            this->ranges.Counts.push_back(lod.IndexCount);
+            this->ranges.Offsets.push_back(indexOffset(mesh, lod.IndexOffset));
+            stats.Triangles += lod.IndexCount / 3;
+            stats.TrianglesDrawn += lod.IndexCount / 3;
+            stats.Ranges++;
+        }
+        else
+        {
+            // meshlet offsets count from the start of the mesh
+            CullMeshlets(mesh.Meshlets, frustum, cameraPosition, mesh.IndexSize, this->ranges, stats);
+            for (unsigned int j = 0; j < this->ranges.Offsets.size(); ++j)
+                this->ranges.Offsets[j] = (const char*)this->ranges.Offsets[j] + (size_t)mesh.FirstIndex * mesh.IndexSize;
+        }
+        if (this->ranges.Counts.empty())
+            continue;
+        if (!this->drawMesh(draws, mesh, model, &this->ranges.Counts[0], &this->ranges.Offsets[0], (GLsizei)this->ranges.Counts.size(), 0, queue))
+            break;
+    }
+    if (queue)
+        return;
+    if (this->Pooled)
+        this->drawBatches(draws);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void StaticModel::SelectLods(const glm::mat4 &model, const glm::vec3 &cameraPosition, float zoom, float viewportHeight)
+{
+    float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    for (unsigned int i = 0; i < this->Meshes.size(); ++i)
+    {
+        StaticMesh &mesh = this->Meshes[i];
+        glm::vec3 center = glm::vec3(model * glm::vec4(mesh.Center, 1.0f));
+        float distance = glm::length(cameraPosition - center) - mesh.Radius * scale;
+        mesh.Lod = SelectLod(&mesh.Lods[0], (unsigned int)mesh.Lods.size(), distance, scale, zoom, viewportHeight, this->PixelError);
+    }
+}
+
+void StaticModel::RequestTextureLevels(const glm::mat4 &model, const glm::vec3 &cameraPosition, float zoom, float viewportHeight)
+{
+    if (!this->streamer)
+        return;
+    float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    for (unsigned int i = 0; i < this->Meshes.size(); ++i)
+    {
+        const StaticMesh &mesh = this->Meshes[i];
+        unsigned int handle = this->streamHandles[mesh.Material];
+        if (handle == NOT_STREAMED)
+            continue;
+        glm::vec3 center = glm::vec3(model * glm::vec4(mesh.Center, 1.0f));
+        float distance = glm::length(cameraPosition - center) - mesh.Radius * scale;
+        GLuint level = 0;
+        if (distance > 0.0f && mesh.TexelDensity > 0.0f)
+        {
+            // texels of the full size texture one pixel covers at the nearest point of the mesh
+            float pixelsPerUnit = viewportHeight / (2.0f * distance * tanf(glm::radians(zoom) * 0.5f));
+            float texelsPerPixel = this->streamer->Size(handle) * mesh.TexelDensity / (scale * pixelsPerUnit);
+            level = texelsPerPixel > 1.0f ? (GLuint)log2f(texelsPerPixel) : 0;
+        }
+        this->streamer->Request(handle, level);
+    }
+}
+
+void StaticModel::SetInstances(const std::vector<ModelInstance> &instances)
+{
+    if (!this->instanceVBO)
+    {
+        // point the per-instance attributes of every mesh (and pool) at the instance buffer, advancing once per instance
+        std::vector<GLuint> vertexArrays;
+        for (unsigned int i = 0; i < this->Meshes.size(); ++i)
+            vertexArrays.push_back(this->Meshes[i].VAO);
+        for (unsigned int i = 0; i < this->Pools.size(); ++i)
+            vertexArrays.push_back(this->Pools[i].VAO);
+        glGenBuffers(1, &this->instanceVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+        for (unsigned int i = 0; i < vertexArrays.size(); ++i)
+        {
+            glBindVertexArray(vertexArrays[i]);
+            for (GLuint column = 0; column < 4; ++column)
+            {
+                glEnableVertexAttribArray(3 + column);
+                glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(ModelInstance),
+                    (void*)(offsetof(ModelInstance, Model) + column * sizeof(glm::vec4)));
+                glVertexAttribDivisor(3 + column, 1);
+            }
+            for (GLuint column = 0; column < 3; ++column)
+            {
+                glEnableVertexAttribArray(7 + column);
+                glVertexAttribPointer(7 + column, 3, GL_FLOAT, GL_FALSE, sizeof(ModelInstance),
+                    (void*)(offsetof(ModelInstance, NormalMatrix) + column * sizeof(glm::vec3)));
+                glVertexAttribDivisor(7 + column, 1);
+            }
+        }
+        glBindVertexArray(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(ModelInstance), instances.empty() ? NULL : &instances[0], GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    this->instanceCount = (GLsizei)instances.size();
+    this->instances = instances;
+}
+
+void StaticModel::DrawInstanced(UniformRing &draws, RenderQueue *queue)
+{
+    if (this->instanceCount == 0)
+        return;
+    if (!queue)
+        glActiveTexture(GL_TEXTURE0);
+    for (unsigned int i = 0; i < this->Meshes.size(); ++i)
+    {
+        const StaticMesh &mesh = this->Meshes[i];
+        const MeshLod &lod = mesh.Lods[mesh.Lod];
+        GLsizei count = lod.IndexCount;
+        const void *offset = indexOffset(mesh, lod.IndexOffset);
+        if (!this->drawMesh(draws, mesh, glm::mat4(), &count, &offset, 1, this->instanceCount, queue))
+            break;
+    }
+    if (queue)
+        return;
+    if (this->Pooled)
+        this->drawBatches(draws);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void StaticModel::DrawInstancesCulled(UniformRing &draws, const glm::mat4 &view, const glm::mat4 &projection, InstanceCuller &culler)
+{
+    if (this->instanceCount == 0)
+        return;
+    std::vector<CullMesh> meshes(this->Meshes.size());
+    for (unsigned int i = 0; i < this->Meshes.size(); ++i)
+    {
+        const StaticMesh &mesh = this->Meshes[i];
+        const MeshLod &lod = mesh.Lods[mesh.Lod];
+        meshes[i].Sphere = glm::vec4(mesh.Center, mesh.Radius);
+        meshes[i].Count = lod.IndexCount;
+        meshes[i].FirstIndex = mesh.FirstIndex + lod.IndexOffset;
+        meshes[i].BaseVertex = mesh.BaseVertex;
+        meshes[i].Padding = 0;
+    }
+    culler.Cull(meshes, this->instances, this->instanceVBO, projection * view);
+
+    glActiveTexture(GL_TEXTURE0);
+    unsigned int pool = (unsigned int)this->Pools.size();
+    for (unsigned int i = 0; i < this->Meshes.size(); ++i)
+    {
+        const StaticMesh &mesh = this->Meshes[i];
+        DrawUniforms uniforms;
+        SetDrawModel(uniforms, glm::mat4());
+        uniforms.PositionScale = glm::vec4(mesh.PositionScale, 0.0f);
+        uniforms.PositionOffset = glm::vec4(mesh.PositionOffset, 0.0f);
+        uniforms.Instanced = 1;
+        if (!draws.Push(&uniforms))
+            break;
+        this->Textures[mesh.Material].Bind();
+        if (mesh.Pool != pool)
+        {
+            pool = mesh.Pool;
+            glBindVertexArray(this->Pools[pool].VAO);
+        }
+        culler.Draw(i, this->Pools[pool]);
+    }
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool StaticModel::drawMesh(UniformRing &draws, const StaticMesh &mesh, const glm::mat4 &model, const GLsizei *counts, const void *const *offsets,
+    GLsizei rangeCount, GLsizei instances, RenderQueue *queue)
+{
+    DrawUniforms uniforms;
+    SetDrawModel(uniforms, model);
+    uniforms.PositionScale = glm::vec4(mesh.PositionScale, 0.0f);
+    uniforms.PositionOffset = glm::vec4(mesh.PositionOffset, 0.0f);
+    uniforms.Instanced = instances > 0;
+    if (queue)
+    {
+        GLintptr block = draws.Write(&uniforms);
+        if (block < 0)
+            return false;
+        // pooled: the pool's vertex array, shared with the other meshes, plus the base vertex
+        GLuint vertexArray = this->Pooled ? this->Pools[mesh.Pool].VAO : mesh.VAO;
+        queue->Add(this->Textures[mesh.Material].BindingID(), vertexArray, block, mesh.IndexType, counts, offsets, (unsigned int)rangeCount,
+            glm::vec3(model * glm::vec4(mesh.Center, 1.0f)), instances, this->Pooled ? mesh.BaseVertex : 0);
+        return true;
+    }
+    if (this->Pooled)
+        return this->batchMesh(draws, mesh, uniforms, counts, offsets, rangeCount, instances);
+    if (!draws.Push(&uniforms))
+        return false;
+    this->Textures[mesh.Material].Bind();
+    glBindVertexArray(mesh.VAO);
+    if (instances > 0)
+        glDrawElementsInstanced(GL_TRIANGLES, counts[0], mesh.IndexType, offsets[0], instances);
+    else if (rangeCount == 1)
+        glDrawElements(GL_TRIANGLES, counts[0], mesh.IndexType, offsets[0]);
+    else
+        glMultiDrawElements(GL_TRIANGLES, counts, mesh.IndexType, offsets, rangeCount);
+    return true;
+}
+
+bool StaticModel::batchMesh(UniformRing &draws, const StaticMesh &mesh, const DrawUniforms &uniforms, const GLsizei *counts, const void *const *offsets,
+    GLsizei rangeCount, GLsizei instances)
+{
+    if (this->batches.empty() || this->batches.back().Pool != mesh.Pool || this->batches.back().Material != mesh.Material ||
+        this->batches.back().PositionScale != mesh.PositionScale || this->batches.back().PositionOffset != mesh.PositionOffset)
+    {
+        PoolBatch batch;
+        batch.Uniforms = draws.Write(&uniforms);
+        if (batch.Uniforms < 0)
+            return false;
+        batch.Pool = mesh.Pool;
+        batch.Material = mesh.Material;
+        batch.PositionScale = mesh.PositionScale;
+        batch.PositionOffset = mesh.PositionOffset;
+        batch.FirstCommand = (unsigned int)this->indirect.Commands.size();
+        batch.CommandCount = 0;
+        this->batches.push_back(batch);
+    }
+    for (GLsizei i = 0; i < rangeCount; ++i)
+    {
+        DrawElementsIndirectCommand command;
+        command.Count = (GLuint)counts[i];
+        command.InstanceCount = instances > 0 ? (GLuint)instances : 1;
+        command.FirstIndex = (GLuint)((size_t)offsets[i] / mesh.IndexSize);
+        command.BaseVertex = mesh.BaseVertex;
+        command.BaseInstance = 0;
+        this->indirect.Commands.push_back(command);
+    }
+    this->batches.back().CommandCount += (unsigned int)rangeCount;
+    return true;
+}
+
+void StaticModel::drawBatches(UniformRing &draws)
+{
+    this->indirect.Upload();
+    unsigned int pool = (unsigned int)this->Pools.size();
+    for (unsigned int i = 0; i < this->batches.size(); ++i)
+    {
+        const PoolBatch &batch = this->batches[i];
+        if (batch.Pool != pool)
+        {
+            pool = batch.Pool;
+            glBindVertexArray(this->Pools[pool].VAO);
+        }
+        draws.BindBlock(batch.Uniforms);
+        this->Textures[batch.Material].Bind();
+        this->indirect.Draw(this->Pools[pool], batch.FirstCommand, batch.CommandCount);
+    }
+    this->batches.clear();
+    this->indirect.Commands.clear();
+}
+
+void StaticModel::load(const std::string &path, const MeshProcessingOptions &options, ThreadPool &pool)
+{
+    MeshCache cache;
+    if (cache.Load(path, options))
+    {
+        this->loadFromCache(cache, pool);
+        return;
+    }
+    // no usable cache (e.g. read-only directory): fall back to the text path
+    ModelData model;
+    if (LoadProcessedModel(path, model, options))
+        this->loadFromData(model, pool);
+}
+
+void StaticModel::loadFromCache(const MeshCache &cache, ThreadPool &pool)
+{
+    const MeshCacheHeader &header = cache.Header();
+    std::vector<std::string> diffuseMaps;
+    for (unsigned int i = 0; i < header.MaterialCount; ++i)
+        diffuseMaps.push_back(cache.Material(i).DiffuseMap);
+    this->decodeMaterials(diffuseMaps, pool);
+    // meshes welding or grouping left without triangles are skipped, as loadFromData does
+    for (unsigned int i = 0; i < header.MeshCount; ++i)
+    {
+        const MeshCacheMesh &mesh = cache.Mesh(i);
+        if (mesh.IndexCount > 0)
+            this->Pools[this->poolFor(mesh.VertexFormat, mesh.IndexSize)].Reserve((GLsizeiptr)mesh.VertexCount * mesh.VertexStride, mesh.IndexCount);
+    }
+    this->generatePools();
+    for (unsigned int i = 0; i < header.MeshCount; ++i)
+    {
+        const MeshCacheMesh &mesh = cache.Mesh(i);
+        if (mesh.IndexCount == 0)
+            continue;
+        this->addMesh(cache.Vertices(i), (GLsizeiptr)mesh.VertexCount * mesh.VertexStride, mesh.VertexFormat,
+            glm::vec3(mesh.PositionScale[0], mesh.PositionScale[1], mesh.PositionScale[2]),
+            glm::vec3(mesh.PositionOffset[0], mesh.PositionOffset[1], mesh.PositionOffset[2]),
+            cache.Indices(i), mesh.IndexCount, mesh.IndexSize, mesh.Material);
+        StaticMesh &added = this->Meshes.back();
+        added.Meshlets.assign(cache.Meshlets(i), cache.Meshlets(i) + mesh.MeshletCount);
+        if (mesh.LodCount)
+            added.Lods.assign(cache.Lods(i), cache.Lods(i) + mesh.LodCount);
+        added.Center = glm::vec3(mesh.Center[0], mesh.Center[1], mesh.Center[2]);
+        added.Radius = mesh.Radius;
+    }
+    this->uploadMaterials(pool);
+}
+
+void StaticModel::loadFromData(const ModelData &model, ThreadPool &pool)
+{
+    std::vector<std::string> diffuseMaps;
+    for (unsigned int i = 0; i < model.Materials.size(); ++i)
+        diffuseMaps.push_back(model.Materials[i].DiffuseMap);
+    this->decodeMaterials(diffuseMaps, pool);
+    for (unsigned int i = 0; i < model.Meshes.size(); ++i)
+    {
+        const MeshData &mesh = model.Meshes[i];
+        if (!mesh.Indices.empty())
+            this->Pools[this->poolFor(mesh.Format, IndexSizeFor(mesh.Vertices.size()))].Reserve(
+                (GLsizeiptr)mesh.Vertices.size() * VertexStride(mesh.Format), (GLsizei)mesh.Indices.size());
+    }
+    this->generatePools();
+    std::vector<unsigned char> vertices, indices;
+    for (unsigned int i = 0; i < model.Meshes.size(); ++i)
+    {
+        const MeshData &mesh = model.Meshes[i];
+        if (mesh.Indices.empty())
+            continue;
+        unsigned int indexSize = IndexSizeFor(mesh.Vertices.size());
+        PackVertices(mesh, vertices);
+        PackIndices(mesh.Indices, indexSize, indices);
+        this->addMesh(&vertices[0], vertices.size(), mesh.Format, mesh.PositionScale, mesh.PositionOffset,
+            &indices[0], (GLsizei)mesh.Indices.size(), indexSize, mesh.Material);
+        StaticMesh &added = this->Meshes.back();
+        added.Meshlets = mesh.Meshlets;
+        if (!mesh.Lods.empty())
+            added.Lods = mesh.Lods;
+        added.Center = mesh.Center;
+        added.Radius = mesh.Radius;
+    }
+    this->uploadMaterials(pool);
+}
+
+void StaticModel::addMesh(const void *vertices, GLsizeiptr vertexBytes, unsigned int format, const glm::vec3 &positionScale, const glm::vec3 &positionOffset,
+    const void *indices, GLsizei indexCount, GLsizei indexSize, unsigned int material)
+{
+    StaticMesh mesh;
+    mesh.IndexCount = indexCount;
+    mesh.IndexType = indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    mesh.IndexSize = indexSize;
+    MeshLod whole = { 0, (unsigned int)indexCount, 0.0f };
+    mesh.Lods.push_back(whole);
+    mesh.Lod = 0;
+    mesh.Center = glm::vec3(0.0f);
+    mesh.Radius = 0.0f;
+    mesh.TexelDensity = texelDensity(vertices, format, positionScale, positionOffset, indices, indexCount, indexSize);
+    mesh.Material = material;
+    mesh.PositionScale = positionScale;
+    mesh.PositionOffset = positionOffset;
+    mesh.Pool = this->poolFor(format, indexSize);
+    GeometryPool &pool = this->Pools[mesh.Pool];
+    pool.Add(vertices, vertexBytes, indices, indexCount, mesh.BaseVertex, mesh.FirstIndex);
+    glGenVertexArrays(1, &mesh.VAO);
+    pool.SetupVertexArray(mesh.VAO, mesh.BaseVertex);
+    glBindVertexArray(0);
+
+    this->Meshes.push_back(mesh);
+}
+
+unsigned int StaticModel::poolFor(unsigned int format, GLsizei indexSize)
+{
+    for (unsigned int i = 0; i < this->Pools.size(); ++i)
+        if (this->Pools[i].Format == format && this->Pools[i].IndexSize == indexSize)
+            return i;
+    GeometryPool pool;
+    pool.Format = format;
+    pool.IndexSize = indexSize;
+    this->Pools.push_back(pool);
+    return (unsigned int)this->Pools.size() - 1;
+}
+
+void StaticModel::generatePools()
+{
+    for (unsigned int i = 0; i < this->Pools.size(); ++i)
+        this->Pools[i].Generate(this->Pools[i].Format, this->Pools[i].IndexSize);
+    this->indirect.Generate();
+}
+
+void StaticModel::decodeMaterials(const std::vector<std::string> &diffuseMaps, ThreadPool &pool)
+{
+    // several materials often share a map, matched to the files on disk ignoring case
+    // (suv.mtl references tex_0040_1.png, the file is Tex_0040_1.png)
+    PathResolver resolver;
+    std::vector<std::string> files;
+    this->materialImages.clear();
+    for (unsigned int i = 0; i < diffuseMaps.size(); ++i)
+    {
+        if (diffuseMaps[i].empty())
+        {
+            this->materialImages.push_back(NO_IMAGE);
+            continue;
+        }
+        std::string path = this->Directory + '/' + resolver.Resolve(this->Directory, diffuseMaps[i]);
+        unsigned int image = (unsigned int)(std::find(files.begin(), files.end(), path) - files.begin());
+        if (image == files.size())
+            files.push_back(path);
+        this->materialImages.push_back(image);
+    }
+    // block compress (through the on-disk cache) where the driver can sample S3TC
+    unsigned int flags = TEXTURE_MIPMAPS;
+    if (HasGLSupport(0, 0, "GL_EXT_texture_compression_s3tc"))
+        flags |= TEXTURE_COMPRESS;
+    DecodeImages(files, this->images, pool, flags);
+}
+
+void StaticModel::uploadMaterials(ThreadPool &pool)
+{
+    pool.Wait();
+    // textures are never copied, pending ones are updated in place by the uploader
+    bool untextured = false;
+    for (unsigned int i = 0; i < this->Meshes.size(); ++i)
+    {
+        unsigned int material = this->Meshes[i].Material;
+        untextured |= material >= this->materialImages.size() || this->materialImages[material] == NO_IMAGE;
+    }
+    this->Textures.resize(this->images.size() + (untextured ? 1 : 0));
+    this->streamHandles.assign(this->Textures.size(), NOT_STREAMED);
+    for (unsigned int i = 0; i < this->images.size(); ++i)
+    {
+        DecodedImage &image = this->images[i];
+        // trilinear (and anisotropic) filtering over the mip chain the decode tasks built
+        if (image.Levels > 1)
+        {
+            this->Textures[i].Filter_Min = GL_LINEAR_MIPMAP_LINEAR;
+            this->Textures[i].Max_Anisotropy = DIFFUSE_ANISOTROPY;
+        }
+        if (this->streamer && image.Data && image.Levels > 1)
+        {
+            imageFormat(image, this->Textures[i]);
+            this->streamHandles[i] = this->streamer->Add(this->Textures[i], image);
+        }
+        else if (this->uploader && image.Data)
+        {
+            imageFormat(image, this->Textures[i]);
+            this->Textures[i].GenerateAsync(image.Width, image.Height, image.Levels, image.Data, *this->uploader);
+            image.Data = NULL; // owned by the uploader now
+        }
+        else
+            uploadImage(image, this->Textures[i]);
+    }
+    FreeImages(this->images);
+    this->images.clear();
+    if (untextured)
+    {
+        DecodedImage none = { std::string(), 0, 0, 0, 1, BLOCK_NONE, false, NULL };
+        uploadImage(none, this->Textures.back());
+    }
+    for (unsigned int i = 0; i < this->Meshes.size(); ++i)
+    {
+        StaticMesh &mesh = this->Meshes[i];
+        unsigned int image = mesh.Material < this->materialImages.size() ? this->materialImages[mesh.Material] : NO_IMAGE;
+        mesh.Material = image != NO_IMAGE ? image : (unsigned int)this->Textures.size() - 1;
+    }
+}
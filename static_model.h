@@ -0,0 +1,158 @@
+#ifndef STATIC_MODEL_H
+#define STATIC_MODEL_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+
+#include "geometry_pool.h"
+#include "mesh_cache.h"
+#include "mesh_lod.h"
+#include "mesh_processing.h"
+#include "meshlet.h"
+#include "model_data.h"
+#include "path_resolver.h"
+#include "render_queue.h"
+#include "texture.h"
+#include "texture_loader.h"
+#include "texture_stream.h"
+#include "texture_upload.h"
+#include "thread_pool.h"
+#include "uniform_buffer.h"
+#include "vertex_format.h"
+
+class InstanceCuller;
+
+// GPU copy of a single mesh, its vertices and indices live in one of the model's geometry pools
+struct StaticMesh
+{
+    GLuint VAO;            // Reads the mesh's vertices in its pool, so its indices need no base vertex
+    unsigned int Pool;     // Index into StaticModel::Pools
+    GLint BaseVertex;      // Where its vertices and indices start in the pool
+    GLuint FirstIndex;
+    GLsizei IndexCount;
+    GLenum IndexType;      // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    GLsizei IndexSize;
+    unsigned int Material; // Index into StaticModel::Textures (its diffuse map)
+    std::vector<Meshlet> Meshlets; // Culling bounds of the first level, empty if the mesh was built without
+    std::vector<MeshLod> Lods;     // At least one level, the whole index buffer if built without
+    unsigned int Lod;              // Level drawn, set by StaticModel::SelectLods
+    glm::vec3 Center;              // Bounding sphere, model space
+    float Radius;
+    glm::vec3 PositionScale, PositionOffset; // DrawUniforms::PositionScale/PositionOffset
+    float TexelDensity;            // Texture space units per model space unit (0 if the mesh has no area)
+};
+
+// Per-instance data read by car.vs when drawing instanced (attributes 3-6 and 7-9)
+struct ModelInstance
+{
+    glm::mat4 Model;
+    glm::mat3 NormalMatrix;
+    ModelInstance(const glm::mat4 &model) : Model(model), NormalMatrix(glm::transpose(glm::inverse(glm::mat3(model)))) { }
+};
+
+// StaticModel is a drop-in replacement for learnopengl's Model that loads
+// through the binary mesh cache: vertex data is uploaded straight from the
+// memory-mapped cache file, the source is only parsed when the cache is stale.
+// Draws read the Frame block the caller updates and push a Draw block per mesh
+// to the given ring, the sampler texture_diffuse1 has to be set to unit 0.
+class StaticModel
+{
+public:
+    // Model data
+    std::vector<StaticMesh> Meshes;
+    std::vector<Texture2D> Textures; // Distinct diffuse maps, then a white one if some material has none
+    std::vector<GeometryPool> Pools; // Vertices and indices of all meshes, one pool per vertex format and index size
+    std::string Directory;
+    float PixelError; // Screen space error (pixels) SelectLods allows, 1 by default
+    bool Pooled;      // Draw through the pools' vertex arrays with multi-draws instead of per mesh, false by default
+    // Constructor, expects a filepath to a 3D model and the processing to apply to its meshes.
+    // Textures are decoded on pool (a temporary pool with one thread per core if NULL) while
+    // the meshes upload, only their GL upload happens on the calling thread. With an uploader
+    // the GL upload is queued on it too: textures draw its placeholder until they are resident.
+    // With a streamer mipmapped textures start with their mip tail instead, and
+    // RequestTextureLevels asks it for the finer levels the view needs.
+    StaticModel(const std::string &path, const MeshProcessingOptions &options = MeshProcessingOptions(), ThreadPool *pool = NULL,
+        TextureUploader *uploader = NULL, TextureStreamer *streamer = NULL);
+    // Draws the model, and thus all its meshes, with the given model matrix. The Draw block of
+    // every mesh carries its PositionScale and PositionOffset, shaders reading compact vertices
+    // decode aPos with them. With a queue the draws are recorded in it instead of issued,
+    // RenderQueue::Submit sorts and issues them (this goes for all Draw variants). Pooled
+    // draws bind each pool's vertex array once and issue the meshes of a material (with the
+    // same Draw block) as one glMultiDrawElementsIndirect, or glMultiDrawElementsBaseVertex
+    // without GL 4.3, after all meshes were visited.
+    void Draw(UniformRing &draws, const glm::mat4 &model, RenderQueue *queue = NULL);
+    // Draws only the meshlets visible with the given transformations (falls back to Draw for
+    // meshes without meshlets), submitting one glMultiDrawElements per mesh. Adds to stats.
+    void DrawCulled(UniformRing &draws, const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection, MeshletCullStats &stats,
+        RenderQueue *queue = NULL);
+    // Picks the level of detail of every mesh for the next draws: the coarsest one whose error,
+    // scaled by the model matrix and projected with a vertical field of view of zoom degrees
+    // (Camera::Zoom), stays within PixelError. Meshlets are only culled at the finest level.
+    void SelectLods(const glm::mat4 &model, const glm::vec3 &cameraPosition, float zoom, float viewportHeight);
+    // Requests from the streamer the mip level every texture needs for its meshes to get about
+    // one texel per pixel: texel density of the mesh scaled by the model matrix and projected
+    // at the distance of its bounding sphere, as SelectLods does. Does nothing without a streamer.
+    void RequestTextureLevels(const glm::mat4 &model, const glm::vec3 &cameraPosition, float zoom, float viewportHeight);
+    // Replaces the instances drawn by DrawInstanced
+    void SetInstances(const std::vector<ModelInstance> &instances);
+    // Draws all instances at once, one glDrawElementsInstanced per mesh (levels as picked by
+    // SelectLods). Sets Instanced in the Draw blocks so car.vs reads the per-instance matrices.
+    void DrawInstanced(UniformRing &draws, RenderQueue *queue = NULL);
+    // Draws the instances whose meshes are inside the frustum of projection * view: culler tests
+    // the bounding sphere of every mesh of every instance and each mesh is drawn with one
+    // indirect multi-draw of its visible instances out of its geometry pool (levels as picked
+    // by SelectLods). Sets Instanced in the Draw blocks like DrawInstanced.
+    void DrawInstancesCulled(UniformRing &draws, const glm::mat4 &view, const glm::mat4 &projection, InstanceCuller &culler);
+private:
+    GLuint instanceVBO;
+    GLsizei instanceCount;
+    std::vector<ModelInstance> instances; // As uploaded to instanceVBO, for culling on the CPU
+    DrawRanges ranges; // Scratch list of DrawCulled
+    // Meshes drawn by one multi-draw of the pooled path
+    struct PoolBatch
+    {
+        unsigned int Pool, Material;
+        GLintptr Uniforms;            // Draw block shared by the meshes
+        glm::vec3 PositionScale, PositionOffset;
+        unsigned int FirstCommand, CommandCount;
+    };
+    std::vector<PoolBatch> batches;
+    IndirectDrawBuffer indirect;  // Commands of the batches
+    // Pushes the Draw block of mesh and draws rangeCount index ranges of it with its texture and
+    // VAO (instanced if instances is not 0), records the draw in queue, or adds it to the
+    // pooled batches. False if the ring is full.
+    bool drawMesh(UniformRing &draws, const StaticMesh &mesh, const glm::mat4 &model, const GLsizei *counts, const void *const *offsets,
+        GLsizei rangeCount, GLsizei instances, RenderQueue *queue);
+    // Adds the ranges of mesh as indirect commands, to the last batch if it has the same pool,
+    // texture and Draw block, otherwise to a new one with uniforms written to the ring
+    bool batchMesh(UniformRing &draws, const StaticMesh &mesh, const DrawUniforms &uniforms, const GLsizei *counts, const void *const *offsets,
+        GLsizei rangeCount, GLsizei instances);
+    // Uploads the commands and issues the batches, one multi-draw each
+    void drawBatches(UniformRing &draws);
+    std::vector<DecodedImage> images; // Distinct diffuse maps being decoded
+    std::vector<unsigned int> materialImages; // Index into images per material (NO_IMAGE if untextured)
+    TextureUploader *uploader;        // Queues the texture uploads if not NULL
+    TextureStreamer *streamer;        // Streams the texture levels in if not NULL
+    std::vector<unsigned int> streamHandles; // TextureStreamer handle per texture (NOT_STREAMED for the white one)
+    // Loads through the mesh cache, or the source if there is no usable cache
+    void load(const std::string &path, const MeshProcessingOptions &options, ThreadPool &pool);
+    // Pool for meshes of format and indexSize, appended (not yet generated) if there is none
+    unsigned int poolFor(unsigned int format, GLsizei indexSize);
+    // Creates the buffers of the pools once all meshes are reserved
+    void generatePools();
+    // Uploads all meshes of a mapped cache
+    void loadFromCache(const MeshCache &cache, ThreadPool &pool);
+    // Uploads all meshes of an in-memory model (used when no cache can be written)
+    void loadFromData(const ModelData &model, ThreadPool &pool);
+    void addMesh(const void *vertices, GLsizeiptr vertexBytes, unsigned int format, const glm::vec3 &positionScale, const glm::vec3 &positionOffset,
+        const void *indices, GLsizei indexCount, GLsizei indexSize, unsigned int material);
+    // Queues decoding of the diffuse maps of all materials on pool, each distinct file once
+    void decodeMaterials(const std::vector<std::string> &diffuseMaps, ThreadPool &pool);
+    // Waits for the decodes and uploads (or queues) one texture per distinct file, then points
+    // the meshes of its materials at it
+    void uploadMaterials(ThreadPool &pool);
+};
+
+#endif
@@ -6,34 +6,135 @@
 ** Creative Commons, either version 4 of the License, or (at your
 ** option) any later version.
 ******************************************************************/
+#include <algorithm>
 #include <iostream>
 
+#include "gl_ext.h"
+#include "mipmap.h"
 #include "texture.h"
+#include "texture_compress.h"
+#include "texture_upload.h"
 
 
 Texture2D::Texture2D()
-    : Width(0), Height(0), Internal_Format(GL_RGB), Image_Format(GL_RGB), Wrap_S(GL_REPEAT), Wrap_T(GL_REPEAT), Filter_Min(GL_LINEAR), Filter_Max(GL_LINEAR)
+    : Width(0), Height(0), Internal_Format(GL_RGB), Image_Format(GL_RGB), Wrap_S(GL_REPEAT), Wrap_T(GL_REPEAT), Filter_Min(GL_LINEAR), Filter_Max(GL_LINEAR), Max_Anisotropy(1.0f), Levels(1), State(TEXTURE_RESIDENT), Placeholder(0)
 {
     glGenTextures(1, &this->ID);
 }
 
+// Sized equivalent of an unsized internal format, glTexStorage2D only takes sized ones
+static GLenum sizedFormat(GLenum format)
+{
+    switch (format)
+    {
+    case GL_RED: return GL_R8;
+    case GL_RG: return GL_RG8;
+    case GL_RGB: return GL_RGB8;
+    case GL_RGBA: return GL_RGBA8;
+    case GL_SRGB: return GL_SRGB8;
+    case GL_SRGB_ALPHA: return GL_SRGB8_ALPHA8;
+    default: return format;
+    }
+}
+
 void Texture2D::Generate(GLuint width, GLuint height, unsigned char* data)
+{
+    this->Generate(width, height, 1, data);
+}
+
+void Texture2D::Generate(GLuint width, GLuint height, GLuint levels, unsigned char* data)
 {
     this->Width = width;
     this->Height = height;
+    this->Levels = levels;
     // Create Texture
     glBindTexture(GL_TEXTURE_2D, this->ID);
-    glTexImage2D(GL_TEXTURE_2D, 0, this->Internal_Format, width, height, 0, this->Image_Format, GL_UNSIGNED_BYTE, data);
+    if (glTexStorage2D)
+        glTexStorage2D(GL_TEXTURE_2D, levels, sizedFormat(this->Internal_Format), width, height);
+    size_t offset = 0;
+    for (GLuint level = 0; level < levels; ++level)
+    {
+        GLsizei levelWidth = MipLevelSize(width, level), levelHeight = MipLevelSize(height, level);
+        unsigned char *pixels = data ? data + offset : NULL;
+        if (glTexStorage2D)
+        {
+            if (pixels)
+                this->SubImage(level, pixels);
+        }
+        else if (this->Compressed())
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, this->Internal_Format, levelWidth, levelHeight, 0, (GLsizei)this->LevelBytes(level), pixels);
+        else
+            glTexImage2D(GL_TEXTURE_2D, level, this->Internal_Format, levelWidth, levelHeight, 0, this->Image_Format, GL_UNSIGNED_BYTE, pixels);
+        offset += this->LevelBytes(level);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
     // Set Texture wrap and filter modes
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, this->Wrap_S);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, this->Wrap_T);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->Filter_Min);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->Filter_Max);
+    if (this->Max_Anisotropy > 1.0f)
+    {
+        GLfloat supported = MaxTextureAnisotropy();
+        if (supported > 1.0f)
+            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY, std::min(this->Max_Anisotropy, supported));
+    }
     // Unbind texture
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
+void Texture2D::GenerateAsync(GLuint width, GLuint height, GLuint levels, unsigned char* data, TextureUploader &uploader)
+{
+    // Allocate storage only, the pixels follow through the uploader's ring
+    this->Generate(width, height, levels, NULL);
+    uploader.Queue(*this, data);
+}
+
+GLuint Texture2D::Components() const
+{
+    switch (this->Image_Format)
+    {
+    case GL_RED: return 1;
+    case GL_RG: return 2;
+    case GL_RGB: case GL_BGR: return 3;
+    default: return 4;
+    }
+}
+
+bool Texture2D::Compressed() const
+{
+    return this->Internal_Format >= GL_COMPRESSED_RGB_S3TC_DXT1_EXT && this->Internal_Format <= GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+size_t Texture2D::LevelBytes(GLuint level) const
+{
+    if (!this->Compressed())
+        return MipLevelBytes(this->Width, this->Height, this->Components(), level);
+    // DXT1 blocks are 8 bytes, DXT3 and DXT5 16
+    BlockFormat format = this->Internal_Format <= GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? BLOCK_BC1 : BLOCK_BC3;
+    return CompressedLevelBytes(this->Width, this->Height, format, level);
+}
+
+void Texture2D::SubImage(GLuint level, const unsigned char* pixels) const
+{
+    GLsizei width = MipLevelSize(this->Width, level), height = MipLevelSize(this->Height, level);
+    if (this->Compressed())
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, this->Internal_Format, (GLsizei)this->LevelBytes(level), pixels);
+    else
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, this->Image_Format, GL_UNSIGNED_BYTE, pixels);
+}
+
+bool Texture2D::Resident() const
+{
+    return this->State == TEXTURE_RESIDENT;
+}
+
+GLuint Texture2D::BindingID() const
+{
+    return this->State == TEXTURE_PENDING ? this->Placeholder : this->ID;
+}
+
 void Texture2D::Bind() const
 {
-    glBindTexture(GL_TEXTURE_2D, this->ID);
+    glBindTexture(GL_TEXTURE_2D, this->BindingID());
 }
\ No newline at end of file
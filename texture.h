@@ -9,7 +9,18 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
-#include <GL/glew.h>
+#include <glad/glad.h>
+
+#include <cstddef>
+
+class TextureUploader;
+
+// Whether the image of a texture can be sampled yet
+enum TextureState
+{
+    TEXTURE_RESIDENT, // Image uploaded (or none given yet)
+    TEXTURE_PENDING   // Upload through a TextureUploader still in flight
+};
 
 // Texture2D is able to store and configure a texture in OpenGL.
 // It also hosts utility functions for easy management.
@@ -28,11 +39,36 @@ public:
     GLuint Wrap_T; // Wrapping mode on T axis
     GLuint Filter_Min; // Filtering mode if texture pixels < screen pixels
     GLuint Filter_Max; // Filtering mode if texture pixels > screen pixels
+    GLfloat Max_Anisotropy; // Anisotropic filtering samples (1 = off), clamped to what the context supports
+    GLuint Levels; // Mip levels the texture was generated with
+    // Upload state
+    TextureState State;
+    GLuint Placeholder; // Texture bound instead while the upload is pending
     // Constructor (sets default texture modes)
     Texture2D();
     // Generates texture from image data
     void Generate(GLuint width, GLuint height, unsigned char* data);
-    // Binds the texture as the current active GL_TEXTURE_2D texture object
+    // Generates texture with levels mip levels from data holding all of them back to back (rows
+    // tightly packed, see mipmap.h, or S3TC blocks if Internal_Format is a compressed format), or
+    // only allocates them if data is NULL. Storage is immutable (glTexStorage2D) where the context
+    // supports it.
+    void Generate(GLuint width, GLuint height, GLuint levels, unsigned char* data);
+    // Allocates the texture and queues the upload of data (levels back to back, stb_image memory,
+    // taken over) on uploader; the texture stays pending until uploader.Update sees the copy finish
+    void GenerateAsync(GLuint width, GLuint height, GLuint levels, unsigned char* data, TextureUploader &uploader);
+    // Channels per pixel of Image_Format
+    GLuint Components() const;
+    // Whether Internal_Format is one of the S3TC (BC1-BC3) formats
+    bool Compressed() const;
+    // Bytes of mip level as Generate and SubImage expect them
+    size_t LevelBytes(GLuint level) const;
+    // Replaces mip level of the bound texture with pixels (an offset into the bound pixel unpack buffer if there is one)
+    void SubImage(GLuint level, const unsigned char* pixels) const;
+    // Whether the image can be sampled, pending textures bind the placeholder
+    bool Resident() const;
+    // Texture object Bind binds: the placeholder while pending, ID otherwise
+    GLuint BindingID() const;
+    // Binds the texture (its placeholder while pending) as the current active GL_TEXTURE_2D texture object
     void Bind() const;
 };
 
@@ -0,0 +1,98 @@
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "mapped_file.h"
+#include "texture_cache.h"
+
+
+// Stores mtime as the source timestamp of the cache file at cachePath, in place. Best effort:
+// if it fails the contents are just compared again next time.
+static void recordMTime(const std::string &cachePath, int64_t mtime)
+{
+    FILE *file = fopen(cachePath.c_str(), "r+b");
+    if (!file)
+        return;
+    if (fseek(file, (long)offsetof(TextureCacheHeader, SourceMTime), SEEK_SET) == 0)
+        fwrite(&mtime, sizeof(mtime), 1, file);
+    fclose(file);
+}
+
+// Whether the source stamp of header still describes the image at imagePath
+static bool sourceMatches(const std::string &imagePath, const TextureCacheHeader &header)
+{
+    int64_t mtime;
+    uint64_t size;
+    if (!StatFile(imagePath, mtime, size) || size != header.SourceSize)
+        return false;
+    // same timestamp and size: trust it without reading the file
+    if (mtime == header.SourceMTime)
+        return true;
+    // touched (checkout, copy) but possibly unchanged: compare contents, and record the new
+    // timestamp when they match so the next launch doesn't hash the source again
+    MappedFile source;
+    if (!source.Open(imagePath) || HashBytes(source.Data(), source.Size()) != header.SourceHash)
+        return false;
+    recordMTime(TextureCachePath(imagePath), mtime);
+    return true;
+}
+
+std::string TextureCachePath(const std::string &imagePath)
+{
+    return imagePath + ".texcache";
+}
+
+bool ReadTextureCache(const std::string &imagePath, TextureCacheHeader &header, unsigned char *&data)
+{
+    std::ifstream in(TextureCachePath(imagePath).c_str(), std::ios::binary);
+    if (!in || !in.read((char*)&header, sizeof(header)))
+        return false;
+    if (header.Magic != TEXTURE_CACHE_MAGIC || header.Version != TEXTURE_CACHE_VERSION ||
+        (header.Format != BLOCK_BC1 && header.Format != BLOCK_BC3) || header.Levels == 0 ||
+        header.DataSize != CompressedChainBytes(header.Width, header.Height, (BlockFormat)header.Format, header.Levels))
+        return false;
+    if (!sourceMatches(imagePath, header))
+        return false;
+    data = (unsigned char*)malloc(header.DataSize);
+    if (!data)
+        return false;
+    if (!in.read((char*)data, header.DataSize))
+    {
+        free(data);
+        data = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool WriteTextureCache(const std::string &imagePath, const TextureCacheHeader &header, const unsigned char *data)
+{
+    // write to a temporary file and move it in place so readers never see a partial cache
+    std::string cachePath = TextureCachePath(imagePath);
+    std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "ERROR::TEXTURE_CACHE: Failed to create " << tempPath << std::endl;
+            return false;
+        }
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)data, header.DataSize);
+        if (!out)
+        {
+            std::cout << "ERROR::TEXTURE_CACHE: Failed to write " << tempPath << std::endl;
+            return false;
+        }
+    }
+    remove(cachePath.c_str());
+    if (rename(tempPath.c_str(), cachePath.c_str()) != 0)
+    {
+        std::cout << "ERROR::TEXTURE_CACHE: Failed to move " << tempPath << " to " << cachePath << std::endl;
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <stdint.h>
+#include <string>
+
+#include "texture_compress.h"
+
+// On-disk layout of a compressed texture (<image>.texcache, written next to the source image):
+// the header followed by the blocks of every mip level, level 0 first (DDS-like, but with the
+// source stamp so a changed image invalidates it).
+const uint32_t TEXTURE_CACHE_MAGIC = 0x43584554; // "TEXC"
+const uint32_t TEXTURE_CACHE_VERSION = 1;
+
+struct TextureCacheHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t Format;      // BlockFormat
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t Levels;
+    uint32_t Components;  // Of the source image
+    uint32_t Reserved;
+    int64_t SourceMTime;  // Source image the blocks were encoded from
+    uint64_t SourceSize;
+    uint64_t SourceHash;
+    uint64_t DataSize;    // CompressedChainBytes(Width, Height, Format, Levels)
+};
+
+// Location of the cache file belonging to imagePath
+std::string TextureCachePath(const std::string &imagePath);
+// Reads the cache of imagePath if it exists and still matches the image: fills header and
+// returns its blocks in data (malloc'ed, free with free), false if there is no usable cache
+bool ReadTextureCache(const std::string &imagePath, TextureCacheHeader &header, unsigned char *&data);
+// Writes the cache of imagePath (source stamp in header filled in by the caller)
+bool WriteTextureCache(const std::string &imagePath, const TextureCacheHeader &header, const unsigned char *data);
+
+#endif
@@ -0,0 +1,229 @@
+#include <cmath>
+#include <cstdlib>
+
+#include "texture_compress.h"
+
+
+namespace {
+
+// Power iterations finding the principal axis of a block's colors
+const int AXIS_ITERATIONS = 4;
+
+unsigned short pack565(const float *color)
+{
+    int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+    int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+    int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+    r = r < 0 ? 0 : r > 31 ? 31 : r;
+    g = g < 0 ? 0 : g > 63 ? 63 : g;
+    b = b < 0 ? 0 : b > 31 ? 31 : b;
+    return (unsigned short)((r << 11) | (g << 5) | b);
+}
+
+// Expands a 565 color the way the GPU does (replicating the high bits)
+void unpack565(unsigned short packed, int *color)
+{
+    int r = packed >> 11, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// BC1 color block (also the second half of BC3): endpoints at the extremes of the colors along
+// their principal axis, inset by 1/16 of the range to cut the error of the outermost texels
+void compressColor(const unsigned char *rgba, unsigned char *out)
+{
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 3; ++c)
+            mean[c] += rgba[i * 4 + c];
+    for (int c = 0; c < 3; ++c)
+        mean[c] /= 16.0f;
+    // covariance: xx, xy, xz, yy, yz, zz
+    float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i)
+    {
+        float r = rgba[i * 4] - mean[0], g = rgba[i * 4 + 1] - mean[1], b = rgba[i * 4 + 2] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < AXIS_ITERATIONS; ++iteration)
+    {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float largest = fmaxf(fabsf(x), fmaxf(fabsf(y), fabsf(z)));
+        if (largest < 1e-6f)
+            break; // flat block, any axis does
+        axis[0] = x / largest;
+        axis[1] = y / largest;
+        axis[2] = z / largest;
+    }
+    int lowest = 0, highest = 0;
+    float minDot = 1e30f, maxDot = -1e30f;
+    for (int i = 0; i < 16; ++i)
+    {
+        float dot = rgba[i * 4] * axis[0] + rgba[i * 4 + 1] * axis[1] + rgba[i * 4 + 2] * axis[2];
+        if (dot < minDot) { minDot = dot; lowest = i; }
+        if (dot > maxDot) { maxDot = dot; highest = i; }
+    }
+    float high[3], low[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        float inset = (rgba[highest * 4 + c] - rgba[lowest * 4 + c]) / 16.0f;
+        high[c] = rgba[highest * 4 + c] - inset;
+        low[c] = rgba[lowest * 4 + c] + inset;
+    }
+    unsigned short color0 = pack565(high), color1 = pack565(low);
+    // color0 > color1 selects the four color mode
+    if (color0 < color1)
+    {
+        unsigned short swap = color0;
+        color0 = color1;
+        color1 = swap;
+    }
+    unsigned int indices = 0;
+    if (color0 != color1)
+    {
+        int palette[4][3];
+        unpack565(color0, palette[0]);
+        unpack565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0, bestDistance = 1 << 30;
+            for (int p = 0; p < 4; ++p)
+            {
+                int dr = rgba[i * 4] - palette[p][0], dg = rgba[i * 4 + 1] - palette[p][1], db = rgba[i * 4 + 2] - palette[p][2];
+                int distance = dr * dr + dg * dg + db * db;
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= (unsigned int)best << (2 * i);
+        }
+    }
+    out[0] = (unsigned char)(color0 & 0xFF);
+    out[1] = (unsigned char)(color0 >> 8);
+    out[2] = (unsigned char)(color1 & 0xFF);
+    out[3] = (unsigned char)(color1 >> 8);
+    for (int i = 0; i < 4; ++i)
+        out[4 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+// BC3 alpha block: the extremes as endpoints with six interpolated values between them
+void compressAlpha(const unsigned char *rgba, unsigned char *out)
+{
+    int alpha0 = 0, alpha1 = 255;
+    for (int i = 0; i < 16; ++i)
+    {
+        int a = rgba[i * 4 + 3];
+        alpha0 = a > alpha0 ? a : alpha0;
+        alpha1 = a < alpha1 ? a : alpha1;
+    }
+    out[0] = (unsigned char)alpha0;
+    out[1] = (unsigned char)alpha1;
+    unsigned long long indices = 0;
+    if (alpha0 != alpha1)
+    {
+        // alpha0 > alpha1 selects the eight value mode
+        int palette[8] = { alpha0, alpha1 };
+        for (int p = 2; p < 8; ++p)
+            palette[p] = ((8 - p) * alpha0 + (p - 1) * alpha1) / 7;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0, bestDistance = 256;
+            for (int p = 0; p < 8; ++p)
+            {
+                int distance = abs(rgba[i * 4 + 3] - palette[p]);
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= (unsigned long long)best << (3 * i);
+        }
+    }
+    for (int i = 0; i < 6; ++i)
+        out[2 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+} // namespace
+
+size_t BlockBytes(BlockFormat format)
+{
+    return format == BLOCK_BC1 ? 8 : format == BLOCK_BC3 ? 16 : 0;
+}
+
+size_t CompressedLevelBytes(unsigned int width, unsigned int height, BlockFormat format, unsigned int level)
+{
+    size_t levelWidth = (width >> level) ? (width >> level) : 1, levelHeight = (height >> level) ? (height >> level) : 1;
+    return ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * BlockBytes(format);
+}
+
+size_t CompressedChainBytes(unsigned int width, unsigned int height, BlockFormat format, unsigned int levels)
+{
+    size_t bytes = 0;
+    for (unsigned int level = 0; level < levels; ++level)
+        bytes += CompressedLevelBytes(width, height, format, level);
+    return bytes;
+}
+
+BlockFormat ChooseBlockFormat(const unsigned char *pixels, unsigned int width, unsigned int height, unsigned int components)
+{
+    if (components != 2 && components != 4)
+        return BLOCK_BC1;
+    size_t count = (size_t)width * height;
+    for (size_t i = 0; i < count; ++i)
+        if (pixels[i * components + components - 1] != 255)
+            return BLOCK_BC3;
+    return BLOCK_BC1;
+}
+
+void CompressBlockBC1(const unsigned char *rgba, unsigned char *out)
+{
+    compressColor(rgba, out);
+}
+
+void CompressBlockBC3(const unsigned char *rgba, unsigned char *out)
+{
+    compressAlpha(rgba, out);
+    compressColor(rgba, out + 8);
+}
+
+void CompressBlockRow(const unsigned char *pixels, unsigned int width, unsigned int height, unsigned int components,
+    BlockFormat format, unsigned int blockRow, unsigned char *out)
+{
+    unsigned int blocksWide = (width + 3) / 4;
+    size_t blockBytes = BlockBytes(format);
+    out += (size_t)blockRow * blocksWide * blockBytes;
+    unsigned char block[64];
+    for (unsigned int bx = 0; bx < blocksWide; ++bx)
+    {
+        for (unsigned int i = 0; i < 16; ++i)
+        {
+            unsigned int x = bx * 4 + i % 4, y = blockRow * 4 + i / 4;
+            x = x < width ? x : width - 1;
+            y = y < height ? y : height - 1;
+            const unsigned char *texel = pixels + ((size_t)y * width + x) * components;
+            unsigned char *rgba = block + i * 4;
+            // grey (and grey-alpha) images spread over all three color channels
+            rgba[0] = texel[0];
+            rgba[1] = components >= 3 ? texel[1] : texel[0];
+            rgba[2] = components >= 3 ? texel[2] : texel[0];
+            rgba[3] = components == 2 ? texel[1] : components == 4 ? texel[3] : 255;
+        }
+        if (format == BLOCK_BC3)
+            CompressBlockBC3(block, out + bx * blockBytes);
+        else
+            CompressBlockBC1(block, out + bx * blockBytes);
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef TEXTURE_COMPRESS_H
+#define TEXTURE_COMPRESS_H
+
+#include <cstddef>
+
+// Block compressed formats the encoder produces, 4x4 texels per block
+enum BlockFormat
+{
+    BLOCK_NONE = 0, // Uncompressed pixels
+    BLOCK_BC1 = 1,  // 8 bytes per block, opaque color (DXT1)
+    BLOCK_BC3 = 2   // 16 bytes per block, color plus interpolated alpha (DXT5)
+};
+
+// Bytes per 4x4 block of format
+size_t BlockBytes(BlockFormat format);
+// Bytes of mip level of a width x height image in format, partial blocks padded
+size_t CompressedLevelBytes(unsigned int width, unsigned int height, BlockFormat format, unsigned int level);
+// Bytes of the first levels of the chain, stored back to back
+size_t CompressedChainBytes(unsigned int width, unsigned int height, BlockFormat format, unsigned int levels);
+// BC1 for images without (or with fully opaque) alpha, BC3 otherwise
+BlockFormat ChooseBlockFormat(const unsigned char *pixels, unsigned int width, unsigned int height, unsigned int components);
+// Encodes a 4x4 block of RGBA texels (row by row) to BC1
+void CompressBlockBC1(const unsigned char *rgba, unsigned char *out);
+// Encodes a 4x4 block of RGBA texels (row by row) to BC3
+void CompressBlockBC3(const unsigned char *rgba, unsigned char *out);
+// Encodes block row blockRow of a width x height image with components channels (1 to 4,
+// rows tightly packed) to out, the start of the level's blocks. Texels past the edge repeat
+// the last row and column. Rows are independent, so they can be encoded concurrently.
+void CompressBlockRow(const unsigned char *pixels, unsigned int width, unsigned int height, unsigned int components,
+    BlockFormat format, unsigned int blockRow, unsigned char *out);
+
+#endif
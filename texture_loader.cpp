@@ -0,0 +1,148 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+#include "mapped_file.h"
+#include "mipmap.h"
+#include "stb_image.h"
+#include "texture_cache.h"
+#include "texture_loader.h"
+
+
+// An image whose block rows are encoded by separate tasks, the last one to finish publishes it
+struct CompressJob
+{
+    DecodedImage *Image;
+    unsigned char *Pixels; // Mip chain being encoded
+    unsigned char *Blocks;
+    TextureCacheHeader Header;
+    std::atomic<unsigned int> Remaining;
+};
+
+static void finishCompression(CompressJob &job)
+{
+    stbi_image_free(job.Pixels);
+    job.Image->Data = job.Blocks;
+    job.Image->Format = (BlockFormat)job.Header.Format;
+    WriteTextureCache(job.Image->Path, job.Header, job.Blocks);
+}
+
+// Queues a task per block row of every level of image (pixels and mip chain in Data) on pool
+static void compressImage(DecodedImage *image, const MappedFile &source, ThreadPool &pool)
+{
+    std::shared_ptr<CompressJob> job = std::make_shared<CompressJob>();
+    job->Image = image;
+    job->Pixels = image->Data;
+    TextureCacheHeader &header = job->Header;
+    header.Magic = TEXTURE_CACHE_MAGIC;
+    header.Version = TEXTURE_CACHE_VERSION;
+    header.Format = ChooseBlockFormat(image->Data, image->Width, image->Height, image->Components);
+    header.Width = image->Width;
+    header.Height = image->Height;
+    header.Levels = image->Levels;
+    header.Components = image->Components;
+    header.Reserved = 0;
+    StatFile(image->Path, header.SourceMTime, header.SourceSize);
+    header.SourceHash = HashBytes(source.Data(), source.Size());
+    header.DataSize = CompressedChainBytes(header.Width, header.Height, (BlockFormat)header.Format, header.Levels);
+    job->Blocks = (unsigned char*)malloc(header.DataSize);
+    if (!job->Blocks)
+    {
+        std::cout << "Texture failed to compress at path: " << image->Path << std::endl;
+        return;
+    }
+    // the image stays uncompressed until every row is done
+    unsigned int rows = 0;
+    for (unsigned int level = 0; level < header.Levels; ++level)
+        rows += (MipLevelSize(header.Height, level) + 3) / 4;
+    job->Remaining = rows;
+    size_t pixelOffset = 0, blockOffset = 0;
+    for (unsigned int level = 0; level < header.Levels; ++level)
+    {
+        unsigned int width = MipLevelSize(header.Width, level), height = MipLevelSize(header.Height, level);
+        for (unsigned int row = 0; row < (height + 3) / 4; ++row)
+        {
+            pool.Submit([job, width, height, row, pixelOffset, blockOffset]()
+            {
+                CompressBlockRow(job->Pixels + pixelOffset, width, height, job->Header.Components, (BlockFormat)job->Header.Format,
+                    row, job->Blocks + blockOffset);
+                if (--job->Remaining == 0)
+                    finishCompression(*job);
+            });
+        }
+        pixelOffset += MipLevelBytes(header.Width, header.Height, header.Components, level);
+        blockOffset += CompressedLevelBytes(header.Width, header.Height, (BlockFormat)header.Format, level);
+    }
+}
+
+static void decodeImage(DecodedImage *image, unsigned int flags, ThreadPool &pool)
+{
+    if (flags & TEXTURE_COMPRESS)
+    {
+        // decode-free path: the blocks of an earlier load
+        TextureCacheHeader header;
+        unsigned char *blocks = NULL;
+        if (ReadTextureCache(image->Path, header, blocks))
+        {
+            image->Width = header.Width;
+            image->Height = header.Height;
+            image->Components = header.Components;
+            image->Levels = header.Levels;
+            image->Format = (BlockFormat)header.Format;
+            image->Cached = true;
+            image->Data = blocks;
+            return;
+        }
+    }
+    MappedFile file;
+    if (!file.Open(image->Path))
+    {
+        std::cout << "Texture failed to load at path: " << image->Path << std::endl;
+        return;
+    }
+    image->Data = stbi_load_from_memory((const stbi_uc*)file.Data(), (int)file.Size(), &image->Width, &image->Height, &image->Components, 0);
+    if (!image->Data)
+    {
+        std::cout << "Texture failed to decode at path: " << image->Path << std::endl;
+        return;
+    }
+    if (!(flags & (TEXTURE_MIPMAPS | TEXTURE_COMPRESS)))
+        return;
+    unsigned int levels = MipLevelCount(image->Width, image->Height);
+    if (!GenerateMipChain(image->Data, image->Width, image->Height, image->Components, levels, true))
+    {
+        std::cout << "Texture mip levels failed to generate for path: " << image->Path << std::endl;
+        return;
+    }
+    image->Levels = levels;
+    if (flags & TEXTURE_COMPRESS)
+        compressImage(image, file, pool);
+}
+
+void DecodeImages(const std::vector<std::string> &paths, std::vector<DecodedImage> &images, ThreadPool &pool, unsigned int flags)
+{
+    images.resize(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        DecodedImage *image = &images[i];
+        image->Path = paths[i];
+        image->Width = image->Height = image->Components = 0;
+        image->Levels = 1;
+        image->Format = BLOCK_NONE;
+        image->Cached = false;
+        image->Data = NULL;
+        ThreadPool *workers = &pool;
+        pool.Submit([image, flags, workers]() { decodeImage(image, flags, *workers); });
+    }
+}
+
+void FreeImages(std::vector<DecodedImage> &images)
+{
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        if (images[i].Data)
+            stbi_image_free(images[i].Data);
+        images[i].Data = NULL;
+    }
+}
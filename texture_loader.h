@@ -0,0 +1,37 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <string>
+#include <vector>
+
+#include "texture_compress.h"
+#include "thread_pool.h"
+
+// What DecodeImages does to the images after decoding them
+enum TextureLoadFlags
+{
+    TEXTURE_MIPMAPS = 1, // Append the full mip chain, filtered as sRGB color
+    TEXTURE_COMPRESS = 2 // Encode the mip chain to BC1 or BC3, through the texture cache
+};
+
+// An image decoded by stb_image (or read from the texture cache), owned until FreeImages
+struct DecodedImage
+{
+    std::string Path;
+    int Width, Height, Components;
+    unsigned int Levels; // Mip levels in Data, back to back (see mipmap.h)
+    BlockFormat Format;  // BLOCK_NONE for pixels, otherwise Data holds the blocks of every level
+    bool Cached;         // Blocks read from the texture cache, nothing was decoded
+    unsigned char *Data; // NULL if the file is missing or could not be decoded
+};
+
+// Queues the decoding of every image in paths on pool, images is resized to match and filled
+// as the tasks finish: each task maps its file and runs stbi_load_from_memory, so only the GL
+// upload is left for the context thread. flags (TextureLoadFlags) add the mip chain and block
+// compression, the latter runs as one task per block row, and a fresh cache skips decoding
+// altogether. Call pool.Wait() before reading images.
+void DecodeImages(const std::vector<std::string> &paths, std::vector<DecodedImage> &images, ThreadPool &pool, unsigned int flags = 0);
+// Releases the pixel data of images
+void FreeImages(std::vector<DecodedImage> &images);
+
+#endif
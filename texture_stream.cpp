@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "mipmap.h"
+#include "texture_stream.h"
+
+
+// Fresh texture object with the formats and sampling settings of texture
+static Texture2D copySettings(const Texture2D &texture)
+{
+    Texture2D copy;
+    GLuint id = copy.ID;
+    copy = texture;
+    copy.ID = id;
+    return copy;
+}
+
+TextureStreamer::TextureStreamer(TextureUploader *uploader, size_t budget)
+    : Budget(budget), uploader(uploader), frame(0)
+{
+    memset(&this->Stats, 0, sizeof(this->Stats));
+}
+
+unsigned int TextureStreamer::Add(Texture2D &texture, DecodedImage &image)
+{
+    Streamed streamed;
+    // the staging texture gets its object when a promotion starts
+    glDeleteTextures(1, &streamed.Staging.ID);
+    streamed.Staging.ID = 0;
+    streamed.Texture = &texture;
+    streamed.Image = image;
+    image.Data = NULL;
+    streamed.Tail = 0;
+    while (streamed.Tail + 1 < image.Levels &&
+        std::max(MipLevelSize(image.Width, streamed.Tail), MipLevelSize(image.Height, streamed.Tail)) > TEXTURE_STREAM_TAIL_SIZE)
+        streamed.Tail++;
+    streamed.Resident = streamed.Wanted = streamed.Tail;
+    streamed.Loading = image.Levels;
+    streamed.LastUsed = this->frame;
+    this->textures.push_back(streamed);
+    this->generate(this->textures.back(), texture, streamed.Tail, false);
+    this->Stats.ResidentBytes += this->chainBytes(streamed, streamed.Tail);
+    return (unsigned int)this->textures.size() - 1;
+}
+
+GLuint TextureStreamer::Size(unsigned int handle) const
+{
+    const DecodedImage &image = this->textures[handle].Image;
+    return (GLuint)std::max(image.Width, image.Height);
+}
+
+void TextureStreamer::Request(unsigned int handle, GLuint level)
+{
+    Streamed &streamed = this->textures[handle];
+    level = std::min(level, streamed.Tail);
+    if (streamed.LastUsed != this->frame)
+        streamed.Wanted = level;
+    else
+        streamed.Wanted = std::min(streamed.Wanted, level);
+    streamed.LastUsed = this->frame;
+}
+
+void TextureStreamer::Update()
+{
+    // swap in the textures whose upload finished
+    for (unsigned int i = 0; i < this->textures.size(); ++i)
+    {
+        Streamed &streamed = this->textures[i];
+        if (streamed.Loading < streamed.Image.Levels && streamed.Staging.Resident())
+        {
+            this->swap(streamed, streamed.Staging, streamed.Loading);
+            this->Stats.Promotions++;
+        }
+    }
+    // start the largest jumps in resolution first
+    std::vector<Streamed*> requests;
+    for (unsigned int i = 0; i < this->textures.size(); ++i)
+    {
+        Streamed &streamed = this->textures[i];
+        if (streamed.LastUsed == this->frame && streamed.Wanted < streamed.Resident && streamed.Loading == streamed.Image.Levels)
+            requests.push_back(&streamed);
+    }
+    std::sort(requests.begin(), requests.end(), [](const Streamed *a, const Streamed *b) { return a->Resident - a->Wanted > b->Resident - b->Wanted; });
+    size_t frameBudget = this->uploader ? (size_t)this->uploader->BytesPerFrame : (size_t)TEXTURE_UPLOAD_FRAME_BUDGET;
+    size_t started = 0;
+    for (unsigned int i = 0; i < requests.size(); ++i)
+    {
+        size_t bytes = this->chainBytes(*requests[i], requests[i]->Wanted);
+        if (started > 0 && started + bytes > frameBudget)
+            break;
+        if (!this->promote(*requests[i], this->uploader != NULL))
+            break;
+        started += bytes;
+    }
+    this->Stats.Pending = 0;
+    for (unsigned int i = 0; i < this->textures.size(); ++i)
+    {
+        const Streamed &streamed = this->textures[i];
+        if (streamed.Loading < streamed.Image.Levels || (streamed.LastUsed == this->frame && streamed.Wanted < streamed.Resident))
+            this->Stats.Pending++;
+    }
+    this->frame++;
+}
+
+void TextureStreamer::Finish()
+{
+    if (this->uploader)
+        this->uploader->Finish();
+    for (unsigned int i = 0; i < this->textures.size(); ++i)
+    {
+        Streamed &streamed = this->textures[i];
+        if (streamed.Loading < streamed.Image.Levels)
+        {
+            this->swap(streamed, streamed.Staging, streamed.Loading);
+            this->Stats.Promotions++;
+        }
+    }
+    this->Stats.Pending = 0;
+    for (unsigned int i = 0; i < this->textures.size(); ++i)
+    {
+        Streamed &streamed = this->textures[i];
+        if (streamed.LastUsed == this->frame && streamed.Wanted < streamed.Resident && !this->promote(streamed, false))
+            this->Stats.Pending++;
+    }
+    this->frame++;
+}
+
+size_t TextureStreamer::chainBytes(const Streamed &streamed, GLuint level) const
+{
+    const DecodedImage &image = streamed.Image;
+    size_t bytes = 0;
+    for (GLuint i = level; i < image.Levels; ++i)
+        bytes += image.Format != BLOCK_NONE ? CompressedLevelBytes(image.Width, image.Height, image.Format, i)
+            : MipLevelBytes(image.Width, image.Height, image.Components, i);
+    return bytes;
+}
+
+void TextureStreamer::generate(Streamed &streamed, Texture2D &texture, GLuint level, bool async)
+{
+    const DecodedImage &image = streamed.Image;
+    // the levels from level on are the end of the chain
+    size_t bytes = this->chainBytes(streamed, level);
+    unsigned char *data = image.Data + (this->chainBytes(streamed, 0) - bytes);
+    GLuint width = MipLevelSize(image.Width, level), height = MipLevelSize(image.Height, level);
+    if (async)
+    {
+        // the uploader takes over (and frees) what it uploads
+        unsigned char *copy = (unsigned char*)malloc(bytes);
+        memcpy(copy, data, bytes);
+        texture.GenerateAsync(width, height, image.Levels - level, copy, *this->uploader);
+        return;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    texture.Generate(width, height, image.Levels - level, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TextureStreamer::swap(Streamed &streamed, Texture2D &texture, GLuint level)
+{
+    this->Stats.ResidentBytes -= this->chainBytes(streamed, streamed.Resident);
+    glDeleteTextures(1, &streamed.Texture->ID);
+    GLuint placeholder = streamed.Texture->Placeholder;
+    *streamed.Texture = texture;
+    streamed.Texture->State = TEXTURE_RESIDENT;
+    streamed.Texture->Placeholder = placeholder;
+    streamed.Resident = level;
+    if (&texture == &streamed.Staging)
+    {
+        // the staging bytes were counted when the promotion started
+        streamed.Staging.ID = 0;
+        streamed.Loading = streamed.Image.Levels;
+    }
+    else
+        this->Stats.ResidentBytes += this->chainBytes(streamed, level);
+}
+
+bool TextureStreamer::makeRoom(size_t bytes)
+{
+    while (this->Stats.ResidentBytes + bytes > this->Budget)
+    {
+        // textures not requested this frame fall back to their tail, requested ones to what they asked for
+        Streamed *victim = NULL;
+        GLuint victimLevel = 0;
+        for (unsigned int i = 0; i < this->textures.size(); ++i)
+        {
+            Streamed &streamed = this->textures[i];
+            GLuint level = streamed.LastUsed == this->frame ? streamed.Wanted : streamed.Tail;
+            if (streamed.Loading == streamed.Image.Levels && streamed.Resident < level && (!victim || streamed.LastUsed < victim->LastUsed))
+            {
+                victim = &streamed;
+                victimLevel = level;
+            }
+        }
+        if (!victim)
+            return false;
+        Texture2D smaller = copySettings(*victim->Texture);
+        this->generate(*victim, smaller, victimLevel, false);
+        this->swap(*victim, smaller, victimLevel);
+        this->Stats.Evictions++;
+    }
+    return true;
+}
+
+bool TextureStreamer::promote(Streamed &streamed, bool async)
+{
+    // the current texture stays resident until the new one replaces it: settle for coarser
+    // levels if the wanted ones don't fit next to it
+    GLuint level = streamed.Wanted;
+    while (level < streamed.Resident && !this->makeRoom(this->chainBytes(streamed, level)))
+        level++;
+    if (level >= streamed.Resident)
+        return false;
+    streamed.Staging = copySettings(*streamed.Texture);
+    streamed.Loading = level;
+    this->Stats.ResidentBytes += this->chainBytes(streamed, level);
+    this->generate(streamed, streamed.Staging, level, async);
+    if (!async)
+    {
+        this->swap(streamed, streamed.Staging, level);
+        this->Stats.Promotions++;
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+#ifndef TEXTURE_STREAM_H
+#define TEXTURE_STREAM_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <deque>
+
+#include "texture.h"
+#include "texture_loader.h"
+#include "texture_upload.h"
+
+// Bytes the streamed textures may take in video memory before the least recently used are evicted
+const size_t TEXTURE_STREAM_BUDGET = 32 << 20;
+// Largest level (in pixels) of the mip tail every texture starts with and never drops below
+const GLuint TEXTURE_STREAM_TAIL_SIZE = 64;
+
+// Counters of a TextureStreamer, the byte counts as of the last Update
+struct TextureStreamStats
+{
+    size_t ResidentBytes;    // Video memory of all streamed textures, staging copies included
+    unsigned int Pending;    // Textures waiting for (or uploading) finer levels
+    unsigned int Promotions; // Finer levels made resident, since construction
+    unsigned int Evictions;  // Textures dropped to coarser levels for the budget, since construction
+};
+
+// Keeps the mip chains of textures in memory and only gives their GL textures the levels
+// the current view needs. Textures start with their mip tail; Request asks for a finer
+// level, Update reallocates the texture at that resolution (its levels are a suffix of the
+// chain, so the data uploads as is) through the uploader's pixel buffers while draws keep
+// sampling the current one, and swaps it in once resident. Over the budget, textures not
+// requested for the longest drop back to their tail (or to what they were last asked for).
+class TextureStreamer
+{
+public:
+    size_t Budget; // TEXTURE_STREAM_BUDGET by default
+    TextureStreamStats Stats;
+    // Constructor, uploads synchronously without an uploader
+    TextureStreamer(TextureUploader *uploader = NULL, size_t budget = TEXTURE_STREAM_BUDGET);
+    // Takes over the chain of image and generates texture (formats and filtering already set)
+    // with its mip tail. texture must stay at its address. Returns the handle for Request.
+    unsigned int Add(Texture2D &texture, DecodedImage &image);
+    // Full size of the streamed texture, Width and Height of the texture itself shrink with it
+    GLuint Size(unsigned int handle) const;
+    // Asks for levels from level on to be resident, the finest request of a frame wins
+    void Request(unsigned int handle, GLuint level);
+    // Swaps in finished textures, evicts over the budget and starts the uploads of this
+    // frame's requests (the first of them always, more if the uploader has budget left)
+    void Update();
+    // Makes every request of the frame resident right away (deterministic headless runs)
+    void Finish();
+private:
+    struct Streamed
+    {
+        Texture2D *Texture;   // Drawn by the model, levels Resident.. of the chain
+        Texture2D Staging;    // Levels Loading.. while their upload is in flight
+        DecodedImage Image;   // The whole chain
+        GLuint Tail;          // Coarsest level ever kept resident
+        GLuint Resident, Loading, Wanted; // Loading is Image.Levels when nothing loads
+        unsigned long long LastUsed;      // Frame of the last request
+    };
+    std::deque<Streamed> textures;
+    TextureUploader *uploader;
+    unsigned long long frame;
+    // Video memory of levels from level on
+    size_t chainBytes(const Streamed &streamed, GLuint level) const;
+    // Generates a copy of the texture settings of streamed at level, uploaded from the chain
+    // synchronously or queued on the uploader
+    void generate(Streamed &streamed, Texture2D &texture, GLuint level, bool async);
+    // Replaces the drawn texture of streamed with texture, holding levels from level on
+    void swap(Streamed &streamed, Texture2D &texture, GLuint level);
+    // Drops least recently used textures to their tail until bytes more fit the budget,
+    // false if even that is not enough
+    bool makeRoom(size_t bytes);
+    // Starts loading the wanted levels of streamed if they fit, false if the budget is exhausted
+    bool promote(Streamed &streamed, bool async);
+};
+
+#endif
@@ -0,0 +1,191 @@
+#include <cstring>
+#include <iostream>
+
+#include "gl_ext.h"
+#include "stb_image.h"
+#include "texture_upload.h"
+
+
+// Ring offsets stay aligned for any pixel type
+const GLsizeiptr UPLOAD_ALIGNMENT = 64;
+
+// Size of all levels of texture, rows tightly packed
+static GLsizeiptr imageBytes(const Texture2D &texture)
+{
+    GLsizeiptr bytes = 0;
+    for (GLuint level = 0; level < texture.Levels; ++level)
+        bytes += (GLsizeiptr)texture.LevelBytes(level);
+    return bytes;
+}
+
+// Uploads every level of texture from pixels (levels back to back), an offset into the bound pixel unpack buffer if there is one
+static void uploadLevels(const Texture2D &texture, const unsigned char *pixels)
+{
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, texture.ID);
+    for (GLuint level = 0; level < texture.Levels; ++level)
+    {
+        texture.SubImage(level, pixels);
+        pixels += texture.LevelBytes(level);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+TextureUploader::TextureUploader() : ID(0), Size(0), BytesPerFrame(TEXTURE_UPLOAD_FRAME_BUDGET), Persistent(false), mapped(NULL), head(0) { }
+
+void TextureUploader::Generate(GLsizeiptr size)
+{
+    this->Size = size;
+    glGenBuffers(1, &this->ID);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->ID);
+    this->Persistent = glBufferStorage != NULL;
+    if (this->Persistent)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, NULL, flags);
+        this->mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags);
+        if (!this->mapped)
+        {
+            std::cout << "ERROR::TEXTURE_UPLOADER: persistent mapping failed, mapping per upload instead" << std::endl;
+            // buffer storage is immutable, start over with a plain buffer
+            glDeleteBuffers(1, &this->ID);
+            glGenBuffers(1, &this->ID);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->ID);
+            this->Persistent = false;
+        }
+    }
+    if (!this->Persistent)
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    unsigned char grey[] = { 128, 128, 128 };
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    this->Placeholder.Generate(1, 1, grey);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TextureUploader::Queue(Texture2D &texture, unsigned char *data)
+{
+    Upload upload;
+    upload.Texture = &texture;
+    upload.Data = data;
+    upload.Offset = 0;
+    upload.Bytes = imageBytes(texture);
+    upload.Fence = 0;
+    texture.State = TEXTURE_PENDING;
+    texture.Placeholder = this->Placeholder.ID;
+    if ((upload.Bytes + UPLOAD_ALIGNMENT - 1) / UPLOAD_ALIGNMENT * UPLOAD_ALIGNMENT > this->Size)
+    {
+        // would never fit the ring: upload from client memory right away
+        uploadLevels(texture, data);
+        stbi_image_free(data);
+        texture.State = TEXTURE_RESIDENT;
+        return;
+    }
+    this->queued.push_back(upload);
+}
+
+void TextureUploader::Update()
+{
+    this->retire(false);
+    GLsizeiptr started = 0;
+    while (!this->queued.empty() && (started == 0 || started + this->queued.front().Bytes <= this->BytesPerFrame))
+    {
+        GLsizeiptr bytes = this->queued.front().Bytes;
+        if (!this->submit())
+            break;
+        started += bytes;
+    }
+}
+
+void TextureUploader::Finish()
+{
+    while (!this->queued.empty() || !this->inFlight.empty())
+    {
+        while (!this->queued.empty() && this->submit())
+            ;
+        this->retire(true);
+    }
+}
+
+unsigned int TextureUploader::Pending() const
+{
+    return (unsigned int)(this->queued.size() + this->inFlight.size());
+}
+
+bool TextureUploader::allocate(GLsizeiptr bytes, GLsizeiptr &offset)
+{
+    bytes = (bytes + UPLOAD_ALIGNMENT - 1) / UPLOAD_ALIGNMENT * UPLOAD_ALIGNMENT;
+    if (this->inFlight.empty())
+        this->head = 0;
+    GLsizeiptr tail = this->inFlight.empty() ? this->Size : this->inFlight.front().Offset;
+    if (!this->inFlight.empty() && this->head == tail)
+        return false; // completely full
+    if (this->head < tail || this->inFlight.empty())
+    {
+        // free space runs from head to the oldest upload (or the end)
+        if (tail - this->head < bytes)
+            return false;
+        offset = this->head;
+    }
+    else if (this->Size - this->head >= bytes)
+        offset = this->head;
+    else if (tail >= bytes)
+        offset = 0; // wrap, the rest of the end stays unused this round
+    else
+        return false;
+    this->head = offset + bytes;
+    return true;
+}
+
+bool TextureUploader::submit()
+{
+    Upload upload = this->queued.front();
+    if (!this->allocate(upload.Bytes, upload.Offset))
+        return false;
+    this->queued.pop_front();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, this->ID);
+    if (this->Persistent)
+        memcpy(this->mapped + upload.Offset, upload.Data, upload.Bytes);
+    else
+    {
+        // the fences keep the range out of use, no need for the driver to synchronize
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        void *range = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, upload.Offset, upload.Bytes, flags);
+        if (range)
+        {
+            memcpy(range, upload.Data, upload.Bytes);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        else
+            glBufferSubData(GL_PIXEL_UNPACK_BUFFER, upload.Offset, upload.Bytes, upload.Data);
+    }
+    stbi_image_free(upload.Data);
+    upload.Data = NULL;
+    // with a pixel unpack buffer bound the pointer argument is an offset into it
+    uploadLevels(*upload.Texture, (const unsigned char*)upload.Offset);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    upload.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    this->inFlight.push_back(upload);
+    return true;
+}
+
+void TextureUploader::retire(bool wait)
+{
+    while (!this->inFlight.empty())
+    {
+        Upload &upload = this->inFlight.front();
+        GLuint64 timeout = wait ? 1000000000 : 0;
+        GLenum result = glClientWaitSync(upload.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        while (wait && result == GL_TIMEOUT_EXPIRED)
+            result = glClientWaitSync(upload.Fence, 0, timeout);
+        if (result == GL_TIMEOUT_EXPIRED)
+            return;
+        glDeleteSync(upload.Fence);
+        upload.Texture->State = TEXTURE_RESIDENT;
+        this->inFlight.pop_front();
+        // one wait is enough to make room, the rest retire if already done
+        wait = false;
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef TEXTURE_UPLOAD_H
+#define TEXTURE_UPLOAD_H
+
+#include <glad/glad.h>
+
+#include <deque>
+
+#include "texture.h"
+
+// Size of the pixel buffer ring, images larger than it are uploaded synchronously
+const GLsizeiptr TEXTURE_UPLOAD_RING_SIZE = 32 << 20;
+// Bytes Update starts copying per call (at least one image always goes)
+const GLsizeiptr TEXTURE_UPLOAD_FRAME_BUDGET = 8 << 20;
+
+// Streams texture images to the GPU through a ring of pixel unpack buffer memory. Queued
+// images are copied into the ring and glTexSubImage2D sources them from there, so the copy
+// to the texture happens on the GPU timeline instead of stalling the calling thread. Each
+// upload is fenced, Update marks textures resident once their fence signals and reuses the
+// ring space. Until then Texture2D::Bind binds Placeholder, so drawing never waits.
+// With GL 4.4 / ARB_buffer_storage the ring is mapped once (persistent, coherent), otherwise
+// each upload maps its range unsynchronized (the fences already keep it from being in use).
+class TextureUploader
+{
+public:
+    GLuint ID;
+    GLsizeiptr Size;
+    GLsizeiptr BytesPerFrame; // Budget of Update, TEXTURE_UPLOAD_FRAME_BUDGET by default
+    bool Persistent;          // Mapped once instead of mapped per upload
+    Texture2D Placeholder;    // 1x1 grey texture bound instead of pending ones
+    // Constructor (ring created by Generate)
+    TextureUploader();
+    // Creates the ring with size bytes and the placeholder texture
+    void Generate(GLsizeiptr size = TEXTURE_UPLOAD_RING_SIZE);
+    // Queues the image of texture, whose storage Texture2D::GenerateAsync allocated. Takes
+    // over data (stb_image memory, freed once copied into the ring). texture must stay at its
+    // address until it is resident.
+    void Queue(Texture2D &texture, unsigned char *data);
+    // Marks textures whose copy finished resident and starts copying queued images, up to
+    // BytesPerFrame. Call once per frame.
+    void Update();
+    // Starts every queued upload and waits until all textures are resident
+    void Finish();
+    // Images queued or in flight
+    unsigned int Pending() const;
+private:
+    struct Upload
+    {
+        Texture2D *Texture;
+        unsigned char *Data;  // Until copied into the ring
+        GLsizeiptr Offset, Bytes;
+        GLsync Fence;
+    };
+    std::deque<Upload> queued, inFlight; // In flight ones in ring order
+    unsigned char *mapped;
+    GLsizeiptr head;                     // Where the next allocation starts looking
+    // Finds bytes of free ring space after head (wrapping to the start), false if full
+    bool allocate(GLsizeiptr bytes, GLsizeiptr &offset);
+    // Copies the first queued image into the ring and starts its texture upload, false if
+    // the ring has no room for it yet
+    bool submit();
+    // Retires finished uploads in order, waiting for the oldest if wait is set
+    void retire(bool wait);
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "thread_pool.h"
+
+
+ThreadPool::ThreadPool(unsigned int threads)
+    : active(0), stopping(false)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+    for (unsigned int i = 0; i < threads; ++i)
+        this->workers.push_back(std::thread(&ThreadPool::run, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->taskAvailable.notify_all();
+    for (unsigned int i = 0; i < this->workers.size(); ++i)
+        this->workers[i].join();
+}
+
+void ThreadPool::Submit(const std::function<void()> &task)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->tasks.push_back(task);
+    }
+    this->taskAvailable.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (!this->tasks.empty() || this->active > 0)
+        this->tasksDone.wait(lock);
+}
+
+void ThreadPool::run()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            while (!this->stopping && this->tasks.empty())
+                this->taskAvailable.wait(lock);
+            if (this->stopping && this->tasks.empty())
+                return;
+            task = this->tasks.front();
+            this->tasks.pop_front();
+            this->active++;
+        }
+        task();
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->active--;
+            if (this->tasks.empty() && this->active == 0)
+                this->tasksDone.notify_all();
+        }
+    }
+}
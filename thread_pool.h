@@ -0,0 +1,38 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ThreadPool runs submitted tasks on a fixed set of worker threads.
+// Wait() blocks until every task submitted so far has finished.
+class ThreadPool
+{
+public:
+    // Constructor, 0 threads means one per hardware thread
+    ThreadPool(unsigned int threads = 0);
+    ~ThreadPool();
+    // Queues a task for execution on one of the workers
+    void Submit(const std::function<void()> &task);
+    // Blocks until all queued and running tasks have finished
+    void Wait();
+    // Number of worker threads
+    unsigned int Size() const { return (unsigned int)this->workers.size(); }
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()> > tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable tasksDone;
+    unsigned int active;
+    bool stopping;
+    void run();
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+};
+
+#endif
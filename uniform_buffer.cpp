@@ -0,0 +1,133 @@
+#include <cstring>
+#include <iostream>
+
+#include "gl_ext.h"
+#include "uniform_buffer.h"
+
+
+void SetDrawModel(DrawUniforms &uniforms, const glm::mat4 &model)
+{
+    uniforms.Model = model;
+    glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+    for (int column = 0; column < 3; ++column)
+        uniforms.NormalMatrix[column] = glm::vec4(normalMatrix[column], 0.0f);
+}
+
+void BindUniformBlocks(GLuint program)
+{
+    GLuint index = glGetUniformBlockIndex(program, "Frame");
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, index, FRAME_UNIFORM_BINDING);
+    index = glGetUniformBlockIndex(program, "Draw");
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, index, DRAW_UNIFORM_BINDING);
+}
+
+UniformBuffer::UniformBuffer() : ID(0), Binding(0), Size(0) { }
+
+void UniformBuffer::Generate(GLuint binding, GLsizeiptr size)
+{
+    this->Binding = binding;
+    this->Size = size;
+    glGenBuffers(1, &this->ID);
+    glBindBuffer(GL_UNIFORM_BUFFER, this->ID);
+    glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, this->ID);
+}
+
+void UniformBuffer::Update(const void *data)
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, this->ID);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, this->Size, data);
+}
+
+UniformRing::UniformRing() : ID(0), Binding(0), BlockSize(0), BlocksPerFrame(0), Persistent(false), mapped(NULL), stride(0), size(0), frame(0), block(0)
+{
+    for (unsigned int i = 0; i < UNIFORM_RING_FRAMES; ++i)
+        this->fences[i] = 0;
+}
+
+void UniformRing::Generate(GLuint binding, GLsizeiptr blockSize, unsigned int blocksPerFrame)
+{
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    this->Binding = binding;
+    this->BlockSize = blockSize;
+    this->BlocksPerFrame = blocksPerFrame;
+    this->stride = (blockSize + alignment - 1) / alignment * alignment;
+    this->size = this->stride * blocksPerFrame * UNIFORM_RING_FRAMES;
+    glGenBuffers(1, &this->ID);
+    glBindBuffer(GL_UNIFORM_BUFFER, this->ID);
+    this->Persistent = glBufferStorage != NULL;
+    if (this->Persistent)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, this->size, NULL, flags);
+        this->mapped = (unsigned char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, this->size, flags);
+        if (!this->mapped)
+        {
+            std::cout << "ERROR::UNIFORM_RING: persistent mapping failed, uploading blocks instead" << std::endl;
+            // buffer storage is immutable, start over with a plain buffer
+            glDeleteBuffers(1, &this->ID);
+            glGenBuffers(1, &this->ID);
+            glBindBuffer(GL_UNIFORM_BUFFER, this->ID);
+            this->Persistent = false;
+        }
+    }
+    if (!this->Persistent)
+        glBufferData(GL_UNIFORM_BUFFER, this->size, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformRing::BeginFrame()
+{
+    GLsync &fence = this->fences[this->frame];
+    if (fence)
+    {
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        while (result == GL_TIMEOUT_EXPIRED)
+            result = glClientWaitSync(fence, 0, 1000000000);
+        glDeleteSync(fence);
+        fence = 0;
+    }
+    this->block = 0;
+}
+
+bool UniformRing::Push(const void *block)
+{
+    GLintptr offset = this->Write(block);
+    if (offset < 0)
+        return false;
+    this->BindBlock(offset);
+    return true;
+}
+
+GLintptr UniformRing::Write(const void *block)
+{
+    if (this->block == this->BlocksPerFrame)
+    {
+        std::cout << "ERROR::UNIFORM_RING: more than " << this->BlocksPerFrame << " blocks in a frame" << std::endl;
+        return -1;
+    }
+    GLintptr offset = ((GLintptr)this->frame * this->BlocksPerFrame + this->block++) * this->stride;
+    if (this->Persistent)
+        memcpy(this->mapped + offset, block, this->BlockSize);
+    else
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, this->ID);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, this->BlockSize, block);
+    }
+    return offset;
+}
+
+void UniformRing::BindBlock(GLintptr offset)
+{
+    glBindBufferRange(GL_UNIFORM_BUFFER, this->Binding, this->ID, offset, this->BlockSize);
+}
+
+void UniformRing::EndFrame()
+{
+    this->fences[this->frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    this->frame = (this->frame + 1) % UNIFORM_RING_FRAMES;
+}
@@ -0,0 +1,90 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Binding points of the uniform blocks shared by all shaders
+const GLuint FRAME_UNIFORM_BINDING = 0;
+const GLuint DRAW_UNIFORM_BINDING = 1;
+// Frames the CPU may run ahead of the GPU before UniformRing waits
+const unsigned int UNIFORM_RING_FRAMES = 3;
+
+// std140 layout of the Frame block: camera and light, written once per frame
+struct FrameUniforms
+{
+    glm::mat4 Projection;
+    glm::mat4 View;
+    glm::vec4 ViewPosition;
+    glm::vec4 LightPosition;
+    glm::vec4 LightColor;
+};
+
+// std140 layout of the Draw block: written for every draw call
+struct DrawUniforms
+{
+    glm::mat4 Model;
+    glm::vec4 NormalMatrix[3]; // Columns of the mat3 transforming normals by Model (padded as std140 pads them)
+    glm::vec4 PositionScale;  // Decodes compact vertex positions (xyz)
+    glm::vec4 PositionOffset;
+    GLint Instanced;          // Read the per-instance matrices instead of Model
+    GLint Padding[3];
+};
+
+// Sets uniforms.Model to model and uniforms.NormalMatrix to its inverse transpose
+void SetDrawModel(DrawUniforms &uniforms, const glm::mat4 &model);
+// Binds the Frame and Draw blocks of program, where it has them, to their binding points
+void BindUniformBlocks(GLuint program);
+
+// A uniform buffer bound once to a fixed binding point, updated whole
+class UniformBuffer
+{
+public:
+    GLuint ID;
+    GLuint Binding;
+    GLsizeiptr Size;
+    // Constructor (buffer created by Generate)
+    UniformBuffer();
+    // Creates the buffer with size bytes and binds it to binding
+    void Generate(GLuint binding, GLsizeiptr size);
+    // Replaces the contents of the buffer with Size bytes from data
+    void Update(const void *data);
+};
+
+// Ring of per draw uniform blocks. Every Push writes the next block and binds it to the
+// binding point with glBindBufferRange, so a draw costs one range bind instead of a
+// glGetUniformLocation and glUniform* per uniform. The buffer holds UNIFORM_RING_FRAMES
+// frames of blocks, a fence per frame keeps the CPU from overwriting blocks still in use.
+// With GL 4.4 / ARB_buffer_storage the buffer is mapped once (persistent, coherent) and
+// blocks are written with memcpy, otherwise each block is uploaded with glBufferSubData.
+class UniformRing
+{
+public:
+    GLuint ID;
+    GLuint Binding;
+    GLsizeiptr BlockSize;        // Bytes per block
+    unsigned int BlocksPerFrame;
+    bool Persistent;             // Mapped once instead of uploaded per block
+    // Constructor (buffer created by Generate)
+    UniformRing();
+    // Creates the ring for blocksPerFrame blocks of blockSize bytes per frame
+    void Generate(GLuint binding, GLsizeiptr blockSize, unsigned int blocksPerFrame);
+    // Starts the next frame, waits until the GPU is done with its blocks
+    void BeginFrame();
+    // Writes block (BlockSize bytes) and binds it for the following draws, returns false
+    // (and leaves the binding alone) when the frame ran out of blocks
+    bool Push(const void *block);
+    // Writes block without binding it, returns its offset for BindBlock (-1 if the frame ran out of blocks)
+    GLintptr Write(const void *block);
+    // Binds the block written at offset for the following draws
+    void BindBlock(GLintptr offset);
+    // Ends the frame, fencing its blocks
+    void EndFrame();
+private:
+    unsigned char *mapped;
+    GLsizeiptr stride, size;   // Block size rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, whole buffer
+    GLsync fences[UNIFORM_RING_FRAMES];
+    unsigned int frame, block;
+};
+
+#endif
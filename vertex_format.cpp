@@ -0,0 +1,178 @@
+#include <cmath>
+#include <cstring>
+
+#include "vertex_format.h"
+
+
+namespace {
+
+unsigned short quantizeUnorm16(float value, float offset, float scale)
+{
+    float t = scale > 0.0f ? (value - offset) / scale : 0.0f;
+    t = t < 0.0f ? 0.0f : t > 1.0f ? 1.0f : t;
+    return (unsigned short)(t * 65535.0f + 0.5f);
+}
+
+int quantizeSnorm10(float value)
+{
+    value = value < -1.0f ? -1.0f : value > 1.0f ? 1.0f : value;
+    return (int)floorf(value * 511.0f + 0.5f);
+}
+
+// Decoding as in GL 4.2+ (and what current drivers do in 3.3 contexts too): max(c / 511, -1)
+float decodeSnorm10(unsigned int bits)
+{
+    int c = (int)(bits & 0x3FF);
+    if (c >= 512)
+        c -= 1024;
+    float value = c / 511.0f;
+    return value < -1.0f ? -1.0f : value;
+}
+
+void encodeVertex(const MeshVertex &vertex, const glm::vec3 &scale, const glm::vec3 &offset, CompactVertex &compact)
+{
+    for (int k = 0; k < 3; ++k)
+        compact.Position[k] = quantizeUnorm16(vertex.Position[k], offset[k], scale[k]);
+    compact.Padding = 0;
+    glm::vec3 normal = vertex.Normal;
+    float length = glm::length(normal);
+    if (length > 0.0f)
+        normal /= length;
+    compact.Normal = ((unsigned int)quantizeSnorm10(normal.x) & 0x3FF) |
+        (((unsigned int)quantizeSnorm10(normal.y) & 0x3FF) << 10) |
+        (((unsigned int)quantizeSnorm10(normal.z) & 0x3FF) << 20);
+    compact.TexCoords[0] = FloatToHalf(vertex.TexCoords.x);
+    compact.TexCoords[1] = FloatToHalf(vertex.TexCoords.y);
+}
+
+MeshVertex decodeVertex(const CompactVertex &compact, const glm::vec3 &scale, const glm::vec3 &offset)
+{
+    MeshVertex vertex;
+    for (int k = 0; k < 3; ++k)
+        vertex.Position[k] = compact.Position[k] / 65535.0f * scale[k] + offset[k];
+    vertex.Normal = glm::vec3(decodeSnorm10(compact.Normal), decodeSnorm10(compact.Normal >> 10), decodeSnorm10(compact.Normal >> 20));
+    vertex.TexCoords = glm::vec2(HalfToFloat(compact.TexCoords[0]), HalfToFloat(compact.TexCoords[1]));
+    return vertex;
+}
+
+} // namespace
+
+QuantizationStats QuantizeMesh(MeshData &mesh, const QuantizationOptions &options)
+{
+    QuantizationStats stats;
+    stats.PositionError = stats.PositionRelative = stats.NormalError = stats.TexCoordError = 0.0f;
+    stats.Compact = false;
+    mesh.Format = VERTEX_FORMAT_FLOAT;
+    mesh.PositionScale = glm::vec3(1.0f);
+    mesh.PositionOffset = glm::vec3(0.0f);
+    if (mesh.Vertices.empty())
+        return stats;
+
+    glm::vec3 lower = mesh.Vertices[0].Position, upper = lower;
+    for (size_t i = 1; i < mesh.Vertices.size(); ++i)
+    {
+        lower = glm::min(lower, mesh.Vertices[i].Position);
+        upper = glm::max(upper, mesh.Vertices[i].Position);
+    }
+    glm::vec3 scale = upper - lower;
+    float extent = glm::max(scale.x, glm::max(scale.y, scale.z));
+
+    float cosNormalError = 1.0f;
+    for (size_t i = 0; i < mesh.Vertices.size(); ++i)
+    {
+        const MeshVertex &vertex = mesh.Vertices[i];
+        CompactVertex compact;
+        encodeVertex(vertex, scale, lower, compact);
+        MeshVertex decoded = decodeVertex(compact, scale, lower);
+        stats.PositionError = glm::max(stats.PositionError, glm::length(decoded.Position - vertex.Position));
+        float length = glm::length(vertex.Normal) * glm::length(decoded.Normal);
+        if (length > 0.0f)
+            cosNormalError = glm::min(cosNormalError, glm::dot(vertex.Normal, decoded.Normal) / length);
+        glm::vec2 uvError = glm::abs(decoded.TexCoords - vertex.TexCoords);
+        stats.TexCoordError = glm::max(stats.TexCoordError, glm::max(uvError.x, uvError.y));
+    }
+    stats.PositionRelative = extent > 0.0f ? stats.PositionError / extent : 0.0f;
+    stats.NormalError = acosf(glm::clamp(cosNormalError, -1.0f, 1.0f)) * 180.0f / 3.14159265f;
+
+    stats.Compact = stats.PositionRelative <= options.PositionTolerance && stats.NormalError <= options.NormalTolerance &&
+        stats.TexCoordError <= options.TexCoordTolerance;
+    if (stats.Compact)
+    {
+        mesh.Format = VERTEX_FORMAT_COMPACT;
+        mesh.PositionScale = scale;
+        mesh.PositionOffset = lower;
+    }
+    return stats;
+}
+
+unsigned int VertexStride(unsigned int format)
+{
+    return format == VERTEX_FORMAT_COMPACT ? sizeof(CompactVertex) : sizeof(MeshVertex);
+}
+
+void PackVertices(const MeshData &mesh, std::vector<unsigned char> &packed)
+{
+    packed.resize(mesh.Vertices.size() * VertexStride(mesh.Format));
+    if (mesh.Vertices.empty())
+        return;
+    if (mesh.Format != VERTEX_FORMAT_COMPACT)
+    {
+        memcpy(&packed[0], &mesh.Vertices[0], packed.size());
+        return;
+    }
+    CompactVertex *compact = (CompactVertex*)&packed[0];
+    for (size_t i = 0; i < mesh.Vertices.size(); ++i)
+        encodeVertex(mesh.Vertices[i], mesh.PositionScale, mesh.PositionOffset, compact[i]);
+}
+
+unsigned short FloatToHalf(float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    unsigned int sign = (bits >> 16) & 0x8000;
+    int exponent = (int)((bits >> 23) & 0xFF);
+    unsigned int mantissa = bits & 0x7FFFFF;
+    if (exponent == 255) // infinity or NaN
+        return (unsigned short)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    exponent = exponent - 127 + 15;
+    if (exponent >= 31)
+        return (unsigned short)(sign | 0x7C00);
+    unsigned int half, remainder, halfway;
+    if (exponent <= 0)
+    {
+        // denormal half (or zero)
+        if (exponent < -10)
+            return (unsigned short)sign;
+        mantissa |= 0x800000;
+        unsigned int shift = (unsigned int)(14 - exponent);
+        half = mantissa >> shift;
+        remainder = mantissa & ((1u << shift) - 1);
+        halfway = 1u << (shift - 1);
+    }
+    else
+    {
+        half = ((unsigned int)exponent << 10) | (mantissa >> 13);
+        remainder = mantissa & 0x1FFF;
+        halfway = 0x1000;
+    }
+    // round to nearest even, a carry into the exponent is still correct
+    if (remainder > halfway || (remainder == halfway && (half & 1)))
+        half++;
+    return (unsigned short)(sign | half);
+}
+
+float HalfToFloat(unsigned short value)
+{
+    unsigned int sign = (unsigned int)(value & 0x8000) << 16;
+    unsigned int exponent = (value >> 10) & 0x1F;
+    unsigned int mantissa = value & 0x3FF;
+    if (exponent == 0)
+    {
+        float magnitude = ldexpf((float)mantissa, -24);
+        return sign ? -magnitude : magnitude;
+    }
+    unsigned int bits = exponent == 31 ? sign | 0x7F800000 | (mantissa << 13) : sign | ((exponent + 112) << 23) | (mantissa << 13);
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
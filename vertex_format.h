@@ -0,0 +1,51 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <cstddef>
+#include <vector>
+
+#include "model_data.h"
+
+// 16 byte vertex read by car.vs through the same attribute locations as MeshVertex:
+//   location 0: positions, unsigned 16-bit normalized within the mesh bounds
+//   location 1: normals, signed normalized GL_INT_2_10_10_10_REV (w unused)
+//   location 2: texture coordinates, half floats
+struct CompactVertex
+{
+    unsigned short Position[3];
+    unsigned short Padding;  // Keeps the normal 4 byte aligned
+    unsigned int Normal;
+    unsigned short TexCoords[2];
+};
+
+// Largest errors the compact format may introduce for a mesh to use it
+struct QuantizationOptions
+{
+    float PositionTolerance; // Relative to the largest extent of the mesh bounds
+    float NormalTolerance;   // Degrees
+    float TexCoordTolerance; // Texture space units
+    QuantizationOptions() : PositionTolerance(1e-4f), NormalTolerance(0.5f), TexCoordTolerance(1.0f / 2048.0f) { }
+};
+
+// Largest errors measured by decoding the compact vertices again
+struct QuantizationStats
+{
+    float PositionError;     // Model space units
+    float PositionRelative;  // PositionError relative to the largest extent of the bounds
+    float NormalError;       // Degrees
+    float TexCoordError;
+    bool Compact;            // Whether all errors were within tolerance and the mesh was switched
+};
+
+// Measures the error of the compact format on mesh and switches mesh.Format to
+// VERTEX_FORMAT_COMPACT (setting PositionScale/PositionOffset) if it is within tolerance.
+QuantizationStats QuantizeMesh(MeshData &mesh, const QuantizationOptions &options);
+// Bytes per vertex of format
+unsigned int VertexStride(unsigned int format);
+// Writes the vertices of mesh in mesh.Format into packed
+void PackVertices(const MeshData &mesh, std::vector<unsigned char> &packed);
+// IEEE half float conversion (round to nearest even, no denormal flushing)
+unsigned short FloatToHalf(float value);
+float HalfToFloat(unsigned short value);
+
+#endif